@@ -15,13 +15,14 @@
 from .annoylib import *
 
 class AnnoyIndex(Annoy):
-    def __init__(self, f, K, file_dir, r,  max_reader, max_size,  read_only, metric='angular'):
+    def __init__(self, f, K, file_dir, r,  max_reader, max_size,  read_only, metric='angular', shards=1):
         """
         :param metric: 'angular' or 'euclidean'
+        :param shards: number of environments the items are partitioned over
         """
         self.f = f
         
-        super(AnnoyIndex, self).__init__(f, K, file_dir, r, max_reader, max_size, read_only, metric)
+        super(AnnoyIndex, self).__init__(f, K, file_dir, r, max_reader, max_size, read_only, metric, shards)
 
     def check_list(self, vector):
         if type(vector) != list:
@@ -35,6 +35,10 @@ with codecs.open('README.rst', encoding='utf-8') as fobj:
     long_description = readme_note + fobj.read()
 
 
+# src/protobuf/annoy.pb.{h,cc} were generated by protoc 3.21 and need the
+# protobuf C++ library 3.21 or newer; to build against another version,
+# regenerate them first with: protoc --cpp_out=src protobuf/annoy.proto
+
 setup(name='annoy',
       version='2.0.0',
       description='Approximate Nearest Neighbors in C++/Python optimized for memory usage and loading/saving to disk.',
@@ -42,8 +46,8 @@ setup(name='annoy',
       ext_modules=[
         Extension(
             'annoy.annoylib', ['src/annoymodule.cc',  'src/protobuf/annoy.pb.cc'],
-            depends=['src/annoylib.h', 'src/lmdbforest.h', 'src/protobuf/annoy.pb.h'],
-            include_dirs=['src', '/usr/loca/include', '/opt/local/include', '/usr/local/Cellar/protobuf/2.6.0/include/'],
+            depends=['src/annoylib.h', 'src/lmdbforest.h', 'src/pq.h', 'src/annoyrpc.h', 'src/protobuf/annoy.pb.h'],
+            include_dirs=['src', '/usr/loca/include', '/opt/local/include'],
             extra_compile_args=['-O3', '-march=native', '-std=c++11', '-ffast-math'],
             libraries = ["lmdb", "protobuf"]
         )
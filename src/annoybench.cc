@@ -0,0 +1,500 @@
+// Copyright (c) 2013 Spotify AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+// Microbenchmarks of the kernels, the node decoding and the LMDB reads and
+// writes of an angular index, printed as one JSON document on stdout so runs
+// can be compared:
+//
+//   {"context": {...}, "benchmarks": [{"name": ..., <parameters>, "ns_per_op": ..., "iterations": ...}, ...]}
+//
+//   annoy_bench [-d work_dir] [-f dim] [-n items] [-t trees] [-K leaf_size] [-T min_seconds]
+//
+// The LMDB cases build their index under work_dir (a fresh temporary
+// directory by default, removed at the end). The cold reads drop the pages
+// of data.mdb from the page cache first, which only works while no other
+// process maps them.
+//
+// Build from the repository root with make annoy_bench, into build/native.
+
+#include "annoylib.h"
+#include "kissrandom.h"
+#include <sys/stat.h>
+#include <fcntl.h>
+
+typedef AnnoyIndex<int32_t, float, Angular, Kiss64Random> Index;
+typedef Angular<int32_t, float, Kiss64Random> D;
+
+static volatile float sink; // keeps results alive
+
+struct result {
+  string name;
+  vector<pair<string, string> > params;
+  double ns_per_op;
+  size_t iterations;
+};
+
+static vector<result> results;
+
+static string param(long v) {
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%ld", v);
+  return buf;
+}
+
+static string param(const char* v) {
+  return string("\"") + v + "\"";
+}
+
+static void report(const char* name, const vector<pair<string, string> >& params, double ns, size_t iterations) {
+  result r;
+  r.name = name;
+  r.params = params;
+  r.ns_per_op = ns;
+  r.iterations = iterations;
+  results.push_back(r);
+  fprintf(stderr, "%-28s", name);
+  for (size_t i = 0; i < params.size(); i++) {
+    fprintf(stderr, " %s=%s", params[i].first.c_str(), params[i].second.c_str());
+  }
+  fprintf(stderr, " %.1f ns/op\n", ns);
+}
+
+static double seconds_since(std::chrono::steady_clock::time_point t0) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// ns per call of body(i), doubling the calls until a run takes min_seconds
+template<typename Body>
+static double measure(double min_seconds, size_t* iterations, Body body) {
+  size_t n = 1;
+  while (true) {
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < n; i++) {
+      body(i);
+    }
+    double s = seconds_since(t0);
+    if (s >= min_seconds) {
+      *iterations = n;
+      return s * 1e9 / n;
+    }
+    n = s > 0 ? std::max(n * 2, (size_t) (n * min_seconds / s * 1.2)) : n * 16;
+  }
+}
+
+static void random_vectors(Kiss64Random& random, size_t n, int f, vector<float>* out) {
+  out->resize(n * f);
+  for (size_t i = 0; i < out->size(); i++) {
+    (*out)[i] = (float) random.kiss() / 4294967296.0f - 0.5f;
+  }
+}
+
+// Reads the packed repeated float field of a serialized message where it
+// lies, without parsing the message: the count values start at the
+// returned pointer, NULL when the field is missing.
+static const float* packed_floats(const uint8_t* p, size_t size, int field, int* count) {
+  const uint8_t* end = p + size;
+  while (p < end) {
+    uint64_t key = 0;
+    for (int shift = 0; p < end; shift += 7) {
+      key |= (uint64_t) (*p & 0x7f) << shift;
+      if (!(*p++ & 0x80)) {
+        break;
+      }
+    }
+    uint64_t len = 0;
+    switch (key & 7) {
+      case 0:
+        while (p < end && (*p++ & 0x80)) {}
+        break;
+      case 1:
+        p += 8;
+        break;
+      case 5:
+        p += 4;
+        break;
+      case 2:
+        for (int shift = 0; p < end; shift += 7) {
+          len |= (uint64_t) (*p & 0x7f) << shift;
+          if (!(*p++ & 0x80)) {
+            break;
+          }
+        }
+        if ((int) (key >> 3) == field) {
+          *count = len / sizeof(float);
+          return (const float*) p;
+        }
+        p += len;
+        break;
+      default:
+        return NULL;
+    }
+  }
+  return NULL;
+}
+
+static void bench_kernels(double min_seconds) {
+  static const int dims[] = {16, 32, 64, 128, 256, 512, 1024};
+  Kiss64Random random;
+  for (size_t d = 0; d < sizeof(dims) / sizeof(dims[0]); d++) {
+    int f = dims[d];
+    const size_t pool = 256; // several vectors so the loads are not hoisted
+    vector<float> x, y;
+    random_vectors(random, pool, f, &x);
+    random_vectors(random, pool, f, &y);
+    vector<pair<string, string> > params(1, make_pair(string("dim"), param(f)));
+    size_t iterations;
+    double ns = measure(min_seconds, &iterations, [&](size_t i) {
+      size_t k = i % pool;
+      sink += D::distance(&x[k * f], &y[(k * 7) % pool * f], f);
+    });
+    report("angular_distance", params, ns, iterations);
+
+    tree_node tn;
+    tn.set_index(0);
+    tn.set_leaf(false);
+    for (int z = 0; z < f; z++) {
+      tn.add_v(x[z]);
+    }
+    ns = measure(min_seconds, &iterations, [&](size_t i) {
+      sink += D::margin(tn, &y[i % pool * f], f);
+    });
+    report("angular_margin_tree_node", params, ns, iterations);
+
+    vector<char> buf(sizeof(D::Node) + f * sizeof(float));
+    D::Node* node = (D::Node*) &buf[0];
+    memcpy(node->v, &x[0], f * sizeof(float));
+    ns = measure(min_seconds, &iterations, [&](size_t i) {
+      sink += D::margin(node, &y[i % pool * f], f);
+    });
+    report("angular_margin_raw", params, ns, iterations);
+  }
+}
+
+static void bench_decode(int f, int K, double min_seconds) {
+  Kiss64Random random;
+  vector<float> x, q;
+  random_vectors(random, 1, f, &x);
+  random_vectors(random, 1, f, &q);
+  vector<pair<string, string> > params(1, make_pair(string("dim"), param(f)));
+  size_t iterations;
+  double ns;
+
+  // a split node: parse it, then take its margin, as a descent does
+  tree_node split;
+  split.set_index(1);
+  split.set_leaf(false);
+  split.set_left(2);
+  split.set_right(3);
+  for (int z = 0; z < f; z++) {
+    split.add_v(x[z]);
+  }
+  string bytes;
+  split.SerializeToString(&bytes);
+  tree_node tn;
+  ns = measure(min_seconds, &iterations, [&](size_t) {
+    string copy(bytes.data(), bytes.size());
+    tn.ParseFromString(copy);
+    sink += D::margin(tn, &q[0], f);
+  });
+  report("tree_node_parse_string", params, ns, iterations);
+  ns = measure(min_seconds, &iterations, [&](size_t) {
+    tn.ParseFromArray(bytes.data(), bytes.size());
+    sink += D::margin(tn, &q[0], f);
+  });
+  report("tree_node_parse_array", params, ns, iterations);
+  ns = measure(min_seconds, &iterations, [&](size_t) {
+    int count;
+    const float* v = packed_floats((const uint8_t*) bytes.data(), bytes.size(), 6, &count);
+    float dot = 0;
+    for (int z = 0; z < count; z++) {
+      dot += v[z] * q[z];
+    }
+    sink += dot;
+  });
+  report("tree_node_in_place", params, ns, iterations);
+
+  // a full leaf: parse its item list
+  tree_node leaf;
+  leaf.set_index(2);
+  leaf.set_leaf(true);
+  for (int k = 0; k < K; k++) {
+    leaf.add_items(random.index(1 << 24));
+  }
+  leaf.SerializeToString(&bytes);
+  vector<pair<string, string> > leaf_params(1, make_pair(string("items"), param(K)));
+  ns = measure(min_seconds, &iterations, [&](size_t) {
+    tn.ParseFromArray(bytes.data(), bytes.size());
+    sink += tn.items(tn.items_size() - 1);
+  });
+  report("tree_node_parse_leaf", leaf_params, ns, iterations);
+
+  // an item vector: parse it, then take its distance to the query
+  data_info di;
+  for (int z = 0; z < f; z++) {
+    di.add_data(x[z]);
+  }
+  di.set_id(12345);
+  di.SerializeToString(&bytes);
+  data_info parsed;
+  ns = measure(min_seconds, &iterations, [&](size_t) {
+    parsed.ParseFromArray(bytes.data(), bytes.size());
+    sink += D::distance(&q[0], parsed, f);
+  });
+  report("data_info_parse", params, ns, iterations);
+  ns = measure(min_seconds, &iterations, [&](size_t) {
+    int count;
+    const float* v = packed_floats((const uint8_t*) bytes.data(), bytes.size(), 1, &count);
+    sink += D::distance(&q[0], v, f);
+  });
+  report("data_info_in_place", params, ns, iterations);
+}
+
+static void bench_split(int f, int K, double min_seconds) {
+  Kiss64Random random;
+  SplitArena<float> arena;
+  random_vectors(random, K, f, &arena.points);
+  tree_node tn;
+  tn.set_index(0);
+  tn.set_leaf(true);
+  for (int k = 0; k < K; k++) {
+    tn.add_items(k);
+  }
+  tree_node new_node, left, right;
+  vector<pair<string, string> > params;
+  params.push_back(make_pair(string("dim"), param(f)));
+  params.push_back(make_pair(string("items"), param(K)));
+  size_t iterations;
+  double ns = measure(min_seconds, &iterations, [&](size_t) {
+    new_node.Clear();
+    left.Clear();
+    right.Clear();
+    D::split(tn, new_node, left, right, random, f, arena);
+    sink += left.items_size();
+  });
+  report("angular_split", params, ns, iterations);
+}
+
+// exposes the record readers of a read only index
+struct Probe : public Index {
+  Probe(int f, int K, int trees, const char* dir) : Index(f, K, trees, dir, 126, 0, 1) {}
+
+  void begin() {
+    _begin_txn(MDB_RDONLY, &_txn);
+    E(mdb_dbi_open(_txn, DBN_RAW, MDB_INTEGERKEY, &_dbi_raw));
+    _open_trees(0);
+  }
+
+  void end() {
+    mdb_txn_abort(_txn);
+  }
+
+  // the keys of the nodes of tree 0
+  void node_keys(vector<int>* keys) {
+    vector<int> stack(1, _roots[0]);
+    while (!stack.empty()) {
+      int index = stack.back();
+      stack.pop_back();
+      tree_node tn;
+      if (!_get_node_by_index(index, tn, 0)) {
+        continue;
+      }
+      keys->push_back(index);
+      if (!tn.leaf()) {
+        stack.push_back(tn.left());
+        stack.push_back(tn.right());
+      }
+    }
+  }
+
+  bool node(int index, tree_node& tn) { return _get_node_by_index(index, tn, 0); }
+  bool raw(int id, data_info& d) { return _get_raw_data(id, d); }
+};
+
+static void drop_cache(const string& dir) {
+  string path = dir + "/data.mdb";
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd >= 0) {
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+  }
+}
+
+static void remove_env(const string& dir) {
+  unlink((dir + "/data.mdb").c_str());
+  unlink((dir + "/lock.mdb").c_str());
+  rmdir(dir.c_str());
+}
+
+static void bench_lmdb(const string& work, int f, int K, int trees, size_t n, double min_seconds) {
+  Kiss64Random random;
+  vector<float> data;
+  random_vectors(random, n, f, &data);
+  vector<int32_t> ids(n);
+  vector<float*> rows(n);
+  for (size_t i = 0; i < n; i++) {
+    ids[i] = i;
+    rows[i] = &data[i * f];
+  }
+  vector<pair<string, string> > params;
+  params.push_back(make_pair(string("dim"), param(f)));
+  params.push_back(make_pair(string("items"), param(n)));
+  params.push_back(make_pair(string("trees"), param(trees)));
+  params.push_back(make_pair(string("durability"), param("nosync")));
+
+  // inserts, one transaction per item against one per batch
+  string single = work + "/single", batch = work + "/batch";
+  mkdir(single.c_str(), 0755);
+  mkdir(batch.c_str(), 0755);
+  {
+    Index index(f, K, trees, single.c_str(), 126, 1 << 30, 0);
+    index.set_durability(DURABILITY_NOSYNC);
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < n; i++) {
+      index.add_item(ids[i], rows[i]);
+    }
+    report("insert_single", params, seconds_since(t0) * 1e9 / n, n);
+  }
+  {
+    const size_t batch_size = 1000;
+    Index index(f, K, trees, batch.c_str(), 126, 1 << 30, 0);
+    index.set_durability(DURABILITY_NOSYNC);
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < n; i += batch_size) {
+      index.add_item_batch(&ids[i], std::min(batch_size, n - i), &rows[i]);
+    }
+    vector<pair<string, string> > batch_params = params;
+    batch_params.push_back(make_pair(string("batch"), param(batch_size)));
+    report("insert_batch", batch_params, seconds_since(t0) * 1e9 / n, n);
+    index.flush();
+  }
+  remove_env(single);
+
+  // reads in random key order, first right after the pages were dropped
+  // from the page cache, then again once they are resident
+  vector<pair<string, string> > read_params(params.begin(), params.end() - 1);
+  vector<int> keys;
+  {
+    Probe probe(f, K, trees, batch.c_str());
+    probe.begin();
+    probe.node_keys(&keys);
+    probe.end();
+  }
+  for (size_t i = 0; i + 1 < keys.size(); i++) {
+    std::swap(keys[i], keys[i + random.index(keys.size() - i)]);
+  }
+  vector<int> items(ids.begin(), ids.end());
+  for (size_t i = 0; i + 1 < items.size(); i++) {
+    std::swap(items[i], items[i + random.index(items.size() - i)]);
+  }
+
+  drop_cache(batch);
+  {
+    Probe probe(f, K, trees, batch.c_str());
+    probe.begin();
+    tree_node tn;
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < keys.size(); i++) {
+      sink += probe.node(keys[i], tn);
+    }
+    report("get_node_by_index_cold", read_params, seconds_since(t0) * 1e9 / keys.size(), keys.size());
+    size_t iterations;
+    double ns = measure(min_seconds, &iterations, [&](size_t i) {
+      sink += probe.node(keys[i % keys.size()], tn);
+    });
+    report("get_node_by_index_hot", read_params, ns, iterations);
+    probe.end();
+  }
+
+  drop_cache(batch);
+  {
+    Probe probe(f, K, trees, batch.c_str());
+    probe.begin();
+    data_info di;
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < items.size(); i++) {
+      sink += probe.raw(items[i], di);
+    }
+    report("get_raw_data_cold", read_params, seconds_since(t0) * 1e9 / items.size(), items.size());
+    size_t iterations;
+    double ns = measure(min_seconds, &iterations, [&](size_t i) {
+      sink += probe.raw(items[i % items.size()], di);
+    });
+    report("get_raw_data_hot", read_params, ns, iterations);
+    probe.end();
+  }
+  remove_env(batch);
+}
+
+static void usage() {
+  fprintf(stderr, "usage: annoy_bench [-d work_dir] [-f dim] [-n items] [-t trees] [-K leaf_size] [-T min_seconds]\n");
+  exit(1);
+}
+
+int main(int argc, char** argv) {
+  const char* dir = NULL;
+  int f = 128, trees = 4, K = 64;
+  size_t n = 20000;
+  double min_seconds = 0.2;
+  int opt;
+  while ((opt = getopt(argc, argv, "d:f:n:t:K:T:")) != -1) {
+    switch (opt) {
+      case 'd': dir = optarg; break;
+      case 'f': f = atoi(optarg); break;
+      case 'n': n = atol(optarg); break;
+      case 't': trees = atoi(optarg); break;
+      case 'K': K = atoi(optarg); break;
+      case 'T': min_seconds = atof(optarg); break;
+      default: usage();
+    }
+  }
+  if (f <= 0 || n < 2 || trees <= 0 || K < 2 || min_seconds <= 0) {
+    usage();
+  }
+  char tmp[] = "/tmp/annoy_bench.XXXXXX";
+  string work;
+  if (dir != NULL) {
+    work = dir;
+    mkdir(dir, 0755);
+  } else if (mkdtemp(tmp) != NULL) {
+    work = tmp;
+  } else {
+    fprintf(stderr, "can not create a work directory: %s\n", strerror(errno));
+    return 1;
+  }
+
+  bench_kernels(min_seconds);
+  bench_decode(f, K, min_seconds);
+  bench_split(f, K, min_seconds);
+  bench_lmdb(work, f, K, trees, n, min_seconds);
+  if (dir == NULL) {
+    rmdir(work.c_str());
+  }
+
+  printf("{\n  \"context\": {\"dim\": %d, \"items\": %zu, \"trees\": %d, \"leaf_size\": %d, \"min_seconds\": %g},\n",
+    f, n, trees, K, min_seconds);
+  printf("  \"benchmarks\": [\n");
+  for (size_t i = 0; i < results.size(); i++) {
+    const result& r = results[i];
+    printf("    {\"name\": \"%s\"", r.name.c_str());
+    for (size_t j = 0; j < r.params.size(); j++) {
+      printf(", \"%s\": %s", r.params[j].first.c_str(), r.params[j].second.c_str());
+    }
+    printf(", \"ns_per_op\": %.2f, \"iterations\": %zu}%s\n", r.ns_per_op, r.iterations,
+      i + 1 < results.size() ? "," : "");
+  }
+  printf("  ]\n}\n");
+  return 0;
+}
+
+// vim: tabstop=2 shiftwidth=2
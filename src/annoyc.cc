@@ -0,0 +1,221 @@
+// Copyright (c) 2013 Spotify AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include <new>
+#include "annoyc.h"
+
+// a failed CHECK unwinds to the C entry point instead of aborting
+struct annoy_failure {
+  int rc;
+  annoy_failure(int r) : rc(r) {}
+};
+#define ANNOY_FAIL(rc) throw annoy_failure(rc)
+
+#include "annoylib.h"
+#include "kissrandom.h"
+
+struct annoy_index {
+  AnnoyIndexInterface<int32_t, float>* ptr;
+  int f;
+  bool read_only;
+  bool failed;
+};
+
+// runs call, turning what it throws into an error code
+template<typename Call>
+static int guard(annoy_index* index, Call call) {
+  if (index->failed) {
+    return ANNOY_EFAILED;
+  }
+  try {
+    call();
+    return ANNOY_OK;
+  } catch (const annoy_failure& e) {
+    index->failed = true;
+    return e.rc != MDB_SUCCESS ? e.rc : ANNOY_EUNKNOWN;
+  } catch (const std::bad_alloc&) {
+    return ANNOY_ENOMEM;
+  } catch (...) {
+    return ANNOY_EUNKNOWN;
+  }
+}
+
+// scratch results, so queries do not allocate once a thread is warm
+static thread_local vector<int32_t> scratch_ids;
+static thread_local vector<float> scratch_distances;
+static thread_local vector<float> scratch_item;
+
+static int query(annoy_index* index, const float* v, size_t n, int search_k,
+  int32_t* ids, float* distances, size_t* found) {
+  scratch_ids.clear();
+  scratch_distances.clear();
+  int err = guard(index, [&]() {
+    index->ptr->get_nns_by_vector(v, n, (size_t) search_k, &scratch_ids, distances ? &scratch_distances : NULL);
+  });
+  if (err != ANNOY_OK) {
+    return err;
+  }
+  size_t m = std::min(n, scratch_ids.size());
+  std::copy(scratch_ids.begin(), scratch_ids.begin() + m, ids);
+  if (distances) {
+    std::copy(scratch_distances.begin(), scratch_distances.begin() + m, distances);
+  }
+  *found = m;
+  return ANNOY_OK;
+}
+
+extern "C" {
+
+int annoy_open(int f, int K, int trees, const char* dir, int maxreaders,
+  uint64_t maxsize, int read_only, annoy_index** index) {
+  if (f <= 0 || K <= 0 || trees <= 0 || dir == NULL || index == NULL) {
+    return ANNOY_EINVAL;
+  }
+  annoy_index* a = new (std::nothrow) annoy_index();
+  if (a == NULL) {
+    return ANNOY_ENOMEM;
+  }
+  a->ptr = NULL;
+  a->f = f;
+  a->read_only = (read_only == 1);
+  a->failed = false;
+  int err = guard(a, [&]() {
+    a->ptr = new AnnoyIndex<int32_t, float, Angular, Kiss64Random>(f, K, trees, dir, maxreaders,
+      maxsize, read_only);
+  });
+  if (err != ANNOY_OK) {
+    delete a;
+    return err;
+  }
+  *index = a;
+  return ANNOY_OK;
+}
+
+void annoy_close(annoy_index* index) {
+  if (index == NULL) {
+    return;
+  }
+  try {
+    delete index->ptr;
+  } catch (...) {
+  }
+  delete index;
+}
+
+int annoy_add_item(annoy_index* index, int32_t item, const float* v) {
+  if (index == NULL || v == NULL || item < 0) {
+    return ANNOY_EINVAL;
+  }
+  if (index->read_only) {
+    return ANNOY_EREADONLY;
+  }
+  return guard(index, [&]() {
+    index->ptr->add_item(item, v);
+  });
+}
+
+int annoy_add_items(annoy_index* index, const int32_t* items, const float* vectors, size_t count) {
+  if (index == NULL || (count > 0 && (items == NULL || vectors == NULL))) {
+    return ANNOY_EINVAL;
+  }
+  if (index->read_only) {
+    return ANNOY_EREADONLY;
+  }
+  for (size_t i = 0; i < count; i++) {
+    if (items[i] < 0) {
+      return ANNOY_EINVAL;
+    }
+  }
+  if (count == 0) {
+    return ANNOY_OK;
+  }
+  return guard(index, [&]() {
+    vector<float*> rows(count);
+    for (size_t i = 0; i < count; i++) {
+      rows[i] = const_cast<float*>(vectors + i * index->f);
+    }
+    index->ptr->add_item_batch(const_cast<int32_t*>(items), count, &rows[0]);
+  });
+}
+
+int annoy_get_nns_by_vector(annoy_index* index, const float* v, size_t n, int search_k,
+  int32_t* ids, float* distances, size_t* found) {
+  if (index == NULL || v == NULL || ids == NULL || found == NULL) {
+    return ANNOY_EINVAL;
+  }
+  *found = 0;
+  return query(index, v, n, search_k, ids, distances, found);
+}
+
+int annoy_get_nns_by_vectors(annoy_index* index, const float* vectors, size_t count, size_t n,
+  int search_k, int32_t* ids, float* distances, size_t* found) {
+  if (index == NULL || (count > 0 && (vectors == NULL || ids == NULL || found == NULL))) {
+    return ANNOY_EINVAL;
+  }
+  for (size_t i = 0; i < count; i++) {
+    found[i] = ANNOY_UNANSWERED;
+  }
+  for (size_t i = 0; i < count; i++) {
+    int err = query(index, vectors + i * index->f, n, search_k, ids + i * n,
+      distances ? distances + i * n : NULL, &found[i]);
+    if (err != ANNOY_OK) {
+      return err;
+    }
+  }
+  return ANNOY_OK;
+}
+
+int annoy_get_item(annoy_index* index, int32_t item, float* v) {
+  if (index == NULL || v == NULL) {
+    return ANNOY_EINVAL;
+  }
+  scratch_item.clear();
+  int err = guard(index, [&]() {
+    index->ptr->get_item(item, &scratch_item);
+  });
+  if (err != ANNOY_OK) {
+    return err;
+  }
+  if (scratch_item.size() != (size_t) index->f) {
+    return ANNOY_ENOTFOUND;
+  }
+  std::copy(scratch_item.begin(), scratch_item.end(), v);
+  return ANNOY_OK;
+}
+
+int annoy_get_n_items(annoy_index* index, int32_t* n) {
+  if (index == NULL || n == NULL) {
+    return ANNOY_EINVAL;
+  }
+  return guard(index, [&]() {
+    *n = index->ptr->get_n_items();
+  });
+}
+
+const char* annoy_strerror(int error) {
+  switch (error) {
+    case ANNOY_OK: return "success";
+    case ANNOY_EINVAL: return "invalid argument";
+    case ANNOY_ENOTFOUND: return "no such item";
+    case ANNOY_EREADONLY: return "index is read only";
+    case ANNOY_ENOMEM: return "out of memory";
+    case ANNOY_EFAILED: return "index failed earlier, close it";
+    case ANNOY_EUNKNOWN: return "unknown error";
+  }
+  return mdb_strerror(error);
+}
+
+}
+
+// vim: tabstop=2 shiftwidth=2
@@ -0,0 +1,98 @@
+// Copyright (c) 2013 Spotify AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#ifndef ANNOYC_H
+#define ANNOYC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ C interface to an angular index of int32 items and float vectors, for
+ embedding from runtimes that can call C but not C++.
+
+ 1. Every call but annoy_close returns ANNOY_OK or an error. The errors
+ below are negative; any other value is the LMDB or system error the
+ storage failed with. annoy_strerror describes both.
+
+ 2. After a storage error the index may hold a transaction open, so it
+ refuses everything but annoy_close from then on (ANNOY_EFAILED).
+
+ 3. Results go to buffers the caller owns, the index keeps no pointer to
+ them after the call returns.
+
+ 4. An index may be shared by threads, its calls are serialized.
+
+ Build as a shared library from the repository root with make libannoy,
+ into build/native/libannoy.so.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ANNOY_OK 0
+#define ANNOY_EINVAL (-1)    // a bad argument
+#define ANNOY_ENOTFOUND (-2) // no such item
+#define ANNOY_EREADONLY (-3) // a write to an index opened read only
+#define ANNOY_ENOMEM (-4)
+#define ANNOY_EFAILED (-5)   // an earlier call failed in the storage
+#define ANNOY_EUNKNOWN (-6)
+
+// found[i] of a query annoy_get_nns_by_vectors did not answer
+#define ANNOY_UNANSWERED ((size_t) -1)
+
+typedef struct annoy_index annoy_index;
+
+// opens the index in dir, the arguments are those of the AnnoyIndex
+// constructor; *index is set on success only
+int annoy_open(int f, int K, int trees, const char* dir, int maxreaders,
+  uint64_t maxsize, int read_only, annoy_index** index);
+
+// closes the index and frees it, NULL is ignored
+void annoy_close(annoy_index* index);
+
+// v holds f floats
+int annoy_add_item(annoy_index* index, int32_t item, const float* v);
+
+// adds count items in one transaction, vectors holds count rows of f floats
+int annoy_add_items(annoy_index* index, const int32_t* items, const float* vectors, size_t count);
+
+// the n nearest items of v, search_k -1 for the default. ids and distances
+// (which may be NULL) have room for n values; *found is set to how many
+// were written.
+int annoy_get_nns_by_vector(annoy_index* index, const float* v, size_t n, int search_k,
+  int32_t* ids, float* distances, size_t* found);
+
+// count queries at once, vectors holds count rows of f floats. The results
+// of query i go to row i of ids and distances, n values each, and found[i]
+// is set to how many were written. On an error the queries before the one
+// that failed keep their results, and found[i] is ANNOY_UNANSWERED from the
+// failed one on.
+int annoy_get_nns_by_vectors(annoy_index* index, const float* vectors, size_t count, size_t n,
+  int search_k, int32_t* ids, float* distances, size_t* found);
+
+// copies the vector of item to v, which has room for f floats
+int annoy_get_item(annoy_index* index, int32_t item, float* v);
+
+int annoy_get_n_items(annoy_index* index, int32_t* n);
+
+const char* annoy_strerror(int error);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+// vim: tabstop=2 shiftwidth=2
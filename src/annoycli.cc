@@ -0,0 +1,428 @@
+// Copyright (c) 2013 Spotify AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+// Command line tool to build, query and measure an angular index without
+// going through Python.
+//
+//   annoy ingest -d dir -t trees [-K leaf_size] [-f dim] [-s first_id] [-b batch] [-m map_size] vectors
+//   annoy query  -d dir -t trees [-K leaf_size] [-f dim] [-n count] [-k search_k] [-D] queries
+//   annoy stats  -d dir -t trees -f dim [-K leaf_size]
+//   annoy bench  -d dir -t trees [-K leaf_size] [-f dim] [-n count] [-k search_k] [-w threads]
+//                [-W warm_levels] (-g truth.ivecs | -B base_vectors) queries
+//
+// Vector files are mapped, not read: .fvecs and .ivecs (each row an int32
+// dimension then the values), .npy (float32 or int32, C order, 2-d), and
+// anything else is raw float32 rows of -f values. ingest gives row i the id
+// first_id + i.
+//
+// Build from the repository root with make annoy, into build/native.
+
+#include "annoylib.h"
+#include "kissrandom.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <atomic>
+
+typedef AnnoyIndex<int32_t, float, Angular, Kiss64Random> Index;
+
+// a file of rows of 4 byte values, mapped read only
+struct vector_file {
+  void* map;
+  size_t map_size;
+  const char* base; // first row
+  size_t stride;    // bytes from a row to the next
+  size_t n;
+  int f;
+
+  vector_file() : map(NULL), map_size(0), base(NULL), stride(0), n(0), f(0) {}
+
+  ~vector_file() {
+    if (map != NULL) {
+      munmap(map, map_size);
+    }
+  }
+
+  const float* row(size_t i) const { return (const float*) (base + i * stride); }
+  const int32_t* int_row(size_t i) const { return (const int32_t*) (base + i * stride); }
+
+  // f is the dimension of raw files, the others carry their own;
+  // dtype is the .npy type expected, "<f4" or "<i4"
+  bool open(const char* path, int raw_f, const char* dtype) {
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+      fprintf(stderr, "can not open %s: %s\n", path, strerror(errno));
+      return false;
+    }
+    struct stat st;
+    fstat(fd, &st);
+    map_size = st.st_size;
+    map = map_size > 0 ? mmap(NULL, map_size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (map == MAP_FAILED) {
+      map = NULL;
+      fprintf(stderr, "can not map %s\n", path);
+      return false;
+    }
+    madvise(map, map_size, MADV_SEQUENTIAL);
+    const char* data = (const char*) map;
+
+    string p(path);
+    string ext = p.find('.') == string::npos ? "" : p.substr(p.rfind('.'));
+    if (ext == ".fvecs" || ext == ".ivecs") {
+      if (map_size < sizeof(int32_t)) {
+        return _bad(path);
+      }
+      memcpy(&f, data, sizeof(int32_t));
+      stride = sizeof(int32_t) * (f + 1);
+      base = data + sizeof(int32_t);
+      n = map_size / stride;
+    } else if (ext == ".npy") {
+      // magic, version, then the length of a dict giving the layout
+      if (map_size < 10 || memcmp(data, "\x93NUMPY", 6) != 0) {
+        return _bad(path);
+      }
+      size_t header_len, at;
+      if (data[6] == 1) {
+        uint16_t len;
+        memcpy(&len, data + 8, sizeof(len));
+        header_len = len;
+        at = 10;
+      } else {
+        uint32_t len;
+        memcpy(&len, data + 8, sizeof(len));
+        header_len = len;
+        at = 12;
+      }
+      if (at + header_len > map_size) {
+        return _bad(path);
+      }
+      string header(data + at, header_len);
+      size_t shape = header.find("'shape': (");
+      unsigned long rows = 0, cols = 0;
+      if (header.find(string("'descr': '") + dtype + "'") == string::npos
+          || header.find("'fortran_order': False") == string::npos
+          || shape == string::npos
+          || sscanf(header.c_str() + shape, "'shape': (%lu, %lu)", &rows, &cols) != 2) {
+        fprintf(stderr, "%s: want a 2-d C order %s array\n", path, dtype);
+        return false;
+      }
+      f = cols;
+      n = rows;
+      stride = sizeof(float) * f;
+      base = data + at + header_len;
+    } else {
+      if (raw_f <= 0) {
+        fprintf(stderr, "%s: give the dimension of a raw file with -f\n", path);
+        return false;
+      }
+      f = raw_f;
+      stride = sizeof(float) * f;
+      base = data;
+      n = map_size / stride;
+    }
+    if (f <= 0 || (n > 0 && base + (n - 1) * stride + sizeof(float) * f > data + map_size)) {
+      return _bad(path);
+    }
+    return true;
+  }
+
+  bool _bad(const char* path) {
+    fprintf(stderr, "%s: malformed\n", path);
+    return false;
+  }
+};
+
+static double seconds_since(std::chrono::steady_clock::time_point t0) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// runs body(i) for i in [0, n) on threads threads
+template<typename Body>
+static void parallel_for(size_t n, int threads, Body body) {
+  std::atomic<size_t> next(0);
+  vector<std::thread> pool;
+  for (int t = 0; t < threads; t++) {
+    pool.push_back(std::thread([&, t]() {
+      for (size_t i; (i = next++) < n; ) {
+        body(t, i);
+      }
+    }));
+  }
+  for (size_t t = 0; t < pool.size(); t++) {
+    pool[t].join();
+  }
+}
+
+struct options {
+  const char* dir;
+  int trees;
+  int K;
+  int f;
+  int32_t first_id;
+  size_t batch;
+  uint64_t map_size;
+  size_t n;
+  int search_k;
+  bool distances;
+  int threads;
+  int warm_levels;
+  const char* truth;
+  const char* base;
+  const char* file;
+};
+
+static void usage() {
+  fprintf(stderr,
+    "usage: annoy ingest -d dir -t trees [-K leaf_size] [-f dim] [-s first_id] [-b batch] [-m map_size] vectors\n"
+    "       annoy query  -d dir -t trees [-K leaf_size] [-f dim] [-n count] [-k search_k] [-D] queries\n"
+    "       annoy stats  -d dir -t trees -f dim [-K leaf_size]\n"
+    "       annoy bench  -d dir -t trees [-K leaf_size] [-f dim] [-n count] [-k search_k] [-w threads]\n"
+    "                    [-W warm_levels] (-g truth.ivecs | -B base_vectors) queries\n");
+  exit(1);
+}
+
+static int ingest(const options& o) {
+  vector_file in;
+  if (!in.open(o.file, o.f, "<f4")) {
+    return 1;
+  }
+  Index index(in.f, o.K, o.trees, o.dir, 126, o.map_size, 0);
+  // one sync at the end instead of one per batch
+  index.set_durability(DURABILITY_NOSYNC);
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  vector<int32_t> ids;
+  vector<float*> rows;
+  for (size_t i = 0; i < in.n; i += o.batch) {
+    size_t count = std::min(o.batch, in.n - i);
+    ids.resize(count);
+    rows.resize(count);
+    for (size_t j = 0; j < count; j++) {
+      ids[j] = o.first_id + (int32_t) (i + j);
+      rows[j] = const_cast<float*>(in.row(i + j));
+    }
+    index.add_item_batch(&ids[0], count, &rows[0]);
+    if ((i / o.batch) % 100 == 99) {
+      fprintf(stderr, "%zu items, %.0f items/s\n", i + count, (i + count) / seconds_since(t0));
+    }
+  }
+  index.flush();
+  index.set_durability(DURABILITY_SYNC);
+  double s = seconds_since(t0);
+  printf("ingested %zu items of %d dimensions in %.1fs, %.0f items/s\n", in.n, in.f, s, in.n / s);
+  return 0;
+}
+
+static int query(const options& o) {
+  vector_file q;
+  if (!q.open(o.file, o.f, "<f4")) {
+    return 1;
+  }
+  Index index(q.f, o.K, o.trees, o.dir, 126, 0, 1);
+  MDB_txn* reader = index.begin_reader();
+  vector<int32_t> result;
+  vector<float> distances;
+  for (size_t i = 0; i < q.n; i++) {
+    result.clear();
+    distances.clear();
+    index.get_nns_by_vector(reader, q.row(i), o.n, (size_t) o.search_k, &result, o.distances ? &distances : NULL);
+    for (size_t j = 0; j < result.size(); j++) {
+      if (o.distances) {
+        printf(j ? " %d:%g" : "%d:%g", result[j], distances[j]);
+      } else {
+        printf(j ? " %d" : "%d", result[j]);
+      }
+    }
+    printf("\n");
+  }
+  index.end_reader(reader);
+  return 0;
+}
+
+static int stats(const options& o) {
+  Index index(o.f, o.K, o.trees, o.dir, 126, 0, 1);
+  printf("items %d\n", index.get_n_items());
+  for (int t = 0; t < o.trees; t++) {
+    tree_stats s;
+    if (!index.get_tree_stats(t, &s)) {
+      continue;
+    }
+    printf("tree %d: nodes %zu leaves %zu empty_leaves %zu items %zu max_depth %d mean_depth %.2f\n",
+      t, s.nodes, s.leaves, s.empty_leaves, s.items, s.max_depth, s.mean_depth);
+  }
+  map_usage u;
+  index.get_map_usage(&u);
+  printf("map %zu bytes, %zu used, page %zu, readers %u of %u\n",
+    u.map_size, u.used_size, u.page_size, u.readers, u.max_readers);
+  return 0;
+}
+
+static int bench(const options& o) {
+  vector_file q;
+  if (!q.open(o.file, o.f, "<f4")) {
+    return 1;
+  }
+  if ((o.truth == NULL) == (o.base == NULL)) {
+    usage();
+  }
+
+  // the true n nearest of every query
+  vector<vector<int32_t> > truth(q.n);
+  if (o.truth != NULL) {
+    vector_file g;
+    if (!g.open(o.truth, 0, "<i4")) {
+      return 1;
+    }
+    if (g.n < q.n || (size_t) g.f < o.n) {
+      fprintf(stderr, "%s: want %zu rows of at least %zu ids\n", o.truth, q.n, o.n);
+      return 1;
+    }
+    for (size_t i = 0; i < q.n; i++) {
+      truth[i].assign(g.int_row(i), g.int_row(i) + o.n);
+    }
+  } else {
+    vector_file b;
+    if (!b.open(o.base, q.f, "<f4")) {
+      return 1;
+    }
+    if (b.f != q.f) {
+      fprintf(stderr, "%s has %d dimensions, the queries %d\n", o.base, b.f, q.f);
+      return 1;
+    }
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    parallel_for(q.n, o.threads, [&](int, size_t i) {
+      vector<pair<float, int32_t> > all(b.n);
+      for (size_t j = 0; j < b.n; j++) {
+        all[j] = make_pair(Angular<int32_t, float, Kiss64Random>::distance(q.row(i), b.row(j), q.f), (int32_t) j);
+      }
+      size_t m = std::min(o.n, all.size());
+      std::partial_sort(all.begin(), all.begin() + m, all.end());
+      for (size_t j = 0; j < m; j++) {
+        truth[i].push_back(all[j].second);
+      }
+    });
+    fprintf(stderr, "exact search %.1fs\n", seconds_since(t0));
+  }
+
+  Index index(q.f, o.K, o.trees, o.dir, std::max(126, o.threads + 8), 0, 1);
+  if (o.warm_levels > 0) {
+    index.warm_up(o.warm_levels, false, false, 0);
+  }
+  vector<MDB_txn*> readers(o.threads);
+  for (int t = 0; t < o.threads; t++) {
+    readers[t] = index.begin_reader();
+  }
+  vector<double> latency(q.n);
+  vector<size_t> hits(q.n);
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  parallel_for(q.n, o.threads, [&](int t, size_t i) {
+    vector<int32_t> result;
+    std::chrono::steady_clock::time_point s = std::chrono::steady_clock::now();
+    index.get_nns_by_vector(readers[t], q.row(i), o.n, (size_t) o.search_k, &result, NULL);
+    latency[i] = seconds_since(s);
+    std::sort(result.begin(), result.end());
+    for (size_t j = 0; j < truth[i].size(); j++) {
+      hits[i] += std::binary_search(result.begin(), result.end(), truth[i][j]);
+    }
+  });
+  double s = seconds_since(t0);
+  for (int t = 0; t < o.threads; t++) {
+    index.end_reader(readers[t]);
+  }
+
+  size_t found = 0, wanted = 0;
+  for (size_t i = 0; i < q.n; i++) {
+    found += hits[i];
+    wanted += truth[i].size();
+  }
+  std::sort(latency.begin(), latency.end());
+  printf("%zu queries on %d threads: %.0f QPS, latency p50 %.3fms p99 %.3fms, recall@%zu %.3f\n",
+    q.n, o.threads, q.n / s, latency[q.n / 2] * 1000, latency[std::min(q.n - 1, q.n * 99 / 100)] * 1000,
+    o.n, wanted ? (double) found / wanted : 0.0);
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    usage();
+  }
+  string command(argv[1]);
+  options o;
+  o.dir = NULL;
+  o.trees = 0;
+  o.K = 10;
+  o.f = 0;
+  o.first_id = 0;
+  o.batch = 1000;
+  o.map_size = 1ULL << 30;
+  o.n = 10;
+  o.search_k = -1;
+  o.distances = false;
+  o.threads = 1;
+  o.warm_levels = 0;
+  o.truth = NULL;
+  o.base = NULL;
+  o.file = NULL;
+
+  int opt;
+  optind = 2;
+  while ((opt = getopt(argc, argv, "d:t:K:f:s:b:m:n:k:Dw:W:g:B:")) != -1) {
+    switch (opt) {
+      case 'd': o.dir = optarg; break;
+      case 't': o.trees = atoi(optarg); break;
+      case 'K': o.K = atoi(optarg); break;
+      case 'f': o.f = atoi(optarg); break;
+      case 's': o.first_id = atoi(optarg); break;
+      case 'b': o.batch = atol(optarg); break;
+      case 'm': o.map_size = strtoull(optarg, NULL, 10); break;
+      case 'n': o.n = atol(optarg); break;
+      case 'k': o.search_k = atoi(optarg); break;
+      case 'D': o.distances = true; break;
+      case 'w': o.threads = atoi(optarg); break;
+      case 'W': o.warm_levels = atoi(optarg); break;
+      case 'g': o.truth = optarg; break;
+      case 'B': o.base = optarg; break;
+      default: usage();
+    }
+  }
+  if (optind < argc) {
+    o.file = argv[optind];
+  }
+  if (o.dir == NULL || o.trees <= 0 || o.K <= 0 || o.batch == 0 || o.n == 0 || o.threads <= 0) {
+    usage();
+  }
+
+  if (command == "stats") {
+    if (o.f <= 0) {
+      usage();
+    }
+    return stats(o);
+  }
+  if (o.file == NULL) {
+    usage();
+  }
+  if (command == "ingest") {
+    return ingest(o);
+  }
+  if (command == "query") {
+    return query(o);
+  }
+  if (command == "bench") {
+    return bench(o);
+  }
+  usage();
+  return 1;
+}
+
+// vim: tabstop=2 shiftwidth=2
@@ -39,8 +39,11 @@
 #include <algorithm>
 #include <queue>
 #include <limits>
+#if defined(__AVX2__) || defined(__F16C__)
+#include <immintrin.h>
+#endif
+#include <thread>
 #include "protobuf/annoy.pb.h"
-#include "lmdbforest.h"
 
 // This allows others to supply their own logger / error printer without
 // requiring Annoy to import their headers. See RcppAnnoy for a use case.
@@ -55,6 +58,19 @@
   // TODO: this is turned on by default, but may not work for all architectures! Need to investigate.
 #endif
 
+// Leaf splits: each attempt runs two-means over SPLIT_ITERATIONS sampled
+// points, and is retried up to SPLIT_ATTEMPTS times while the smaller side
+// holds less than SPLIT_MIN_FRACTION of the points.
+#ifndef SPLIT_ITERATIONS
+  #define SPLIT_ITERATIONS 200
+#endif
+#ifndef SPLIT_ATTEMPTS
+  #define SPLIT_ATTEMPTS 3
+#endif
+#ifndef SPLIT_MIN_FRACTION
+  #define SPLIT_MIN_FRACTION 0.1
+#endif
+
 
 using std::vector;
 using std::string;
@@ -106,6 +122,280 @@ inline void normalize(tree_node& node, int f, float norm) {
     node.set_v(z, node.v(z)/ norm);
 }
 
+// Raw vector codecs. CODEC_FLOAT scores candidates straight from DBN_RAW,
+// CODEC_INT8 and CODEC_PQ score them from the codes kept in DBN_CODE.
+enum {
+  CODEC_FLOAT = 0,
+  CODEC_INT8 = 1,
+  CODEC_PQ = 2
+};
+
+struct ANNOY_NODE_ATTRIBUTE Int8Header {
+  /*
+   * Header of a scalar-quantized vector. The f int8 codes follow it directly,
+   * so a record can be scored in place inside the LMDB map.
+   * x[z] ~= scale * codes[z] + offset
+   */
+  float scale;
+  float offset;
+  float norm;       // norm of the original float vector
+  int32_t code_sum; // sum of the codes, folds the offsets into the dot product
+};
+
+template<typename T>
+inline void quantize_int8(const T* v, int f, Int8Header* h, int8_t* codes) {
+  T lo = v[0], hi = v[0], sq_norm = 0;
+  for (int z = 0; z < f; z++) {
+    lo = std::min(lo, v[z]);
+    hi = std::max(hi, v[z]);
+    sq_norm += v[z] * v[z];
+  }
+  h->offset = (hi + lo) / 2;
+  h->scale = (hi - lo) / 254;
+  h->norm = sqrt(sq_norm);
+  h->code_sum = 0;
+  for (int z = 0; z < f; z++) {
+    int c = (h->scale > 0) ? (int)lrintf((v[z] - h->offset) / h->scale) : 0;
+    c = std::max(-127, std::min(127, c));
+    codes[z] = (int8_t)c;
+    h->code_sum += c;
+  }
+}
+
+inline int32_t dot_int8(const int8_t* x, const int8_t* y, int f) {
+  int32_t dot = 0;
+  int z = 0;
+#ifdef __AVX2__
+  __m256i acc = _mm256_setzero_si256();
+  for (; z + 16 <= f; z += 16) {
+    __m256i a = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(x + z)));
+    __m256i b = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(y + z)));
+    acc = _mm256_add_epi32(acc, _mm256_madd_epi16(a, b));
+  }
+  __m128i s = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+  s = _mm_hadd_epi32(s, s);
+  s = _mm_hadd_epi32(s, s);
+  dot = _mm_cvtsi128_si32(s);
+#endif
+  for (; z < f; z++)
+    dot += (int32_t)x[z] * (int32_t)y[z];
+  return dot;
+}
+
+template<typename T>
+inline T dot_int8(const Int8Header* x, const Int8Header* y, int f) {
+  // Expand sum((sx*cx + ox) * (sy*cy + oy)) so only the int8 product is per-dimension
+  const int8_t* xc = (const int8_t*)(x + 1);
+  const int8_t* yc = (const int8_t*)(y + 1);
+  return (T)x->scale * y->scale * dot_int8(xc, yc, f)
+    + (T)x->scale * y->offset * x->code_sum
+    + (T)x->offset * y->scale * y->code_sum
+    + (T)f * x->offset * y->offset;
+}
+
+// Storage types of data_info.data and tree_node.v. The half precision types
+// keep 16 bits per dimension in data_info.hdata / tree_node.hv instead, and
+// the kernels below widen them on the fly and accumulate in float.
+enum {
+  VECTOR_FLOAT32 = 0,
+  VECTOR_FLOAT16 = 1,
+  VECTOR_BFLOAT16 = 2
+};
+
+inline float half_to_float(uint16_t h) {
+#ifdef __F16C__
+  return _cvtsh_ss(h);
+#else
+  uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+  uint32_t exp = (h >> 10) & 0x1f;
+  uint32_t mant = h & 0x3ff;
+  uint32_t u;
+  if (exp == 0x1f) {
+    u = sign | 0x7f800000 | (mant << 13); // inf / nan
+  } else if (exp != 0) {
+    u = sign | ((exp + 112) << 23) | (mant << 13);
+  } else if (mant == 0) {
+    u = sign;
+  } else {
+    // subnormal half, renormalize
+    exp = 113;
+    while (!(mant & 0x400)) {
+      mant <<= 1;
+      exp--;
+    }
+    u = sign | (exp << 23) | ((mant & 0x3ff) << 13);
+  }
+  float f;
+  memcpy(&f, &u, sizeof(f));
+  return f;
+#endif
+}
+
+inline uint16_t float_to_half(float f) {
+#ifdef __F16C__
+  return _cvtss_sh(f, 0);
+#else
+  uint32_t u;
+  memcpy(&u, &f, sizeof(u));
+  uint16_t sign = (u >> 16) & 0x8000;
+  int32_t exp = (int32_t)((u >> 23) & 0xff) - 112;
+  uint32_t mant = u & 0x7fffff;
+  if (((u >> 23) & 0xff) == 0xff)
+    return sign | 0x7c00 | (mant ? 0x200 : 0);
+  if (exp >= 0x1f)
+    return sign | 0x7c00;
+  if (exp <= 0) {
+    if (exp < -10)
+      return sign;
+    mant |= 0x800000;
+    uint32_t shift = 14 - exp;
+    uint32_t h = mant >> shift;
+    uint32_t rem = mant & ((1u << shift) - 1);
+    uint32_t half = 1u << (shift - 1);
+    if (rem > half || (rem == half && (h & 1)))
+      h++;
+    return sign | h;
+  }
+  uint32_t h = ((uint32_t)exp << 10) | (mant >> 13);
+  uint32_t rem = mant & 0x1fff;
+  if (rem > 0x1000 || (rem == 0x1000 && (h & 1)))
+    h++; // may carry into the exponent, which is still correct
+  return sign | h;
+#endif
+}
+
+inline float bfloat16_to_float(uint16_t h) {
+  uint32_t u = (uint32_t)h << 16;
+  float f;
+  memcpy(&f, &u, sizeof(f));
+  return f;
+}
+
+inline uint16_t float_to_bfloat16(float f) {
+  uint32_t u;
+  memcpy(&u, &f, sizeof(u));
+  if ((u & 0x7fffffff) > 0x7f800000)
+    return (u >> 16) | 0x40; // keep nan a nan
+  u += 0x7fff + ((u >> 16) & 1); // round to nearest even
+  return u >> 16;
+}
+
+template<typename T>
+inline void encode_half(const T* v, int f, int vector_type, uint16_t* h) {
+  for (int z = 0; z < f; z++)
+    h[z] = (vector_type == VECTOR_BFLOAT16) ? float_to_bfloat16(v[z]) : float_to_half(v[z]);
+}
+
+template<typename T>
+inline void decode_half(const uint16_t* h, int f, int vector_type, T* v) {
+  for (int z = 0; z < f; z++)
+    v[z] = (vector_type == VECTOR_BFLOAT16) ? bfloat16_to_float(h[z]) : half_to_float(h[z]);
+}
+
+#if defined(__AVX2__) && defined(__F16C__)
+inline __m256 load_half8(const uint16_t* h, int vector_type) {
+  __m128i x = _mm_loadu_si128((const __m128i*)h);
+  if (vector_type == VECTOR_BFLOAT16)
+    return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(x), 16));
+  return _mm256_cvtph_ps(x);
+}
+#endif
+
+#ifdef __AVX2__
+inline float hsum8(__m256 x) {
+  __m128 s = _mm_add_ps(_mm256_castps256_ps128(x), _mm256_extractf128_ps(x, 1));
+  s = _mm_hadd_ps(s, s);
+  s = _mm_hadd_ps(s, s);
+  return _mm_cvtss_f32(s);
+}
+#endif
+
+template<typename T>
+inline void dot_half(const uint16_t* x, const T* y, int f, int vector_type, T* xy, T* xx) {
+  // Accumulates x.y and x.x where x is stored in half precision
+  T dot = 0, sq = 0;
+  int z = 0;
+#if defined(__AVX2__) && defined(__F16C__)
+  if (sizeof(T) == sizeof(float)) {
+    __m256 d = _mm256_setzero_ps(), s = _mm256_setzero_ps();
+    for (; z + 8 <= f; z += 8) {
+      __m256 a = load_half8(x + z, vector_type);
+      d = _mm256_add_ps(d, _mm256_mul_ps(a, _mm256_loadu_ps((const float*)(y + z))));
+      s = _mm256_add_ps(s, _mm256_mul_ps(a, a));
+    }
+    dot = hsum8(d);
+    sq = hsum8(s);
+  }
+#endif
+  for (; z < f; z++) {
+    T a = (vector_type == VECTOR_BFLOAT16) ? bfloat16_to_float(x[z]) : half_to_float(x[z]);
+    dot += a * y[z];
+    sq += a * a;
+  }
+  *xy = dot;
+  if (xx)
+    *xx = sq;
+}
+
+template<typename T>
+inline void dot_batch(const T* v, const T* x, size_t count, int f, T* out) {
+  // out[i] = v.x_i for count vectors of f values stored back to back
+  size_t i = 0;
+#ifdef __AVX2__
+  if (sizeof(T) == sizeof(float)) {
+    // four rows at a time, each load of v is shared by the four of them
+    const float* fv = (const float*) v;
+    for (; i + 4 <= count; i += 4) {
+      const float* x0 = (const float*)(x + i * f);
+      const float* x1 = x0 + f;
+      const float* x2 = x1 + f;
+      const float* x3 = x2 + f;
+      __m256 a0 = _mm256_setzero_ps(), a1 = _mm256_setzero_ps();
+      __m256 a2 = _mm256_setzero_ps(), a3 = _mm256_setzero_ps();
+      int z = 0;
+      for (; z + 8 <= f; z += 8) {
+        __m256 b = _mm256_loadu_ps(fv + z);
+        a0 = _mm256_add_ps(a0, _mm256_mul_ps(b, _mm256_loadu_ps(x0 + z)));
+        a1 = _mm256_add_ps(a1, _mm256_mul_ps(b, _mm256_loadu_ps(x1 + z)));
+        a2 = _mm256_add_ps(a2, _mm256_mul_ps(b, _mm256_loadu_ps(x2 + z)));
+        a3 = _mm256_add_ps(a3, _mm256_mul_ps(b, _mm256_loadu_ps(x3 + z)));
+      }
+      float d0 = hsum8(a0), d1 = hsum8(a1), d2 = hsum8(a2), d3 = hsum8(a3);
+      for (; z < f; z++) {
+        d0 += fv[z] * x0[z];
+        d1 += fv[z] * x1[z];
+        d2 += fv[z] * x2[z];
+        d3 += fv[z] * x3[z];
+      }
+      out[i] = d0;
+      out[i + 1] = d1;
+      out[i + 2] = d2;
+      out[i + 3] = d3;
+    }
+  }
+#endif
+  for (; i < count; i++) {
+    const T* xi = x + i * f;
+    T dot = 0;
+    for (int z = 0; z < f; z++)
+      dot += v[z] * xi[z];
+    out[i] = dot;
+  }
+}
+
+// Scratch buffers of Angular::split, owned by the index and reused by every
+// split so that splitting allocates nothing once they have grown to the
+// leaf size.
+template<typename T>
+struct SplitArena {
+  vector<T> points;      // the leaf's vectors back to back, filled by the caller
+  vector<T> p, q, x;     // two-means centroids and the sampled direction
+  vector<T> normal;
+  vector<T> margins;
+  vector<size_t> perm;
+  vector<uint8_t> sides; // 1 for left, read back by the caller
+};
+
 template<typename S, typename T, class Random>
 struct Angular {
   struct ANNOY_NODE_ATTRIBUTE Node {
@@ -175,6 +465,36 @@ struct Angular {
     else return 2.0; // cos is 0
   }
 
+  static inline T distance(const Int8Header* x, const Int8Header* y, int f) {
+    // same as above, the norms are kept exact in the headers
+    T pq = dot_int8<T>(x, y, f);
+    T ppqq = (T)x->norm * x->norm * y->norm * y->norm;
+    if (ppqq > 0) return 2.0 - 2.0 * pq / sqrt(ppqq);
+    else return 2.0; // cos is 0
+  }
+
+  static inline T distance(const T* x, const uint16_t* y, int f, int vector_type) {
+    // same as above with y stored in half precision
+    T pp = 0, qq = 0, pq = 0;
+    for (int z = 0; z < f; z++)
+      pp += x[z] * x[z];
+    dot_half(y, x, f, vector_type, &pq, &qq);
+    T ppqq = pp * qq;
+    if (ppqq > 0) return 2.0 - 2.0 * pq / sqrt(ppqq);
+    else return 2.0; // cos is 0
+  }
+
+  static inline T distance_from_cos(T cos) {
+    // distance of two unit vectors given their inner product
+    return 2.0 - 2.0 * cos;
+  }
+
+  static inline T margin(const uint16_t* v, const T* y, int f, int vector_type) {
+    T dot = 0;
+    dot_half(v, y, f, vector_type, &dot, (T*)NULL);
+    return dot;
+  }
+
   static inline T margin(const tree_node& tn, const T* y, int f) {
     T dot = 0;
     for (int z = 0; z < f; z++) {
@@ -241,56 +561,115 @@ struct Angular {
   }
   
   
-  static inline void split(const tree_node& tn, const vector<data_info>& nodes,
-                           tree_node& new_node,  tree_node& left_node, tree_node& right_node,
-                           Random& random, int f) {
-    
-    // Sample two random points from the set of nodes
-    // Calculate the hyperplane equidistant from them
-    size_t count = nodes.size();
+  static inline void unit(const T* x, int f, T* out) {
+    T norm = 0;
+    for (int z = 0; z < f; z++)
+      norm += x[z] * x[z];
+    norm = sqrt(norm);
+    for (int z = 0; z < f; z++)
+      out[z] = norm > 0 ? x[z] / norm : 0;
+  }
+
+  // Two-means over the directions of count points of f values stored back to
+  // back: starts from two random points and moves the nearer centroid
+  // towards each sampled point. The centroids are left in arena.p, arena.q.
+  static inline void two_means(const T* points, size_t count, int f, Random& random,
+                               SplitArena<T>& arena) {
     size_t i = random.index(count);
     size_t j = random.index(count-1);
     j += (j >= i); // ensure that i != j
-    
-    //printf("use data %d and %d as pivot for splitting ... ", i, j);
-
-    data_info iv = nodes[i];
-    data_info jv = nodes[j];
-
-    //iv.PrintDebugString();
-    //jv.PrintDebugString();
-    
-    T i_norm = get_norm1(iv, f);
-    T j_norm = get_norm1(jv, f);
-    
-    float squared_sum = 0;
-    for (int z = 0; z < f; z++) {
-      T d = iv.data(z) / i_norm - jv.data(z) / j_norm;
-      new_node.add_v(d);
-      squared_sum += d*d;
+    T* p = &arena.p[0];
+    T* q = &arena.q[0];
+    T* x = &arena.x[0];
+    unit(points + i * f, f, p);
+    unit(points + j * f, f, q);
+
+    int ic = 1, jc = 1;
+    for (int l = 0; l < SPLIT_ITERATIONS; l++) {
+      const T* k = points + random.index(count) * f;
+      T di = ic * distance(p, k, f);
+      T dj = jc * distance(q, k, f);
+      unit(k, f, x);
+      if (di < dj) {
+        for (int z = 0; z < f; z++)
+          p[z] = (p[z] * ic + x[z]) / (ic + 1);
+        ic++;
+      } else if (dj < di) {
+        for (int z = 0; z < f; z++)
+          q[z] = (q[z] * jc + x[z]) / (jc + 1);
+        jc++;
+      }
     }
+  }
 
-    normalize(new_node, f, sqrt(squared_sum));
+  // Splits the items of a full leaf, whose vectors the caller has laid out
+  // in arena.points in item order, with the hyperplane between their two
+  // means. The points are classified in one batched pass (dot_batch). A
+  // split whose smaller side is empty or below SPLIT_MIN_FRACTION is
+  // retried; when no attempt is balanced the points are dealt to the two
+  // sides at random and the hyperplane is left zero, so later inserts flip
+  // a coin and queries descend both sides. arena.sides keeps the outcome.
+  static inline void split(const tree_node& tn, tree_node& new_node,
+                           tree_node& left_node, tree_node& right_node,
+                           Random& random, int f, SplitArena<T>& arena) {
+    size_t count = tn.items_size();
+    const T* points = &arena.points[0];
+    arena.p.resize(f);
+    arena.q.resize(f);
+    arena.x.resize(f);
+    arena.normal.resize(f);
+    arena.margins.resize(count);
+    arena.sides.resize(count);
+    T* normal = &arena.normal[0];
+    uint8_t* sides = &arena.sides[0];
+
+    size_t min_side = std::max<size_t>(1, count * SPLIT_MIN_FRACTION);
+    bool balanced = false;
+    for (int attempt = 0; attempt < SPLIT_ATTEMPTS && !balanced; attempt++) {
+      two_means(points, count, f, random, arena);
+      for (int z = 0; z < f; z++)
+        normal[z] = arena.p[z] - arena.q[z];
+      T norm = get_norm(normal, f);
+      if (norm == 0)
+        continue;
+      for (int z = 0; z < f; z++)
+        normal[z] /= norm;
+
+      dot_batch(normal, points, count, f, &arena.margins[0]);
+      size_t left = 0;
+      for (size_t w = 0; w < count; w++) {
+        T dot = arena.margins[w];
+        sides[w] = dot != 0 ? dot > 0 : random.flip();
+        left += sides[w];
+      }
+      balanced = std::min(left, count - left) >= min_side;
+    }
+
+    if (!balanced) {
+      std::fill(normal, normal + f, 0);
+      arena.perm.resize(count);
+      for (size_t w = 0; w < count; w++)
+        arena.perm[w] = w;
+      for (size_t w = 0; w + 1 < count; w++)
+        std::swap(arena.perm[w], arena.perm[w + random.index(count - w)]);
+      for (size_t w = 0; w < count; w++)
+        sides[arena.perm[w]] = w % 2 == 0;
+    }
+
+    new_node.mutable_v()->Reserve(f);
+    for (int z = 0; z < f; z++)
+      new_node.add_v(normal[z]);
     new_node.set_leaf(false);
     left_node.set_leaf(true);
     right_node.set_leaf(true);
 
-
-    T* w_data = new T[f];
-    for (int w = 0; w < nodes.size(); w ++ ){
-      data_info d = nodes[w];
-      for (int s = 0; s < f; s ++) {
-        w_data[s] = d.data(s);
-      }
-
-
-      bool sd = side(new_node, w_data, f, random);
-      if (sd) {
-        left_node.add_items(nodes[w].id());
+    for (size_t w = 0; w < count; w++) {
+      if (sides[w]) {
+        left_node.add_items(tn.items(w));
       } else {
-        right_node.add_items(nodes[w].id());
-      } 
-    }    
+        right_node.add_items(tn.items(w));
+      }
+    }
   }
   
   
@@ -300,5 +679,7 @@ struct Angular {
   }
 };
 
+#include "lmdbforest.h"
+
 #endif
 // vim: tabstop=2 shiftwidth=2
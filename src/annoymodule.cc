@@ -14,6 +14,7 @@
 
 #include "annoylib.h"
 #include "kissrandom.h"
+#include "annoyrpc.h"
 #include "Python.h"
 #include "structmember.h"
 #include <exception>
@@ -45,6 +46,8 @@ typedef struct {
   long max_size;
   int read_only;
   AnnoyIndexInterface<int32_t, float>* ptr;
+  AnnoyHandle<int32_t, float>* handle; // ptr, queries go through it so versions can be swapped
+  ShardServer<int32_t, float>* server; // see serve
 } py_annoy;
 
 
@@ -56,6 +59,8 @@ py_an_new(PyTypeObject *type, PyObject *args, PyObject *kwds) {
   if (self != NULL) {
     self->f = 0;
     self->ptr = NULL;
+    self->handle = NULL;
+    self->server = NULL;
   }
 
   return (PyObject *)self;
@@ -69,21 +74,43 @@ py_an_init(py_annoy *self, PyObject *args, PyObject *kwds) {
 
 
 
-  if (!PyArg_ParseTuple(args, "iisiilis", &self->f,  &self->K, 
-    &file_dir, &self->tree_count, &self->max_reader, &self->max_size, &self->read_only, &metric))
+  int shards = 1;
+  if (!PyArg_ParseTuple(args, "iisiilis|i", &self->f,  &self->K, 
+    &file_dir, &self->tree_count, &self->max_reader, &self->max_size, &self->read_only, &metric, &shards))
     return -1;
   switch(metric[0]) {
-  case 'a':
-    self->ptr = new AnnoyIndex<int32_t, float, Angular, Kiss64Random>(self->f, self->K,  
-      self->tree_count, file_dir, self->max_reader, self->max_size, self->read_only);
+  case 'a': {
+    int f = self->f, K = self->K, tree_count = self->tree_count, max_reader = self->max_reader;
+    std::function<AnnoyIndexInterface<int32_t, float>*(const char*, long, int)> open =
+      [f, K, tree_count, max_reader, shards](const char* dir, long max_size, int read_only)
+        -> AnnoyIndexInterface<int32_t, float>* {
+      if (shards > 1)
+        return new AnnoyShardedIndex<int32_t, float, Angular, Kiss64Random>(f, K, tree_count, dir, shards,
+          max_reader, max_size, read_only);
+      return new AnnoyIndex<int32_t, float, Angular, Kiss64Random>(f, K, tree_count, dir, max_reader,
+        max_size, read_only);
+    };
+    self->handle = new AnnoyHandle<int32_t, float>(open(file_dir, self->max_size, self->read_only), file_dir,
+      [open, shards](const char* dir) -> AnnoyIndexInterface<int32_t, float>* {
+        struct stat st;
+        std::string path = std::string(dir) + (shards > 1 ? "/shard.0/data.mdb" : "/data.mdb");
+        if (stat(path.c_str(), &st) != 0)
+          return NULL;
+        return open(dir, 0, 1);
+      });
+    self->ptr = self->handle;
     break;
   }
+  }
   return 0;
 }
 
 
 static void 
 py_an_dealloc(py_annoy* self) {
+  if (self->server) {
+    delete self->server;
+  }
   if (self->ptr) {
     delete self->ptr;
   }
@@ -233,11 +260,12 @@ static PyObject*
 py_an_display_node(py_annoy *self, PyObject *args) {
  
   int32_t item;
+  int tree = 0;
   if (!self->ptr) 
     return Py_None;
-  if (!PyArg_ParseTuple(args, "i", &item))
+  if (!PyArg_ParseTuple(args, "i|i", &item, &tree))
     return Py_None;
-  self->ptr->display_node(item);
+  self->ptr->display_node(item, tree);
 
   Py_RETURN_NONE;
 }
@@ -386,6 +414,430 @@ py_an_verbose(py_annoy *self, PyObject *args) {
 }
 
 
+static PyObject *
+py_an_set_codec(py_annoy *self, PyObject *args) {
+  int codec;
+  if (!self->ptr) 
+    return Py_None;
+  if (!PyArg_ParseTuple(args, "i", &codec))
+    return Py_None;
+
+  self->ptr->set_codec(codec);
+
+  Py_RETURN_TRUE;
+}
+
+
+static PyObject *
+py_an_set_rerank(py_annoy *self, PyObject *args) {
+  int rerank_k;
+  if (!self->ptr) 
+    return Py_None;
+  if (!PyArg_ParseTuple(args, "i", &rerank_k))
+    return Py_None;
+
+  self->ptr->set_rerank(rerank_k);
+
+  Py_RETURN_TRUE;
+}
+
+
+static PyObject *
+py_an_set_vector_type(py_annoy *self, PyObject *args) {
+  int vector_type;
+  if (!self->ptr) 
+    return Py_None;
+  if (!PyArg_ParseTuple(args, "i", &vector_type))
+    return Py_None;
+
+  self->ptr->set_vector_type(vector_type);
+
+  Py_RETURN_TRUE;
+}
+
+
+static PyObject *
+py_an_train_pq(py_annoy *self, PyObject *args) {
+  int m, nbits, sample_size = 100000;
+  if (!self->ptr) 
+    return Py_None;
+  if (!PyArg_ParseTuple(args, "ii|i", &m, &nbits, &sample_size))
+    return Py_None;
+
+  if (!self->ptr->train_pq(m, nbits, sample_size))
+    Py_RETURN_FALSE;
+  Py_RETURN_TRUE;
+}
+
+
+static PyObject *
+py_an_set_leaf_embedding(py_annoy *self, PyObject *args) {
+  int trees;
+  if (!self->ptr) 
+    return Py_None;
+  if (!PyArg_ParseTuple(args, "i", &trees))
+    return Py_None;
+
+  self->ptr->set_leaf_embedding(trees);
+
+  Py_RETURN_TRUE;
+}
+
+
+static PyObject *
+py_an_get_tree_stats(py_annoy *self, PyObject *args) {
+  int tree;
+  if (!self->ptr) 
+    return Py_None;
+  if (!PyArg_ParseTuple(args, "i", &tree))
+    return Py_None;
+
+  tree_stats stats;
+  if (!self->ptr->get_tree_stats(tree, &stats))
+    return Py_None;
+
+  return Py_BuildValue("{s:n,s:n,s:n,s:n,s:i,s:d}",
+                       "nodes", (Py_ssize_t) stats.nodes,
+                       "leaves", (Py_ssize_t) stats.leaves,
+                       "empty_leaves", (Py_ssize_t) stats.empty_leaves,
+                       "items", (Py_ssize_t) stats.items,
+                       "max_depth", stats.max_depth,
+                       "mean_depth", stats.mean_depth);
+}
+
+
+static PyObject *
+py_an_rebalance(py_annoy *self, PyObject *args) {
+  double depth_ratio = 2.0, min_fill = 0.25;
+  int max_items = 100000;
+  if (!self->ptr) 
+    return Py_None;
+  if (!PyArg_ParseTuple(args, "|ddi", &depth_ratio, &min_fill, &max_items))
+    return Py_None;
+
+  size_t rebuilt;
+  Py_BEGIN_ALLOW_THREADS;
+  rebuilt = self->ptr->rebalance(depth_ratio, min_fill, max_items);
+  Py_END_ALLOW_THREADS;
+
+  return PyLong_FromSize_t(rebuilt);
+}
+
+
+static PyObject *
+py_an_start_maintenance(py_annoy *self, PyObject *args) {
+  int interval_ms;
+  double depth_ratio = 2.0, min_fill = 0.25;
+  int max_items = 10000;
+  if (!self->ptr) 
+    return Py_None;
+  if (!PyArg_ParseTuple(args, "i|ddi", &interval_ms, &depth_ratio, &min_fill, &max_items))
+    return Py_None;
+
+  if (self->ptr->start_maintenance(interval_ms, depth_ratio, min_fill, max_items))
+    Py_RETURN_TRUE;
+  Py_RETURN_FALSE;
+}
+
+
+static PyObject *
+py_an_stop_maintenance(py_annoy *self, PyObject *args) {
+  if (!self->ptr) 
+    return Py_None;
+
+  Py_BEGIN_ALLOW_THREADS;
+  self->ptr->stop_maintenance();
+  Py_END_ALLOW_THREADS;
+
+  Py_RETURN_NONE;
+}
+
+
+static PyObject *
+py_an_set_leaf_page_size(py_annoy *self, PyObject *args) {
+  int page_size;
+  if (!self->ptr) 
+    return Py_None;
+  if (!PyArg_ParseTuple(args, "i", &page_size))
+    return Py_None;
+
+  self->ptr->set_leaf_page_size(page_size);
+
+  return PyInt_FromLong(self->ptr->get_leaf_capacity());
+}
+
+
+static PyObject *
+py_an_get_leaf_capacity(py_annoy *self, PyObject *args) {
+  if (!self->ptr) 
+    return Py_None;
+
+  return PyInt_FromLong(self->ptr->get_leaf_capacity());
+}
+
+
+static PyObject *
+py_an_set_seed(py_annoy *self, PyObject *args) {
+  unsigned long long seed;
+  if (!self->ptr) 
+    return Py_None;
+  if (!PyArg_ParseTuple(args, "K", &seed))
+    return Py_None;
+
+  self->ptr->set_seed(seed);
+
+  Py_RETURN_NONE;
+}
+
+
+static PyObject *
+py_an_set_write_buffer(py_annoy *self, PyObject *args) {
+  int capacity, flush_interval_ms = 100;
+  if (!self->ptr) 
+    return Py_None;
+  if (!PyArg_ParseTuple(args, "i|i", &capacity, &flush_interval_ms))
+    return Py_None;
+
+  bool ok;
+  Py_BEGIN_ALLOW_THREADS;
+  ok = self->ptr->set_write_buffer(capacity, flush_interval_ms);
+  Py_END_ALLOW_THREADS;
+
+  if (ok)
+    Py_RETURN_TRUE;
+  Py_RETURN_FALSE;
+}
+
+
+static PyObject *
+py_an_flush(py_annoy *self, PyObject *args) {
+  if (!self->ptr) 
+    return Py_None;
+
+  Py_BEGIN_ALLOW_THREADS;
+  self->ptr->flush();
+  Py_END_ALLOW_THREADS;
+
+  Py_RETURN_NONE;
+}
+
+
+static PyObject *
+py_an_set_group_commit(py_annoy *self, PyObject *args) {
+  int max_items, max_delay_ms = 100;
+  if (!self->ptr) 
+    return Py_None;
+  if (!PyArg_ParseTuple(args, "i|i", &max_items, &max_delay_ms))
+    return Py_None;
+
+  Py_BEGIN_ALLOW_THREADS;
+  self->ptr->set_group_commit(max_items, max_delay_ms);
+  Py_END_ALLOW_THREADS;
+
+  Py_RETURN_NONE;
+}
+
+
+static PyObject *
+py_an_set_durability(py_annoy *self, PyObject *args) {
+  int policy;
+  if (!self->ptr) 
+    return Py_None;
+  if (!PyArg_ParseTuple(args, "i", &policy))
+    return Py_None;
+
+  self->ptr->set_durability(policy);
+
+  Py_RETURN_NONE;
+}
+
+
+static PyObject *
+py_an_get_map_usage(py_annoy *self, PyObject *args) {
+  if (!self->ptr) 
+    return Py_None;
+
+  map_usage usage;
+  self->ptr->get_map_usage(&usage);
+
+  return Py_BuildValue("{s:n,s:n,s:n,s:I,s:I}",
+                       "map_size", (Py_ssize_t) usage.map_size,
+                       "used_size", (Py_ssize_t) usage.used_size,
+                       "page_size", (Py_ssize_t) usage.page_size,
+                       "readers", usage.readers,
+                       "max_readers", usage.max_readers);
+}
+
+
+static PyObject *
+py_an_rebuild_tree(py_annoy *self, PyObject *args) {
+  int tree;
+  if (!self->ptr) 
+    return Py_None;
+  if (!PyArg_ParseTuple(args, "i", &tree))
+    return Py_None;
+
+  bool rebuilt;
+  Py_BEGIN_ALLOW_THREADS;
+  rebuilt = self->ptr->rebuild_tree(tree);
+  Py_END_ALLOW_THREADS;
+
+  return PyBool_FromLong(rebuilt);
+}
+
+
+static PyObject *
+py_an_compact_trees(py_annoy *self, PyObject *args) {
+  int layout = LAYOUT_VEB;
+  if (!self->ptr) 
+    return Py_None;
+  if (!PyArg_ParseTuple(args, "|i", &layout))
+    return Py_None;
+
+  bool compacted;
+  Py_BEGIN_ALLOW_THREADS;
+  compacted = self->ptr->compact_trees(layout);
+  Py_END_ALLOW_THREADS;
+
+  return PyBool_FromLong(compacted);
+}
+
+
+static PyObject *
+py_an_warm_up(py_annoy *self, PyObject *args) {
+  int levels = 8, raw = 0, lock = 0, budget_ms = 0;
+  if (!self->ptr) 
+    return Py_None;
+  if (!PyArg_ParseTuple(args, "|iiii", &levels, &raw, &lock, &budget_ms))
+    return Py_None;
+
+  size_t pages;
+  Py_BEGIN_ALLOW_THREADS;
+  pages = self->ptr->warm_up(levels, raw, lock, budget_ms);
+  Py_END_ALLOW_THREADS;
+
+  return PyInt_FromLong(pages);
+}
+
+
+static PyObject *
+py_page_report(const page_report& report) {
+  return Py_BuildValue("{s:n,s:n,s:n,s:n}",
+                       "page_size", (Py_ssize_t) report.page_size,
+                       "used_pages", (Py_ssize_t) report.used_pages,
+                       "live_pages", (Py_ssize_t) report.live_pages,
+                       "free_pages", (Py_ssize_t) report.free_pages);
+}
+
+
+static PyObject *
+py_an_compact(py_annoy *self, PyObject *args) {
+  const char *dest_dir;
+  int layout = -1;
+  if (!self->ptr) 
+    return Py_None;
+  if (!PyArg_ParseTuple(args, "s|i", &dest_dir, &layout))
+    return Py_None;
+
+  page_report before, after;
+  bool res;
+  Py_BEGIN_ALLOW_THREADS;
+  res = self->ptr->compact(dest_dir, layout, &before, &after);
+  Py_END_ALLOW_THREADS;
+
+  if (!res) {
+    PyErr_SetFromErrno(PyExc_IOError);
+    return NULL;
+  }
+  PyObject* b = py_page_report(before);
+  PyObject* a = py_page_report(after);
+  PyObject* report = Py_BuildValue("{s:O,s:O}", "before", b, "after", a);
+  Py_DECREF(b);
+  Py_DECREF(a);
+  return report;
+}
+
+
+static PyObject *
+py_an_swap(py_annoy *self, PyObject *args) {
+  const char *dir;
+  int levels = 8, raw = 0, budget_ms = 0, background = 0;
+  if (!self->handle) 
+    return Py_None;
+  if (!PyArg_ParseTuple(args, "s|iiii", &dir, &levels, &raw, &budget_ms, &background))
+    return Py_None;
+
+  bool res = true;
+  Py_BEGIN_ALLOW_THREADS;
+  if (background)
+    self->handle->swap_async(dir, levels, raw, budget_ms);
+  else
+    res = self->handle->swap(dir, levels, raw, budget_ms);
+  Py_END_ALLOW_THREADS;
+
+  return PyBool_FromLong(res);
+}
+
+
+static PyObject *
+py_an_wait_swap(py_annoy *self, PyObject *args) {
+  if (!self->handle) 
+    return Py_None;
+
+  bool res;
+  Py_BEGIN_ALLOW_THREADS;
+  res = self->handle->wait_swap();
+  Py_END_ALLOW_THREADS;
+
+  return PyBool_FromLong(res);
+}
+
+
+static PyObject *
+py_an_get_version(py_annoy *self, PyObject *args) {
+  if (!self->handle) 
+    return Py_None;
+
+  return PyInt_FromLong(self->handle->get_version());
+}
+
+
+static PyObject *
+py_an_serve(py_annoy *self, PyObject *args) {
+  const char *path;
+  if (!self->ptr) 
+    return Py_None;
+  if (!PyArg_ParseTuple(args, "s", &path))
+    return Py_None;
+
+  if (!self->server)
+    self->server = new ShardServer<int32_t, float>(self->ptr, self->f);
+  bool res;
+  Py_BEGIN_ALLOW_THREADS;
+  res = self->server->start(path);
+  Py_END_ALLOW_THREADS;
+
+  if (!res) {
+    PyErr_SetFromErrno(PyExc_IOError);
+    return NULL;
+  }
+  Py_RETURN_TRUE;
+}
+
+
+static PyObject *
+py_an_stop_serving(py_annoy *self, PyObject *args) {
+  if (!self->server) 
+    Py_RETURN_NONE;
+
+  Py_BEGIN_ALLOW_THREADS;
+  self->server->stop();
+  Py_END_ALLOW_THREADS;
+
+  Py_RETURN_NONE;
+}
+
+
 static PyMethodDef AnnoyMethods[] = {
   {"load",	(PyCFunction)py_an_load, METH_VARARGS, ""},
   {"save",	(PyCFunction)py_an_save, METH_VARARGS, ""},
@@ -402,6 +854,32 @@ static PyMethodDef AnnoyMethods[] = {
   {"get_distance",(PyCFunction)py_an_get_distance, METH_VARARGS, ""},
   {"get_n_items",(PyCFunction)py_an_get_n_items, METH_VARARGS, ""},
   {"verbose",(PyCFunction)py_an_verbose, METH_VARARGS, ""},
+  {"set_codec",(PyCFunction)py_an_set_codec, METH_VARARGS, ""},
+  {"set_rerank",(PyCFunction)py_an_set_rerank, METH_VARARGS, ""},
+  {"set_vector_type",(PyCFunction)py_an_set_vector_type, METH_VARARGS, ""},
+  {"train_pq",(PyCFunction)py_an_train_pq, METH_VARARGS, ""},
+  {"set_leaf_embedding",(PyCFunction)py_an_set_leaf_embedding, METH_VARARGS, ""},
+  {"get_tree_stats",(PyCFunction)py_an_get_tree_stats, METH_VARARGS, ""},
+  {"rebalance",(PyCFunction)py_an_rebalance, METH_VARARGS, ""},
+  {"rebuild_tree",(PyCFunction)py_an_rebuild_tree, METH_VARARGS, ""},
+  {"compact_trees",(PyCFunction)py_an_compact_trees, METH_VARARGS, ""},
+  {"start_maintenance",(PyCFunction)py_an_start_maintenance, METH_VARARGS, ""},
+  {"stop_maintenance",(PyCFunction)py_an_stop_maintenance, METH_VARARGS, ""},
+  {"set_leaf_page_size",(PyCFunction)py_an_set_leaf_page_size, METH_VARARGS, ""},
+  {"get_leaf_capacity",(PyCFunction)py_an_get_leaf_capacity, METH_VARARGS, ""},
+  {"set_seed",(PyCFunction)py_an_set_seed, METH_VARARGS, ""},
+  {"set_write_buffer",(PyCFunction)py_an_set_write_buffer, METH_VARARGS, ""},
+  {"flush",(PyCFunction)py_an_flush, METH_VARARGS, ""},
+  {"set_group_commit",(PyCFunction)py_an_set_group_commit, METH_VARARGS, ""},
+  {"set_durability",(PyCFunction)py_an_set_durability, METH_VARARGS, ""},
+  {"get_map_usage",(PyCFunction)py_an_get_map_usage, METH_VARARGS, ""},
+  {"warm_up",(PyCFunction)py_an_warm_up, METH_VARARGS, ""},
+  {"compact",(PyCFunction)py_an_compact, METH_VARARGS, ""},
+  {"swap",(PyCFunction)py_an_swap, METH_VARARGS, ""},
+  {"serve",(PyCFunction)py_an_serve, METH_VARARGS, ""},
+  {"stop_serving",(PyCFunction)py_an_stop_serving, METH_VARARGS, ""},
+  {"wait_swap",(PyCFunction)py_an_wait_swap, METH_VARARGS, ""},
+  {"get_version",(PyCFunction)py_an_get_version, METH_VARARGS, ""},
   {NULL, NULL, 0, NULL}		 /* Sentinel */
 };
 
@@ -447,6 +925,154 @@ static PyTypeObject PyAnnoyType = {
   py_an_new,              /* tp_new */
 };
 
+// scatter-gather coordinator python object, see ScatterGather
+typedef struct {
+  PyObject_HEAD
+  int f;
+  ScatterGather<int32_t, float>* ptr;
+} py_scatter;
+
+
+static PyObject *
+py_sg_new(PyTypeObject *type, PyObject *args, PyObject *kwds) {
+  py_scatter *self;
+
+  self = (py_scatter *)type->tp_alloc(type, 0);
+  if (self != NULL) {
+    self->f = 0;
+    self->ptr = NULL;
+  }
+
+  return (PyObject *)self;
+}
+
+
+// ScatterGather(f, shards, hedge_ms, deadline_ms), shards lists the socket
+// paths of the replicas of each shard
+static int 
+py_sg_init(py_scatter *self, PyObject *args, PyObject *kwds) {
+  PyObject* l;
+  int hedge_ms, deadline_ms;
+  if (!PyArg_ParseTuple(args, "iOii", &self->f, &l, &hedge_ms, &deadline_ms))
+    return -1;
+
+  PyObject* all = PySequence_Fast(l, "shards must be a list of lists of socket paths");
+  if (!all)
+    return -1;
+  vector<vector<std::string> > shards;
+  for (Py_ssize_t s = 0; s < PySequence_Fast_GET_SIZE(all); s++) {
+    PyObject* replicas = PySequence_Fast(PySequence_Fast_GET_ITEM(all, s),
+                                         "each shard must be a list of socket paths");
+    if (!replicas) {
+      Py_DECREF(all);
+      return -1;
+    }
+    shards.push_back(vector<std::string>());
+    for (Py_ssize_t r = 0; r < PySequence_Fast_GET_SIZE(replicas); r++) {
+      PyObject* path = PySequence_Fast_GET_ITEM(replicas, r);
+#ifdef IS_PY3K
+      const char* p = PyUnicode_Check(path) ? PyUnicode_AsUTF8(path) : NULL;
+#else
+      const char* p = PyString_Check(path) ? PyString_AsString(path) : NULL;
+#endif
+      if (!p) {
+        if (!PyErr_Occurred())
+          PyErr_SetString(PyExc_TypeError, "a socket path must be a str");
+        Py_DECREF(replicas);
+        Py_DECREF(all);
+        return -1;
+      }
+      shards.back().push_back(p);
+    }
+    Py_DECREF(replicas);
+  }
+  Py_DECREF(all);
+  self->ptr = new ScatterGather<int32_t, float>(self->f, shards, hedge_ms, deadline_ms);
+  return 0;
+}
+
+
+static void 
+py_sg_dealloc(py_scatter* self) {
+  if (self->ptr) {
+    delete self->ptr;
+  }
+  Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+
+static PyObject* 
+py_sg_get_nns_by_vector(py_scatter *self, PyObject *args) {
+  PyObject* v;
+  int32_t n, search_k=-1, include_distances=0;
+  if (!self->ptr) 
+    return Py_None;
+  if (!PyArg_ParseTuple(args, "Oi|ii", &v, &n, &search_k, &include_distances))
+    return Py_None;
+
+  vector<float> w(self->f);
+  for (int z = 0; z < PyList_Size(v) && z < self->f; z++) {
+    PyObject *pf = PyList_GetItem(v,z);
+    w[z] = PyFloat_AsDouble(pf);
+  }
+
+  vector<int32_t> result;
+  vector<float> distances;
+  Py_BEGIN_ALLOW_THREADS;
+  self->ptr->get_nns_by_vector(&w[0], n, search_k, &result, include_distances ? &distances : NULL);
+  Py_END_ALLOW_THREADS;
+
+  return get_nns_to_python(result, distances, include_distances);
+}
+
+
+static PyMethodDef ScatterGatherMethods[] = {
+  {"get_nns_by_vector",(PyCFunction)py_sg_get_nns_by_vector, METH_VARARGS, ""},
+  {NULL, NULL, 0, NULL}		 /* Sentinel */
+};
+
+
+static PyTypeObject PyScatterGatherType = {
+  PyVarObject_HEAD_INIT(NULL, 0)
+  "annoy.ScatterGather",  /*tp_name*/
+  sizeof(py_scatter),     /*tp_basicsize*/
+  0,                      /*tp_itemsize*/
+  (destructor)py_sg_dealloc, /*tp_dealloc*/
+  0,                      /*tp_print*/
+  0,                      /*tp_getattr*/
+  0,                      /*tp_setattr*/
+  0,                      /*tp_compare*/
+  0,                      /*tp_repr*/
+  0,                      /*tp_as_number*/
+  0,                      /*tp_as_sequence*/
+  0,                      /*tp_as_mapping*/
+  0,                      /*tp_hash */
+  0,                      /*tp_call*/
+  0,                      /*tp_str*/
+  0,                      /*tp_getattro*/
+  0,                      /*tp_setattro*/
+  0,                      /*tp_as_buffer*/
+  Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, /*tp_flags*/
+  "scatter-gather coordinator objects", /* tp_doc */
+  0,                      /* tp_traverse */
+  0,                      /* tp_clear */
+  0,                      /* tp_richcompare */
+  0,                      /* tp_weaklistoffset */
+  0,                      /* tp_iter */
+  0,                      /* tp_iternext */
+  ScatterGatherMethods,   /* tp_methods */
+  0,                      /* tp_members */
+  0,                      /* tp_getset */
+  0,                      /* tp_base */
+  0,                      /* tp_dict */
+  0,                      /* tp_descr_get */
+  0,                      /* tp_descr_set */
+  0,                      /* tp_dictoffset */
+  (initproc)py_sg_init,   /* tp_init */
+  0,                      /* tp_alloc */
+  py_sg_new,              /* tp_new */
+};
+
 static PyMethodDef module_methods[] = {
   {NULL}	/* Sentinel */
 };
@@ -470,6 +1096,8 @@ PyObject *create_module(void) {
 
   if (PyType_Ready(&PyAnnoyType) < 0)
     return NULL;
+  if (PyType_Ready(&PyScatterGatherType) < 0)
+    return NULL;
 
 #if PY_MAJOR_VERSION >= 3
   m = PyModule_Create(&moduledef);
@@ -482,6 +1110,8 @@ PyObject *create_module(void) {
 
   Py_INCREF(&PyAnnoyType);
   PyModule_AddObject(m, "Annoy", (PyObject *)&PyAnnoyType);
+  Py_INCREF(&PyScatterGatherType);
+  PyModule_AddObject(m, "ScatterGather", (PyObject *)&PyScatterGatherType);
   return m;
 }
 
@@ -0,0 +1,595 @@
+// Copyright (c) 2013 Spotify AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#ifndef ANNOY_RPC_H
+#define ANNOY_RPC_H
+
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <vector>
+#include <string>
+#include <set>
+#include <map>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include "lmdbforest.h"
+
+/*
+ Wire protocol for queries between processes, over a stream socket.
+
+ Every message starts with a uint32 size, the number of bytes that follow
+ it, then the rest of its header. Values are in host byte order, so both
+ ends run on one machine or one architecture.
+
+ 1. A request is a query_header followed by count vectors of f T values.
+ Each vector is answered with its n nearest items, searching search_k
+ nodes (-1 for the default).
+
+ 2. A reply is a reply_header echoing the request id, followed, when the
+ status is RPC_OK, by count results: a uint32 m, then m S ids and m T
+ distances, nearest first.
+
+ */
+
+#define RPC_QUERY 1
+
+#define RPC_OK 0
+#define RPC_BAD_REQUEST 1
+#define RPC_BUSY 2 // the server sheds load, try another replica
+
+#define RPC_MAX_MESSAGE (64 << 20)
+
+struct query_header {
+  uint32_t size;
+  uint32_t op;
+  uint32_t id;
+  uint32_t f;
+  uint32_t count;
+  uint32_t n;
+  int32_t search_k;
+};
+
+struct reply_header {
+  uint32_t size;
+  uint32_t status;
+  uint32_t id;
+  uint32_t count;
+};
+
+inline bool rpc_read(int fd, void* buf, size_t len) {
+  char* p = (char*) buf;
+  while (len > 0) {
+    ssize_t r = read(fd, p, len);
+    if (r < 0 && errno == EINTR) {
+      continue;
+    }
+    if (r <= 0) {
+      return false;
+    }
+    p += r;
+    len -= r;
+  }
+  return true;
+}
+
+inline bool rpc_write(int fd, const void* buf, size_t len) {
+  const char* p = (const char*) buf;
+  while (len > 0) {
+    ssize_t r = send(fd, p, len, MSG_NOSIGNAL);
+    if (r < 0 && errno == EINTR) {
+      continue;
+    }
+    if (r <= 0) {
+      return false;
+    }
+    p += r;
+    len -= r;
+  }
+  return true;
+}
+
+// connects to the Unix socket at path, -1 on failure
+inline int rpc_connect(const char* path) {
+  struct sockaddr_un addr;
+  if (strlen(path) >= sizeof(addr.sun_path)) {
+    return -1;
+  }
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, path);
+  if (connect(fd, (struct sockaddr*) &addr, sizeof(addr)) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// listens on the Unix socket at path, replacing a stale one, -1 on failure
+inline int rpc_listen(const char* path) {
+  struct sockaddr_un addr;
+  if (strlen(path) >= sizeof(addr.sun_path)) {
+    return -1;
+  }
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, path);
+  unlink(path);
+  if (bind(fd, (struct sockaddr*) &addr, sizeof(addr)) != 0 || listen(fd, 128) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// appends a reply without results, for a request that is not answered
+inline void rpc_refuse(uint32_t id, uint32_t status, vector<char>* out) {
+  reply_header r;
+  r.size = sizeof(r) - sizeof(uint32_t);
+  r.status = status;
+  r.id = id;
+  r.count = 0;
+  out->insert(out->end(), (const char*) &r, (const char*) &r + sizeof(r));
+}
+
+// Answers the request h, whose vectors follow in body, with query(w, n,
+// search_k, result, distances) for each, appending the reply to out.
+template<typename S, typename T, class Query>
+void rpc_answer(Query& query, int f, const query_header& h, const char* body, vector<char>* out) {
+  if (h.op != RPC_QUERY || (int) h.f != f
+      || h.size != sizeof(query_header) - sizeof(uint32_t) + (size_t) h.count * f * sizeof(T)) {
+    rpc_refuse(h.id, RPC_BAD_REQUEST, out);
+    return;
+  }
+  reply_header r;
+  r.status = RPC_OK;
+  r.id = h.id;
+  r.count = h.count;
+  size_t start = out->size();
+  out->resize(start + sizeof(r));
+  vector<T> w(f);
+  vector<S> result;
+  vector<T> distances;
+  for (uint32_t q = 0; q < r.count; q++) {
+    memcpy(&w[0], body + (size_t) q * f * sizeof(T), f * sizeof(T));
+    result.clear();
+    distances.clear();
+    query(&w[0], (size_t) h.n, (size_t) h.search_k, &result, &distances);
+    uint32_t m = result.size();
+    size_t at = out->size();
+    out->resize(at + sizeof(m) + m * (sizeof(S) + sizeof(T)));
+    memcpy(&(*out)[at], &m, sizeof(m));
+    if (m > 0) {
+      memcpy(&(*out)[at + sizeof(m)], &result[0], m * sizeof(S));
+      memcpy(&(*out)[at + sizeof(m) + m * sizeof(S)], &distances[0], m * sizeof(T));
+    }
+  }
+  r.size = out->size() - start - sizeof(uint32_t);
+  memcpy(&(*out)[start], &r, sizeof(r));
+}
+
+// Serves one index on a Unix socket, with a thread per connection. It is
+// the shard process side of ScatterGather.
+template<typename S, typename T>
+class ShardServer {
+  protected:
+    AnnoyIndexInterface<S, T>* _index;
+    int _f;
+    string _path;
+    int _listen;
+    std::atomic<bool> _stop;
+    std::thread _acceptor;
+    std::mutex _mutex;
+    std::set<int> _connections;
+    std::map<std::thread::id, std::thread> _threads; // of the open connections
+    vector<std::thread::id> _finished; // connection threads returning, see _reap
+
+    // joins the connection threads that have returned, with _mutex held
+    void _reap() {
+      for (size_t i = 0; i < _finished.size(); i++) {
+        std::map<std::thread::id, std::thread>::iterator it = _threads.find(_finished[i]);
+        if (it != _threads.end()) {
+          it->second.join();
+          _threads.erase(it);
+        }
+      }
+      _finished.clear();
+    }
+
+    void _accept_loop() {
+      while (!_stop) {
+        {
+          std::lock_guard<std::mutex> lock(_mutex);
+          _reap();
+        }
+        struct pollfd p = {_listen, POLLIN, 0};
+        if (poll(&p, 1, 100) <= 0) {
+          continue;
+        }
+        int fd = accept(_listen, NULL, NULL);
+        if (fd < 0) {
+          continue;
+        }
+        std::lock_guard<std::mutex> lock(_mutex);
+        _connections.insert(fd);
+        std::thread t(&ShardServer::_serve, this, fd);
+        std::thread::id id = t.get_id();
+        _threads[id].swap(t);
+      }
+    }
+
+    void _serve(int fd) {
+      AnnoyIndexInterface<S, T>* index = _index;
+      auto query = [index](const T* w, size_t n, size_t search_k, vector<S>* result, vector<T>* distances) {
+        index->get_nns_by_vector(w, n, search_k, result, distances);
+      };
+      query_header h;
+      vector<char> body, reply;
+      while (rpc_read(fd, &h, sizeof(h))) {
+        size_t rest = h.size + sizeof(uint32_t);
+        if (rest < sizeof(h) || rest > RPC_MAX_MESSAGE) {
+          break;
+        }
+        body.resize(rest - sizeof(h));
+        if (!body.empty() && !rpc_read(fd, &body[0], body.size())) {
+          break;
+        }
+        reply.clear();
+        rpc_answer<S, T>(query, _f, h, body.empty() ? NULL : &body[0], &reply);
+        if (!rpc_write(fd, &reply[0], reply.size())) {
+          break;
+        }
+      }
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (_connections.erase(fd)) {
+        close(fd);
+      }
+      _finished.push_back(std::this_thread::get_id());
+    }
+
+  public:
+    ShardServer(AnnoyIndexInterface<S, T>* index, int f) : _index(index), _f(f) {
+      _listen = -1;
+      _stop = false;
+    }
+
+    ~ShardServer() {
+      stop();
+    }
+
+    bool start(const char* path) {
+      stop();
+      _listen = rpc_listen(path);
+      if (_listen < 0) {
+        return false;
+      }
+      _path = path;
+      _stop = false;
+      _acceptor = std::thread(&ShardServer::_accept_loop, this);
+      return true;
+    }
+
+    void stop() {
+      if (_listen < 0) {
+        return;
+      }
+      _stop = true;
+      _acceptor.join();
+      std::map<std::thread::id, std::thread> threads;
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (std::set<int>::iterator it = _connections.begin(); it != _connections.end(); ++it) {
+          shutdown(*it, SHUT_RDWR); // wakes the reads of the connection threads
+        }
+        threads.swap(_threads);
+        _finished.clear();
+      }
+      for (std::map<std::thread::id, std::thread>::iterator it = threads.begin(); it != threads.end(); ++it) {
+        it->second.join();
+      }
+      close(_listen);
+      unlink(_path.c_str());
+      _listen = -1;
+    }
+};
+
+// Fans queries out to the shard processes of a forest partitioned by item
+// (see AnnoyShardedIndex), each serving its part with a ShardServer, and
+// merges their top n lists. A shard may have several replicas: a query goes
+// to one of them, in turn, and once hedge_ms pass without an answer the
+// same query goes to the next one too, the first answer winning. A replica
+// that fails is replaced at once. Shards that have not answered after
+// deadline_ms are left out, so a slow shard costs recall, not latency.
+template<typename S, typename T>
+class ScatterGather {
+  protected:
+    struct Call {
+      int fd;
+      int shard;
+      int replica;
+      vector<char> reply;
+      size_t got;
+    };
+
+    int _f;
+    vector<vector<string> > _shards; // replica socket paths by shard
+    int _hedge_ms;
+    int _deadline_ms;
+    uint32_t _next_id;
+    vector<size_t> _turn; // replica to try first, by shard
+    vector<vector<vector<int> > > _idle; // pooled connections by shard and replica
+    std::mutex _mutex;
+
+    // sends the request on a pooled or new connection to a replica
+    bool _send(Call* call, const vector<char>& request) {
+      int fd = -1;
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        vector<int>& idle = _idle[call->shard][call->replica];
+        if (!idle.empty()) {
+          fd = idle.back();
+          idle.pop_back();
+        }
+      }
+      if (fd < 0) {
+        fd = rpc_connect(_shards[call->shard][call->replica].c_str());
+      }
+      if (fd < 0) {
+        return false;
+      }
+      if (!rpc_write(fd, &request[0], request.size())) {
+        // a pooled connection the replica closed, try a fresh one once
+        close(fd);
+        fd = rpc_connect(_shards[call->shard][call->replica].c_str());
+        if (fd < 0 || !rpc_write(fd, &request[0], request.size())) {
+          if (fd >= 0) {
+            close(fd);
+          }
+          return false;
+        }
+      }
+      call->fd = fd;
+      call->reply.resize(sizeof(uint32_t));
+      call->got = 0;
+      return true;
+    }
+
+    // starts a call to the next replica of shard not tried yet
+    bool _hedge(int shard, vector<int>& tried, vector<Call>& calls, const vector<char>& request) {
+      size_t replicas = _shards[shard].size();
+      while ((size_t) tried[shard] < replicas) {
+        Call call;
+        call.shard = shard;
+        call.replica = (_turn[shard] + tried[shard]++) % replicas;
+        if (_send(&call, request)) {
+          calls.push_back(call);
+          return true;
+        }
+      }
+      return false;
+    }
+
+    // reads what is there, true once the reply is complete or failed
+    bool _receive(Call& call, bool& failed) {
+      ssize_t r = read(call.fd, &call.reply[call.got], call.reply.size() - call.got);
+      if (r < 0 && (errno == EINTR || errno == EAGAIN)) {
+        return false;
+      }
+      if (r <= 0) {
+        failed = true;
+        return true;
+      }
+      call.got += r;
+      if (call.got == sizeof(uint32_t) && call.reply.size() == sizeof(uint32_t)) {
+        uint32_t size;
+        memcpy(&size, &call.reply[0], sizeof(size));
+        if (size + sizeof(uint32_t) < sizeof(reply_header) || size > RPC_MAX_MESSAGE) {
+          failed = true;
+          return true;
+        }
+        call.reply.resize(sizeof(uint32_t) + size);
+      }
+      return call.got == call.reply.size();
+    }
+
+  public:
+    ScatterGather(int f, const vector<vector<string> >& shards, int hedge_ms, int deadline_ms)
+      : _f(f), _shards(shards), _hedge_ms(hedge_ms), _deadline_ms(deadline_ms) {
+      _next_id = 0;
+      _turn.resize(shards.size(), 0);
+      _idle.resize(shards.size());
+      for (size_t s = 0; s < shards.size(); s++) {
+        _idle[s].resize(shards[s].size());
+      }
+    }
+
+    ~ScatterGather() {
+      for (size_t s = 0; s < _idle.size(); s++) {
+        for (size_t r = 0; r < _idle[s].size(); r++) {
+          for (size_t i = 0; i < _idle[s][r].size(); i++) {
+            close(_idle[s][r][i]);
+          }
+        }
+      }
+    }
+
+    // returns the number of shards that answered in time
+    int get_nns_by_vector(const T* w, size_t n, size_t search_k, vector<S>* result, vector<T>* distances) {
+      typedef std::chrono::steady_clock clock;
+      clock::time_point start = clock::now();
+      clock::time_point hedge_at = start + std::chrono::milliseconds(_hedge_ms);
+      clock::time_point deadline = start + std::chrono::milliseconds(_deadline_ms);
+
+      query_header h;
+      h.size = sizeof(h) - sizeof(uint32_t) + _f * sizeof(T);
+      h.op = RPC_QUERY;
+      h.f = _f;
+      h.count = 1;
+      h.n = n;
+      h.search_k = (int32_t) search_k;
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        h.id = _next_id++;
+        for (size_t s = 0; s < _turn.size(); s++) {
+          _turn[s]++;
+        }
+      }
+      vector<char> request(sizeof(h) + _f * sizeof(T));
+      memcpy(&request[0], &h, sizeof(h));
+      memcpy(&request[sizeof(h)], w, _f * sizeof(T));
+
+      int shards = _shards.size();
+      vector<int> tried(shards, 0);
+      vector<char> done(shards, 0);
+      vector<vector<S> > ids(shards);
+      vector<vector<T> > dists(shards);
+      vector<Call> calls;
+      for (int s = 0; s < shards; s++) {
+        _hedge(s, tried, calls, request);
+      }
+
+      bool hedged = false;
+      int answered = 0;
+      while (!calls.empty()) {
+        clock::time_point now = clock::now();
+        if (now >= deadline) {
+          break;
+        }
+        if (!hedged && now >= hedge_at) {
+          hedged = true;
+          for (int s = 0; s < shards; s++) {
+            if (!done[s]) {
+              _hedge(s, tried, calls, request);
+            }
+          }
+        }
+        clock::time_point wake = hedged ? deadline : std::min(hedge_at, deadline);
+        int timeout = (int) std::chrono::duration_cast<std::chrono::milliseconds>(wake - now).count() + 1;
+        vector<struct pollfd> fds(calls.size());
+        for (size_t i = 0; i < calls.size(); i++) {
+          fds[i].fd = calls[i].fd;
+          fds[i].events = POLLIN;
+          fds[i].revents = 0;
+        }
+        if (poll(&fds[0], fds.size(), timeout) <= 0) {
+          continue;
+        }
+
+        vector<Call> pending;
+        vector<int> failed_shards;
+        for (size_t i = 0; i < calls.size(); i++) {
+          Call& call = calls[i];
+          bool failed = false;
+          if (done[call.shard]) {
+            close(call.fd); // the hedge lost, its reply would be stale
+            continue;
+          }
+          if (!fds[i].revents || !_receive(call, failed)) {
+            pending.push_back(call);
+            continue;
+          }
+          reply_header r;
+          if (!failed) {
+            memcpy(&r, &call.reply[0], sizeof(r));
+            failed = r.id != h.id || r.status != RPC_OK || r.count != 1;
+          }
+          if (failed) {
+            close(call.fd);
+            failed_shards.push_back(call.shard);
+            continue;
+          }
+          const char* p = &call.reply[sizeof(r)];
+          uint32_t m;
+          memcpy(&m, p, sizeof(m));
+          if (sizeof(r) + sizeof(m) + m * (sizeof(S) + sizeof(T)) != call.reply.size()) {
+            close(call.fd);
+            failed_shards.push_back(call.shard);
+            continue;
+          }
+          ids[call.shard].resize(m);
+          dists[call.shard].resize(m);
+          if (m > 0) {
+            memcpy(&ids[call.shard][0], p + sizeof(m), m * sizeof(S));
+            memcpy(&dists[call.shard][0], p + sizeof(m) + m * sizeof(S), m * sizeof(T));
+          }
+          done[call.shard] = 1;
+          answered++;
+          std::lock_guard<std::mutex> lock(_mutex);
+          _idle[call.shard][call.replica].push_back(call.fd);
+        }
+        calls.clear();
+        for (size_t i = 0; i < pending.size(); i++) {
+          if (done[pending[i].shard]) {
+            close(pending[i].fd);
+          } else {
+            calls.push_back(pending[i]);
+          }
+        }
+        for (size_t i = 0; i < failed_shards.size(); i++) {
+          int s = failed_shards[i];
+          bool in_flight = false;
+          for (size_t j = 0; j < calls.size(); j++) {
+            in_flight = in_flight || calls[j].shard == s;
+          }
+          if (!done[s] && !in_flight) {
+            _hedge(s, tried, calls, request);
+          }
+        }
+      }
+      for (size_t i = 0; i < calls.size(); i++) {
+        close(calls[i].fd);
+      }
+
+      // k-way merge, each list is sorted by distance
+      typedef pair<T, int> Head; // distance, shard
+      std::priority_queue<Head, vector<Head>, std::greater<Head> > heads;
+      vector<size_t> next(shards, 0);
+      for (int s = 0; s < shards; s++) {
+        if (!dists[s].empty()) {
+          heads.push(make_pair(dists[s][0], s));
+        }
+      }
+      while (!heads.empty() && result->size() < n) {
+        int s = heads.top().second;
+        heads.pop();
+        result->push_back(ids[s][next[s]]);
+        if (distances) {
+          distances->push_back(dists[s][next[s]]);
+        }
+        if (++next[s] < dists[s].size()) {
+          heads.push(make_pair(dists[s][next[s]], s));
+        }
+      }
+      return answered;
+    }
+};
+
+#endif
+// vim: tabstop=2 shiftwidth=2
@@ -0,0 +1,436 @@
+// Copyright (c) 2013 Spotify AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+// Standalone query server over one read only index, speaking the protocol
+// of annoyrpc.h on a Unix socket or on TCP, so ScatterGather can use it as
+// a shard process too.
+//
+// One thread runs an epoll loop: it reads requests off the connections and
+// queues them, and writes the replies back. A fixed pool of workers answers
+// them, each through its own reader (see AnnoyIndex::begin_reader), so
+// queries run in parallel without sharing a transaction. Once max_queue
+// requests wait, new ones are refused at once with RPC_BUSY, which keeps
+// the queueing delay, and so the tail latency, bounded.
+//
+// Build from the repository root with make annoy_server, into build/native.
+//
+// Usage:
+//   annoy_server -d dir -f dim -t trees [-K leaf_size] [-F flat_file]
+//                (-u socket_path | -p host:port) [-w workers] [-q max_queue]
+//                [-W warm_levels]
+
+#include "annoylib.h"
+#include "kissrandom.h"
+#include "annoyrpc.h"
+#include <signal.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <deque>
+#include <memory>
+#include <condition_variable>
+
+typedef AnnoyIndex<int32_t, float, Angular, Kiss64Random> Index;
+
+struct Connection {
+  int fd;
+  vector<char> in; // bytes read and not parsed yet, event loop only
+  std::mutex mutex; // guards out and closed
+  vector<char> out;
+  bool closed;
+  bool writing; // waiting for EPOLLOUT
+};
+
+struct Job {
+  std::shared_ptr<Connection> connection;
+  query_header h;
+  vector<char> body;
+};
+
+static int wake_fd = -1;
+static volatile sig_atomic_t stopping = 0;
+
+static void on_signal(int) {
+  stopping = 1;
+  uint64_t one = 1;
+  if (write(wake_fd, &one, sizeof(one))) {}
+}
+
+class Server {
+  protected:
+    Index* _index;
+    int _f;
+    size_t _max_queue;
+    int _epoll;
+    int _listen;
+
+    std::map<int, std::shared_ptr<Connection> > _connections;
+
+    std::mutex _queue_mutex;
+    std::condition_variable _queue_cv;
+    std::deque<Job> _queue;
+    bool _stop;
+    vector<std::thread> _workers;
+
+    std::mutex _ready_mutex;
+    vector<std::shared_ptr<Connection> > _ready; // with replies to write
+
+    size_t _queued;
+    size_t _refused;
+
+    void _work() {
+      MDB_txn* reader = _index->begin_reader();
+      Index* index = _index;
+      auto query = [index, reader](const float* w, size_t n, size_t search_k,
+                                   vector<int32_t>* result, vector<float>* distances) {
+        index->get_nns_by_vector(reader, w, n, search_k, result, distances);
+      };
+      vector<char> reply;
+      while (true) {
+        Job job;
+        {
+          std::unique_lock<std::mutex> lock(_queue_mutex);
+          _queue_cv.wait(lock, [this]() { return _stop || !_queue.empty(); });
+          if (_queue.empty()) {
+            break;
+          }
+          job = _queue.front();
+          _queue.pop_front();
+        }
+        reply.clear();
+        rpc_answer<int32_t, float>(query, _f, job.h, job.body.empty() ? NULL : &job.body[0], &reply);
+        _send(job.connection, reply);
+      }
+      _index->end_reader(reader);
+    }
+
+    // hands a reply to the event loop
+    void _send(const std::shared_ptr<Connection>& c, const vector<char>& reply) {
+      {
+        std::lock_guard<std::mutex> lock(c->mutex);
+        if (c->closed) {
+          return;
+        }
+        c->out.insert(c->out.end(), reply.begin(), reply.end());
+      }
+      {
+        std::lock_guard<std::mutex> lock(_ready_mutex);
+        _ready.push_back(c);
+      }
+      uint64_t one = 1;
+      if (write(wake_fd, &one, sizeof(one))) {}
+    }
+
+    void _close(const std::shared_ptr<Connection>& c) {
+      std::lock_guard<std::mutex> lock(c->mutex);
+      if (c->closed) {
+        return;
+      }
+      c->closed = true;
+      epoll_ctl(_epoll, EPOLL_CTL_DEL, c->fd, NULL);
+      close(c->fd);
+      _connections.erase(c->fd);
+    }
+
+    // writes what the socket takes, then waits for EPOLLOUT for the rest
+    void _flush(const std::shared_ptr<Connection>& c) {
+      bool failed = false;
+      {
+        std::lock_guard<std::mutex> lock(c->mutex);
+        if (c->closed) {
+          return;
+        }
+        size_t sent = 0;
+        while (sent < c->out.size()) {
+          ssize_t r = send(c->fd, &c->out[sent], c->out.size() - sent, MSG_NOSIGNAL);
+          if (r < 0 && errno == EINTR) {
+            continue;
+          }
+          if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+          }
+          if (r <= 0) {
+            failed = true;
+            break;
+          }
+          sent += r;
+        }
+        c->out.erase(c->out.begin(), c->out.begin() + sent);
+        bool writing = !c->out.empty();
+        if (!failed && writing != c->writing) {
+          struct epoll_event e;
+          e.events = EPOLLIN | (writing ? (uint32_t) EPOLLOUT : 0u);
+          e.data.fd = c->fd;
+          epoll_ctl(_epoll, EPOLL_CTL_MOD, c->fd, &e);
+          c->writing = writing;
+        }
+      }
+      if (failed) {
+        _close(c);
+      }
+    }
+
+    void _accept() {
+      while (true) {
+        int fd = accept(_listen, NULL, NULL);
+        if (fd < 0) {
+          return;
+        }
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)); // fails harmlessly on Unix sockets
+        std::shared_ptr<Connection> c(new Connection());
+        c->fd = fd;
+        c->closed = false;
+        c->writing = false;
+        _connections[fd] = c;
+        struct epoll_event e;
+        e.events = EPOLLIN;
+        e.data.fd = fd;
+        epoll_ctl(_epoll, EPOLL_CTL_ADD, fd, &e);
+      }
+    }
+
+    // reads what is there and queues the complete requests
+    void _read(const std::shared_ptr<Connection>& c) {
+      char buf[65536];
+      while (true) {
+        ssize_t r = read(c->fd, buf, sizeof(buf));
+        if (r < 0 && errno == EINTR) {
+          continue;
+        }
+        if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+          break;
+        }
+        if (r <= 0) {
+          _close(c);
+          return;
+        }
+        c->in.insert(c->in.end(), buf, buf + r);
+      }
+
+      size_t at = 0;
+      vector<char> refusals;
+      while (c->in.size() - at >= sizeof(uint32_t)) {
+        uint32_t size;
+        memcpy(&size, &c->in[at], sizeof(size));
+        size_t total = size + sizeof(uint32_t);
+        if (total < sizeof(query_header) || total > RPC_MAX_MESSAGE) {
+          _close(c);
+          return;
+        }
+        if (c->in.size() - at < total) {
+          break;
+        }
+        Job job;
+        memcpy(&job.h, &c->in[at], sizeof(query_header));
+        job.body.assign(c->in.begin() + at + sizeof(query_header), c->in.begin() + at + total);
+        at += total;
+        std::unique_lock<std::mutex> lock(_queue_mutex);
+        if (_queue.size() >= _max_queue) {
+          lock.unlock();
+          rpc_refuse(job.h.id, RPC_BUSY, &refusals);
+          _refused++;
+          continue;
+        }
+        job.connection = c;
+        _queue.push_back(job);
+        _queued++;
+        lock.unlock();
+        _queue_cv.notify_one();
+      }
+      c->in.erase(c->in.begin(), c->in.begin() + at);
+      if (!refusals.empty()) {
+        {
+          std::lock_guard<std::mutex> lock(c->mutex);
+          c->out.insert(c->out.end(), refusals.begin(), refusals.end());
+        }
+        _flush(c);
+      }
+    }
+
+  public:
+    Server(Index* index, int f, size_t max_queue) : _index(index), _f(f), _max_queue(max_queue) {
+      _epoll = -1;
+      _listen = -1;
+      _stop = false;
+      _queued = 0;
+      _refused = 0;
+    }
+
+    void run(int listen_fd, int workers) {
+      _listen = listen_fd;
+      fcntl(_listen, F_SETFL, fcntl(_listen, F_GETFL) | O_NONBLOCK);
+      _epoll = epoll_create1(0);
+      struct epoll_event e;
+      e.events = EPOLLIN;
+      e.data.fd = _listen;
+      epoll_ctl(_epoll, EPOLL_CTL_ADD, _listen, &e);
+      e.data.fd = wake_fd;
+      epoll_ctl(_epoll, EPOLL_CTL_ADD, wake_fd, &e);
+
+      for (int i = 0; i < workers; i++) {
+        _workers.push_back(std::thread(&Server::_work, this));
+      }
+
+      vector<struct epoll_event> events(256);
+      while (!stopping) {
+        int n = epoll_wait(_epoll, &events[0], events.size(), -1);
+        for (int i = 0; i < n; i++) {
+          int fd = events[i].data.fd;
+          if (fd == _listen) {
+            _accept();
+          } else if (fd == wake_fd) {
+            uint64_t count;
+            if (read(wake_fd, &count, sizeof(count))) {}
+            vector<std::shared_ptr<Connection> > ready;
+            {
+              std::lock_guard<std::mutex> lock(_ready_mutex);
+              ready.swap(_ready);
+            }
+            for (size_t j = 0; j < ready.size(); j++) {
+              _flush(ready[j]);
+            }
+          } else {
+            std::map<int, std::shared_ptr<Connection> >::iterator it = _connections.find(fd);
+            if (it == _connections.end()) {
+              continue;
+            }
+            std::shared_ptr<Connection> c = it->second;
+            if (events[i].events & EPOLLOUT) {
+              _flush(c);
+            }
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+              _read(c);
+            }
+          }
+        }
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(_queue_mutex);
+        _stop = true;
+        _queue.clear();
+      }
+      _queue_cv.notify_all();
+      for (size_t i = 0; i < _workers.size(); i++) {
+        _workers[i].join();
+      }
+      while (!_connections.empty()) {
+        std::shared_ptr<Connection> c = _connections.begin()->second;
+        _close(c);
+      }
+      close(_epoll);
+      printf("%zu requests queued, %zu refused\n", _queued, _refused);
+    }
+};
+
+static int listen_tcp(const char* address) {
+  string a(address);
+  size_t colon = a.rfind(':');
+  if (colon == string::npos) {
+    return -1;
+  }
+  string host = a.substr(0, colon), port = a.substr(colon + 1);
+  struct addrinfo hints, *res;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = AI_PASSIVE;
+  if (getaddrinfo(host.empty() ? NULL : host.c_str(), port.c_str(), &hints, &res) != 0) {
+    return -1;
+  }
+  int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+  int one = 1;
+  if (fd >= 0) {
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(fd, res->ai_addr, res->ai_addrlen) != 0 || listen(fd, 1024) != 0) {
+      close(fd);
+      fd = -1;
+    }
+  }
+  freeaddrinfo(res);
+  return fd;
+}
+
+static void usage() {
+  fprintf(stderr, "usage: annoy_server -d dir -f dim -t trees [-K leaf_size] [-F flat_file]\n"
+                  "                    (-u socket_path | -p host:port) [-w workers] [-q max_queue]\n"
+                  "                    [-W warm_levels]\n");
+  exit(1);
+}
+
+int main(int argc, char** argv) {
+  const char* dir = NULL;
+  const char* flat = NULL;
+  const char* unix_path = NULL;
+  const char* tcp = NULL;
+  int f = 0, trees = 0, K = 10, warm_levels = 8;
+  int workers = std::max(1, (int) std::thread::hardware_concurrency());
+  size_t max_queue = 1024;
+  int opt;
+  while ((opt = getopt(argc, argv, "d:f:t:K:F:u:p:w:q:W:")) != -1) {
+    switch (opt) {
+      case 'd': dir = optarg; break;
+      case 'f': f = atoi(optarg); break;
+      case 't': trees = atoi(optarg); break;
+      case 'K': K = atoi(optarg); break;
+      case 'F': flat = optarg; break;
+      case 'u': unix_path = optarg; break;
+      case 'p': tcp = optarg; break;
+      case 'w': workers = atoi(optarg); break;
+      case 'q': max_queue = atol(optarg); break;
+      case 'W': warm_levels = atoi(optarg); break;
+      default: usage();
+    }
+  }
+  if (dir == NULL || f <= 0 || trees <= 0 || (unix_path == NULL) == (tcp == NULL) || workers <= 0) {
+    usage();
+  }
+
+  // a reader slot for every worker on top of the index's own
+  Index index(f, K, trees, dir, std::max(126, workers + 8), 0, 1);
+  if (flat != NULL && !index.load(flat)) {
+    fprintf(stderr, "can not load %s\n", flat);
+    return 1;
+  }
+  if (warm_levels > 0) {
+    index.warm_up(warm_levels, false, false, 0);
+  }
+
+  int listen_fd = unix_path ? rpc_listen(unix_path) : listen_tcp(tcp);
+  if (listen_fd < 0) {
+    fprintf(stderr, "can not listen on %s: %s\n", unix_path ? unix_path : tcp, strerror(errno));
+    return 1;
+  }
+  wake_fd = eventfd(0, EFD_NONBLOCK);
+  signal(SIGINT, on_signal);
+  signal(SIGTERM, on_signal);
+  signal(SIGPIPE, SIG_IGN);
+  printf("serving %s on %s with %d workers\n", dir, unix_path ? unix_path : tcp, workers);
+  fflush(stdout);
+
+  Server server(&index, f, max_queue);
+  server.run(listen_fd, workers);
+  close(listen_fd);
+  if (unix_path) {
+    unlink(unix_path);
+  }
+  return 0;
+}
+
+// vim: tabstop=2 shiftwidth=2
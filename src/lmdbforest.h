@@ -9,9 +9,17 @@
 #include <stdlib.h>
 #include <memory.h>
 #include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <exception>
 
 #include <sys/stat.h> 
 #include <fcntl.h>
+#include <errno.h>
 #include <unistd.h>
 #include <ios>
 #include <iostream>
@@ -27,20 +35,67 @@
 
 #include <vector>
 #include <map>
+#include <queue>
+#include <deque>
+#include <set>
 #include "lmdb.h"
 
 #include "annoylib.h"
+#include "pq.h"
 #include "protobuf/annoy.pb.h"
 
 #define E(expr) CHECK((rc = (expr)) == MDB_SUCCESS, #expr)
 #define RES(err, expr) ((rc = expr) == (err) || (CHECK(!rc, #expr), 0))
 #define CHECK(test, msg) ((test) ? (void)0 : ((void)fprintf(stderr, \
-"%s:%d: %s: %s\n", __FILE__, __LINE__, msg, mdb_strerror(rc)), abort()))
+"%s:%d: %s: %s\n", __FILE__, __LINE__, msg, mdb_strerror(rc)), ANNOY_FAIL(rc)))
+
+// what a failed CHECK does with the LMDB error; an embedder that wants the
+// error back instead (see annoyc.cc) defines it to throw before the include
+#ifndef ANNOY_FAIL
+#define ANNOY_FAIL(rc) abort()
+#endif
 
 
 #define DBN_ROOT "root"
 #define DBN_RAW "raw"
 #define DBN_TREE "tree"
+#define DBN_META "meta"
+#define DBN_CODE "code"
+
+// durability of commits, see set_durability
+enum {
+  DURABILITY_SYNC = 0,        // fsync data and meta page on every commit
+  DURABILITY_NOMETASYNC = 1,  // MDB_NOMETASYNC: the last commit may roll back after a crash
+  DURABILITY_NOSYNC = 2       // MDB_NOSYNC | MDB_MAPASYNC: the OS writes back, flush() syncs
+};
+
+// order of the node keys written by compact_trees
+enum {
+  LAYOUT_VEB = 0, // van Emde Boas: the top half of the levels of a subtree, then each subtree below them
+  LAYOUT_BFS = 1  // level by level
+};
+
+#define META_KEY "meta"
+#define PQ_KEY "pq"
+
+// bytes of a leaf page not available to the leaf's records, see
+// set_leaf_page_size
+#define LEAF_OVERHEAD 64
+
+// the map grows by this factor when a write finds it full, and ahead of a
+// write once more than MAP_HIGH_WATER of it is in use
+#ifndef MAP_GROWTH
+#define MAP_GROWTH 2
+#endif
+#ifndef MAP_HIGH_WATER
+#define MAP_HIGH_WATER 0.75
+#endif
+
+// how many records ahead of the one being scored are prefetched when
+// candidates are read in key order
+#ifndef PREFETCH_AHEAD
+#define PREFETCH_AHEAD 4
+#endif
 
 
 using namespace std;
@@ -52,15 +107,125 @@ using namespace std;
  1. Database DBN_RAW would use the id as the key for objs,
  store the raw vector values for each sample
  
- 2. Database DBN_TREE would store the roots, the internal 
- nodes, as well as leaf nodes for the tree. 
+ 2. Database DBN_TREE.<t> would store the root, the internal 
+ nodes, as well as leaf nodes of tree t, so the pages of a tree only
+ hold its own nodes and a tree is dropped at the DBI level.
  
-    2.1 the keys for roots are "rt". the values are all the keys of the roots
+    2.1 node keys are local to the tree, the root is key 0. Indexes
+        written before (index_meta.tree_dbs unset) keep all trees in
+        DBN_TREE, with the root of tree t at key t
     2.2 each node of the tree is stored as a protobuf obj tree_node
     2.3 leaf node would have an array of pointers to the raw data
+    2.4 leaves of the first _leaf_embed_trees trees also carry leaf_data,
+        the records of their items back to back in the format the query
+        scores (see _record_size), so a leaf is scored in one scan
  
+ With a half precision vector type (VECTOR_FLOAT16/VECTOR_BFLOAT16) the
+ vectors of DBN_RAW and the hyperplanes of DBN_TREE are kept as 16 bit
+ values in data_info.hdata and tree_node.hv instead of data and v.
+
+ 3. Database DBN_META holds a single index_meta record under META_KEY,
+ describing how the index is stored (e.g. the codec below), and the
+ pq_codebook of the product quantizer under PQ_KEY
+
+ 4. Database DBN_CODE is only filled when the codec is not CODEC_FLOAT,
+ and candidates are scored from it in place. DBN_RAW then only serves as
+ the cold copy used to rerank the best candidates exactly.
+
+    4.1 CODEC_INT8 keeps an Int8Header followed by f int8 codes per id
+    4.2 CODEC_PQ keeps the product quantizer code of the normalized vector
+
  */
 
+// shape of one tree, see get_tree_stats
+struct tree_stats {
+  size_t nodes;
+  size_t leaves;
+  size_t empty_leaves;
+  size_t items;      // over all leaves
+  int max_depth;     // of the deepest leaf, the root has depth 0
+  double mean_depth; // of the items
+};
+
+// space of the LMDB map, see get_map_usage
+struct map_usage {
+  size_t map_size;    // bytes mapped, grows on demand
+  size_t used_size;   // bytes up to the last page in use
+  size_t page_size;
+  unsigned readers;   // reader slots in use
+  unsigned max_readers;
+};
+
+// pages of an environment, see compact
+struct page_report {
+  size_t page_size;
+  size_t used_pages; // up to the last page in use
+  size_t live_pages; // in the B-trees of the main DB and the named DBs
+  size_t free_pages; // the rest, waiting for reuse or holding the free list
+};
+
+// Header of a file written by save(). It is followed by n_nodes packed
+// D::Node of node_size bytes, then the n_roots root indexes. Nodes below
+// n_items are the items, holding their vectors; a node with at most K
+// descendants lists them in children (an item lists itself), any other is
+// a split with its hyperplane in v and children[0] on the positive side.
+#define FLAT_MAGIC "annoyfl1"
+
+struct flat_header {
+  char magic[8];
+  uint32_t f;
+  uint32_t node_size;
+  uint32_t index_size; // sizeof(S)
+  uint32_t value_size; // sizeof(T)
+  uint64_t n_items;
+  uint64_t n_nodes;
+  uint64_t n_roots;
+  uint64_t K;
+  uint64_t reserved;
+};
+
+// A recursive mutex that, released while a thread waits for it in
+// wait_or_lock, notifies that thread's condition variable. The group commit
+// writer waits for the index lock this way: it can not block on it, since
+// the holder may be waiting for the writer, and it has to wake for jobs
+// too, which come on the same condition variable.
+class notifying_mutex {
+  public:
+    notifying_mutex(std::mutex& waiter_mutex, std::condition_variable& waiter_cv)
+      : _waiter_mutex(waiter_mutex), _waiter_cv(waiter_cv), _waiting(false) {}
+
+    void lock() { _m.lock(); }
+    bool try_lock() { return _m.try_lock(); }
+
+    void unlock() {
+      _m.unlock();
+      if (_waiting) {
+        std::lock_guard<std::mutex> l(_waiter_mutex);
+        _waiter_cv.notify_all();
+      }
+    }
+
+    // with waiter_mutex held in l: takes the mutex and returns true, or
+    // waits on waiter_cv until the mutex is released or the cv notified
+    // for another reason and returns false
+    bool wait_or_lock(std::unique_lock<std::mutex>& l) {
+      // set before trying, so an unlock racing with the try notifies
+      _waiting = true;
+      bool locked = _m.try_lock();
+      if (!locked) {
+        _waiter_cv.wait(l);
+      }
+      _waiting = false;
+      return locked;
+    }
+
+  private:
+    std::recursive_mutex _m;
+    std::mutex& _waiter_mutex;
+    std::condition_variable& _waiter_cv;
+    std::atomic<bool> _waiting;
+};
+
 template<typename S, typename T>
 class AnnoyIndexInterface {
 public:
@@ -78,10 +243,31 @@ public:
   virtual S get_n_items() = 0;
   virtual void verbose(bool v) = 0;
   virtual void get_item(S item, vector<T>* v) = 0;
+  virtual void set_codec(int codec) = 0;
+  virtual void set_rerank(size_t rerank_k) = 0;
+  virtual void set_vector_type(int vector_type) = 0;
+  virtual bool train_pq(int m, int nbits, size_t sample_size) = 0;
+  virtual void set_leaf_embedding(int trees) = 0;
+  virtual bool get_tree_stats(int tree, tree_stats* stats) = 0;
+  virtual size_t rebalance(double depth_ratio, double min_fill, size_t max_items) = 0;
+  virtual bool rebuild_tree(int tree) = 0;
+  virtual bool compact_trees(int layout) = 0;
+  virtual bool start_maintenance(int interval_ms, double depth_ratio, double min_fill, size_t max_items) = 0;
+  virtual void stop_maintenance() = 0;
+  virtual void set_leaf_page_size(int page_size) = 0;
+  virtual int get_leaf_capacity() = 0;
+  virtual void set_seed(uint64_t seed) = 0;
+  virtual bool set_write_buffer(size_t capacity, int flush_interval_ms) = 0;
+  virtual void flush() = 0;
+  virtual void set_group_commit(size_t max_items, int max_delay_ms) = 0;
+  virtual void set_durability(int policy) = 0;
+  virtual void get_map_usage(map_usage* usage) = 0;
+  virtual size_t warm_up(int levels, bool raw, bool lock, int budget_ms) = 0;
+  virtual bool compact(const char* dest_dir, int layout, page_report* before, page_report* after) = 0;
 
 
   virtual bool create()=0;
-  virtual void display_node(S item) = 0;
+  virtual void display_node(S item, int tree) = 0;
   virtual void display_raw(S item) = 0;
   
      
@@ -93,33 +279,124 @@ class AnnoyIndex : public AnnoyIndexInterface<S, T> {
   protected:
     Random _random;
     typedef Distance<S, T, Random> D;
+    typedef typename D::Node Node;
     bool _verbose;
     int rc; //for macro processisng
+    bool _map_full; // a put of the current write transaction hit MDB_MAP_FULL
     
   protected:
     MDB_env* _env;
     MDB_dbi _dbi_raw;
-    MDB_dbi _dbi_tree;
+    vector<MDB_dbi> _dbi_trees; // by tree, see _open_trees
+    MDB_dbi _dbi_code;
     MDB_txn* _txn;
   
     int _f ; // the dimension of data
     int _tree_count; //number of trees;
-    int _K ; // maximum size of data in each leaf node
+    int _K ; // maximum size of data in each leaf node, unless _leaf_page_size is set
+    int _leaf_page_size; // byte budget of the records of one leaf, 0 to use _K
+    int _capacity; // maximum size of data in each leaf node in effect
 
     vector<int> _roots;
 
     bool _read_only;
 
+    int _codec; // how candidates are scored, see CODEC_*
+    size_t _rerank_k; // number of quantized candidates to rerank with float vectors
+    int _vector_type; // storage type of vectors and hyperplanes, see VECTOR_*
+    ProductQuantizer<T> _pq; // codebooks used by CODEC_PQ
+    int _leaf_embed_trees; // number of trees whose leaves embed their items' records
+    bool _tree_dbs; // each tree in its own DBI, see _open_trees
+    uint64_t _seed; // see set_seed
+    vector<Random> _tree_random; // one stream per tree, derived from _seed
+    vector<SplitArena<T> > _split; // per tree scratch reused by every leaf split
+
+    // _txn and the scratch members are shared, so every method that opens a
+    // transaction holds _lock. Rebalancing plans from a read transaction of
+    // its own without _lock, and takes it for a short write transaction.
+    // Releasing it wakes the group commit writer, see _write_loop.
+    notifying_mutex _lock;
+    // read transactions open outside _lock; the map can not be resized
+    // under them, see _wait_detached
+    int _detached;
+    std::mutex _detached_mutex;
+    std::condition_variable _detached_cv;
+    std::thread _maintenance;
+    std::mutex _maintenance_mutex;
+    std::condition_variable _maintenance_cv;
+    bool _maintenance_stop;
+
+    // write buffer: recent items, searched by brute force until a flush
+    // inserts them into the forest with add_item_batch
+    size_t _buffer_capacity; // 0 when buffering is off
+    vector<S> _buffer_ids;
+    vector<T> _buffer_vectors; // rows of _f values
+    vector<T> _buffer_norms;
+    std::map<S, size_t> _buffer_rows;
+    std::thread _flusher;
+    std::mutex _flush_mutex;
+    std::condition_variable _flush_cv;
+    bool _flush_stop;
+
+    // group commit: inserts share one write transaction, opened and
+    // committed by the writer thread, since an LMDB write transaction
+    // belongs to the thread that began it. Callers hand their insert over
+    // as a job while holding _lock, and wait for it.
+    size_t _group_items; // commit once this many items are pending, 0 when off
+    int _group_delay_ms; // or once the oldest pending item is this old
+    MDB_txn* _pending;
+    vector<S> _pending_ids; // kept to replay the group into a grown map
+    vector<data_info> _pending_data;
+    vector<Random> _pending_random; // the tree streams when the group began
+    std::chrono::steady_clock::time_point _pending_since;
+    std::thread _writer;
+    std::mutex _writer_mutex;
+    std::condition_variable _writer_cv;
+    std::function<void()> _job;
+    bool _job_done;
+    bool _writer_stop;
+    int _group_error; // of a failed group commit, see _check_group
+
+    // a file written by save() and mapped by load(); when set, queries are
+    // answered from it instead of LMDB
+    void* _flat;
+    size_t _flat_size;
+    const flat_header* _flat_header;
+    const char* _flat_nodes;
+    const S* _flat_roots;
+
 
 
  public:
 
 
-    AnnoyIndex(int f, int K, int r, const char* dir, int maxreaders, uint64_t maxsize, int read_only) : _random() {
+    AnnoyIndex(int f, int K, int r, const char* dir, int maxreaders, uint64_t maxsize, int read_only) : _random(), _lock(_writer_mutex, _writer_cv) {
       _f = f;
       _tree_count = r;
       _K = K;
+      _leaf_page_size = 0;
+      _capacity = K;
       _verbose = false;
+      _codec = CODEC_FLOAT;
+      _rerank_k = 0;
+      _vector_type = VECTOR_FLOAT32;
+      _leaf_embed_trees = 0;
+      _tree_dbs = false;
+      _maintenance_stop = false;
+      _detached = 0;
+      _buffer_capacity = 0;
+      _flush_stop = false;
+      _group_items = 0;
+      _group_delay_ms = 0;
+      _pending = NULL;
+      _map_full = false;
+      _job_done = false;
+      _writer_stop = false;
+      _group_error = MDB_SUCCESS;
+      _flat = NULL;
+      _flat_size = 0;
+      _split.resize(r);
+      _reseed(Random::default_seed);
 
       //for lmdb usage
       _env = NULL;
@@ -127,8 +404,10 @@ class AnnoyIndex : public AnnoyIndexInterface<S, T> {
 
       if (read_only == 1) {
         open_as_read(dir, maxreaders);
+        _load_meta();
       } else {
         open_as_write(dir, maxreaders, maxsize);
+        _load_meta();
         create();
       }
       _read_only = (read_only == 1);
@@ -136,20 +415,23 @@ class AnnoyIndex : public AnnoyIndexInterface<S, T> {
     }
     
     ~AnnoyIndex(){
+      unload();
+      stop_maintenance();
+      set_write_buffer(0, 0);
+      set_group_commit(0, 0);
+      // the threads above are gone, nothing uses the environment any more
+      close_db();
     }
 
     bool open_as_read(const char* database_directory, int maxreaders) {
       close_db();
       E(mdb_env_create(&_env));
       E(mdb_env_set_maxreaders(_env, maxreaders));
-      E(mdb_env_set_maxdbs(_env, 100));
+      E(mdb_env_set_maxdbs(_env, std::max(100, _tree_count + 8)));
       if (_verbose)  { printf("opening db at %s ..", database_directory); fflush(stdout);}
-      E(mdb_env_open(_env, database_directory, MDB_RDONLY, 0664));
+      // readers (see begin_reader) hold a slot per transaction, not per thread
+      E(mdb_env_open(_env, database_directory, MDB_RDONLY | MDB_NOTLS, 0664));
       if (_verbose)  { printf("done.\n"); fflush(stdout);}
-      for (int i = 0; i < _tree_count; i ++)
-      {
-        _roots.push_back(i);  
-      }
       return true;
     }
     
@@ -159,12 +441,8 @@ class AnnoyIndex : public AnnoyIndexInterface<S, T> {
       E(mdb_env_create(&_env));
       E(mdb_env_set_maxreaders(_env, maxreaders));
       E(mdb_env_set_mapsize(_env, maxsize));
-      E(mdb_env_set_maxdbs(_env, 100));
+      E(mdb_env_set_maxdbs(_env, std::max(100, _tree_count + 8)));
       E(mdb_env_open(_env, database_directory, MDB_WRITEMAP, 0664));
-      for (int i = 0; i < _tree_count; i ++)
-      {
-        _roots.push_back(i);  
-      }
       return true;
     }
 
@@ -187,10 +465,174 @@ class AnnoyIndex : public AnnoyIndexInterface<S, T> {
     void set_verbose(bool v) {
         _verbose = v;
     }
+
+    // switch the candidate scoring codec, (re)encoding all the stored items
+    void set_codec(int codec) {
+      std::lock_guard<notifying_mutex> lock(_lock);
+      if (_read_only || codec == _codec) {
+        return;
+      }
+      if (codec == CODEC_PQ && !_pq.trained()) {
+        printf("ERROR: train_pq must be called before using CODEC_PQ\n");
+        return;
+      }
+      _write([&] {
+        _codec = codec;
+        _encode_all();
+        _update_capacity();
+        if (_leaf_embed_trees > 0) {
+          _embed_all();
+        }
+        _save_meta();
+        return true;
+      });
+    }
+
+    // train the product quantizer on up to sample_size stored vectors,
+    // then switch to CODEC_PQ
+    bool train_pq(int m, int nbits, size_t sample_size) {
+      std::lock_guard<notifying_mutex> lock(_lock);
+      if (_read_only) {
+        return false;
+      }
+      ProductQuantizer<T> pq;
+      if (!pq.init(_f, m, nbits)) {
+        printf("ERROR: can not code %d dimensions with %d subspaces of %d bits\n", _f, m, nbits);
+        return false;
+      }
+
+      // on a grown map the same sample is drawn and trained again
+      return _write([&] {
+        E(mdb_dbi_open(_txn, DBN_RAW, MDB_CREATE | MDB_INTEGERKEY, &_dbi_raw));
+
+        // reservoir sample of the normalized vectors
+        vector<T> sample;
+        vector<T> unit(_f);
+        size_t seen = 0;
+        MDB_val key, data;
+        MDB_cursor *cursor;
+        E(mdb_cursor_open(_txn, _dbi_raw, &cursor));
+        while (mdb_cursor_get(cursor, &key, &data, MDB_NEXT) == MDB_SUCCESS) {
+          data_info d;
+          d.ParseFromArray(data.mv_data, data.mv_size);
+          _widen(d, _vector_type);
+          _unit(d.data().data(), &unit[0]);
+          if (seen < sample_size) {
+            sample.insert(sample.end(), unit.begin(), unit.end());
+          } else {
+            size_t k = _random.index(seen + 1);
+            if (k < sample_size) {
+              std::copy(unit.begin(), unit.end(), sample.begin() + k * _f);
+            }
+          }
+          seen++;
+        }
+        mdb_cursor_close(cursor);
+
+        size_t n = sample.size() / _f;
+        if (_verbose) {
+          printf("training pq on %d of %d vectors\n", (int) n, (int) seen);
+        }
+        if (n == 0 || !pq.train(&sample[0], n, 10, _random)) {
+          printf("ERROR: %d vectors are not enough to train %d centroids\n", (int) n, 1 << nbits);
+          return false;
+        }
+        _pq = pq;
+        _save_codebook();
+        _codec = CODEC_PQ;
+        _encode_all();
+        _update_capacity();
+        if (_leaf_embed_trees > 0) {
+          _embed_all();
+        }
+        _save_meta();
+        return true;
+      });
+    }
+
+    // embed the items' records into the leaves of the first `trees` trees.
+    // Each embedding tree costs one more copy of the scored vectors, and
+    // saves one random lookup per candidate found in its leaves.
+    void set_leaf_embedding(int trees) {
+      std::lock_guard<notifying_mutex> lock(_lock);
+      if (_read_only) {
+        return;
+      }
+      _write([&] {
+        _leaf_embed_trees = std::max(0, std::min(trees, _tree_count));
+        _embed_all();
+        _save_meta();
+        return true;
+      });
+    }
+
+    // with a quantized codec, rerank the best rerank_k candidates against DBN_RAW
+    void set_rerank(size_t rerank_k) {
+      _rerank_k = rerank_k;
+    }
+
+    // switch the storage type of vectors and hyperplanes, rewriting the
+    // records already stored in DBN_RAW and DBN_TREE
+    void set_vector_type(int vector_type) {
+      std::lock_guard<notifying_mutex> lock(_lock);
+      if (_read_only || vector_type == _vector_type) {
+        return;
+      }
+      int old_type = _vector_type;
+      _write([&] {
+        E(mdb_dbi_open(_txn, DBN_RAW, MDB_CREATE | MDB_INTEGERKEY, &_dbi_raw));
+        _open_trees(MDB_CREATE);
+        _vector_type = vector_type;
+
+        MDB_val key, data;
+        MDB_cursor *cursor;
+        string data_buffer;
+        E(mdb_cursor_open(_txn, _dbi_raw, &cursor));
+        while (!_map_full && mdb_cursor_get(cursor, &key, &data, MDB_NEXT) == MDB_SUCCESS) {
+          data_info d;
+          d.ParseFromArray(data.mv_data, data.mv_size);
+          _widen(d, old_type);
+          _pack(d, data_buffer);
+          data.mv_size = data_buffer.length();
+          data.mv_data = (uint8_t*)data_buffer.c_str();
+          _put_current(cursor, &key, &data);
+        }
+        mdb_cursor_close(cursor);
+
+        for (int t = 0; t < _tree_count && !_map_full; t++) {
+          E(mdb_cursor_open(_txn, _dbi_trees[t], &cursor));
+          while (!_map_full && mdb_cursor_get(cursor, &key, &data, MDB_NEXT) == MDB_SUCCESS) {
+            tree_node tn;
+            tn.ParseFromArray(data.mv_data, data.mv_size);
+            if (tn.leaf()) {
+              continue;
+            }
+            _widen(tn, old_type);
+            _pack(tn, data_buffer);
+            data.mv_size = data_buffer.length();
+            data.mv_data = (uint8_t*)data_buffer.c_str();
+            _put_current(cursor, &key, &data);
+          }
+          mdb_cursor_close(cursor);
+        }
+
+        _update_capacity();
+        if (_leaf_embed_trees > 0) {
+          _embed_all();
+        }
+        _save_meta();
+        return true;
+      });
+    }
     
     //append data into this tree
   
     void add_item(S item, const T* w){
+      std::lock_guard<notifying_mutex> lock(_lock);
+      if (_buffer_capacity > 0) {
+        _buffer_item(item, w);
+        return;
+      }
       
       data_info d;
       for(int i = 0; i < _f; i ++ ) {
@@ -223,8 +665,76 @@ class AnnoyIndex : public AnnoyIndexInterface<S, T> {
       return;
     }
     
+    // exports the forest to one flat file, see flat_header; buffered and
+    // pending items are inserted first, so the file holds them too
     bool save(const char* filename) { 
-      return true; 
+      std::lock_guard<notifying_mutex> lock(_lock);
+      if (_flat != NULL) {
+        return false;
+      }
+      if (!_read_only) {
+        _flush_buffer();
+        _commit_pending();
+      }
+      FlatWriter w;
+      w.file = fopen(filename, "wb");
+      if (w.file == NULL) {
+        return false;
+      }
+      w.node.resize(offsetof(Node, v) + _f * sizeof(T));
+      w.K = (sizeof(T) * _f + sizeof(S) * 2) / sizeof(S);
+      w.next = 0;
+      w.failed = false;
+      flat_header h;
+      memset(&h, 0, sizeof(h));
+      _write_file(w, &h, sizeof(h)); // written again once complete
+
+      _begin_txn(MDB_RDONLY, &_txn);
+      E(mdb_dbi_open(_txn, DBN_RAW, MDB_INTEGERKEY, &_dbi_raw));
+      _open_trees(0);
+      h.n_items = _get_max_data_index() + 1;
+      MDB_val key, data;
+      MDB_cursor *cursor;
+      E(mdb_cursor_open(_txn, _dbi_raw, &cursor));
+      while (mdb_cursor_get(cursor, &key, &data, MDB_NEXT) == MDB_SUCCESS) {
+        int data_id = 0;
+        memcpy(&data_id, key.mv_data, sizeof(int));
+        while (w.next < data_id) {
+          _write_flat(w, 0, NULL, NULL); // no item with this id
+        }
+        data_info d;
+        d.ParseFromArray(data.mv_data, data.mv_size);
+        _widen(d, _vector_type);
+        S self[2] = {data_id, 0};
+        _write_flat(w, 1, self, d.data().data());
+      }
+      mdb_cursor_close(cursor);
+
+      vector<S> roots;
+      for (int t = 0; t < _tree_count; t++) {
+        std::map<int, subtree_shape> shapes;
+        _shape(_txn, _roots[t], shapes, t);
+        roots.push_back(_flatten(w, _roots[t], shapes, t));
+      }
+      mdb_txn_abort(_txn);
+
+      _write_file(w, &roots[0], roots.size() * sizeof(S));
+      memcpy(h.magic, FLAT_MAGIC, sizeof(h.magic));
+      h.f = _f;
+      h.node_size = w.node.size();
+      h.index_size = sizeof(S);
+      h.value_size = sizeof(T);
+      h.n_nodes = w.next;
+      h.n_roots = roots.size();
+      h.K = w.K;
+      w.failed |= fseek(w.file, 0, SEEK_SET) != 0;
+      _write_file(w, &h, sizeof(h));
+      w.failed |= fclose(w.file) != 0;
+      if (w.failed) {
+        remove(filename); // a partial file would not load anyway
+        return false;
+      }
+      return true;
     }
     
     void reinitialize() {
@@ -232,15 +742,118 @@ class AnnoyIndex : public AnnoyIndexInterface<S, T> {
     }
     
     void unload() {
+      std::lock_guard<notifying_mutex> lock(_lock);
+      if (_flat != NULL) {
+        munmap(_flat, _flat_size);
+        _flat = NULL;
+      }
       return;
     }
     
+    // Pulls what queries touch first into memory after a cold open: the top
+    // levels of every tree, level by level, and with raw the rest of the map
+    // (mostly DBN_RAW), or the whole file given to load(). Pages are advised
+    // MADV_WILLNEED and read, and mlocked with lock. Stops once budget_ms
+    // have passed (0 for no limit); returns the number of pages read.
+    size_t warm_up(int levels, bool raw, bool lock, int budget_ms) {
+      std::lock_guard<notifying_mutex> guard(_lock);
+      std::chrono::steady_clock::time_point deadline = budget_ms > 0
+        ? std::chrono::steady_clock::now() + std::chrono::milliseconds(budget_ms)
+        : std::chrono::steady_clock::time_point::max();
+      if (_flat != NULL) {
+        return _warm_range(_flat, _flat_size, lock, deadline);
+      }
+
+      size_t pages = 0;
+      _begin_txn(MDB_RDONLY, &_txn);
+      _open_trees(0);
+      vector<pair<int, int> > level; // tree and node
+      for (int t = 0; t < _tree_count; t++) {
+        level.push_back(make_pair(t, _roots[t]));
+      }
+      for (int l = 0; l < levels && !level.empty(); l++) {
+        vector<pair<int, int> > next;
+        for (size_t k = 0; k < level.size() && std::chrono::steady_clock::now() < deadline; k++) {
+          int index = level[k].second;
+          MDB_val key, data;
+          key.mv_data = (uint8_t*) & index;
+          key.mv_size = sizeof(int);
+          if (mdb_get(_txn, _dbi_trees[level[k].first], &key, &data) != MDB_SUCCESS) {
+            continue;
+          }
+          pages += _warm_range(data.mv_data, data.mv_size, lock, deadline);
+          tree_node tn;
+          tn.ParseFromArray(data.mv_data, data.mv_size);
+          if (!tn.leaf()) {
+            next.push_back(make_pair(level[k].first, tn.left()));
+            next.push_back(make_pair(level[k].first, tn.right()));
+          }
+        }
+        if (_verbose) {
+          printf("warm up: level %d, %d nodes, %d pages\n", l, (int) level.size(), (int) pages);
+        }
+        level.swap(next);
+      }
+
+      if (raw) {
+        MDB_envinfo info;
+        map_usage usage;
+        E(mdb_env_info(_env, &info));
+        _map_usage(&usage);
+        pages += _warm_range(info.me_mapaddr, usage.used_size, lock, deadline);
+        if (_verbose) {
+          printf("warm up: map, %d pages\n", (int) pages);
+        }
+      }
+      mdb_txn_abort(_txn);
+      return pages;
+    }
+
+    // maps a file written by save(), queries are answered from it until
+    // unload()
     bool load(const char* filename)  {
+      std::lock_guard<notifying_mutex> lock(_lock);
+      unload();
+      int fd = open(filename, O_RDONLY, (int)0400);
+      if (fd == -1) {
+        return false;
+      }
+      off_t size = lseek(fd, 0, SEEK_END);
+      if (size < (off_t) sizeof(flat_header)) {
+        close(fd);
+        return false;
+      }
+      void* flat = mmap(0, size, PROT_READ, MAP_SHARED, fd, 0);
+      close(fd);
+      if (flat == MAP_FAILED) {
+        return false;
+      }
+      const flat_header* h = (const flat_header*) flat;
+      size_t node_size = offsetof(Node, v) + _f * sizeof(T);
+      if (memcmp(h->magic, FLAT_MAGIC, sizeof(h->magic)) != 0 || h->f != (uint32_t) _f
+          || h->node_size != node_size || h->index_size != sizeof(S) || h->value_size != sizeof(T)
+          || (uint64_t) size < sizeof(flat_header) + h->n_nodes * node_size + h->n_roots * sizeof(S)) {
+        munmap(flat, size);
+        return false;
+      }
+      _flat = flat;
+      _flat_size = size;
+      _flat_header = h;
+      _flat_nodes = (const char*) flat + sizeof(flat_header);
+      _flat_roots = (const S*) (_flat_nodes + h->n_nodes * node_size);
       return true;
     }
     
     T get_distance(S i, S j) {
-      E(mdb_txn_begin(_env, NULL, MDB_RDONLY, &_txn));
+      std::lock_guard<notifying_mutex> lock(_lock);
+      if (_flat != NULL) {
+        if (!_flat_item(i) || !_flat_item(j)) {
+          return 0;
+        }
+        vector<T> u(_f), v(_f);
+        return D::distance(_flat_vector(i, &u[0]), _flat_vector(j, &v[0]), _f);
+      }
+      _begin_txn(MDB_RDONLY, &_txn);
       E(mdb_dbi_open(_txn, DBN_RAW, MDB_CREATE, &_dbi_raw));
       
       
@@ -264,14 +877,22 @@ class AnnoyIndex : public AnnoyIndexInterface<S, T> {
 
 
     void get_nns_by_item(S item, size_t n, size_t search_k, vector<S>* result, vector<T>* distances) {
+      std::lock_guard<notifying_mutex> lock(_lock);
       data_info d;
       vector<T> v;
   
      if (_verbose) {
         printf("c++: get_nns_by_item %d, %d\n", n, search_k);
       }
+      if (_flat != NULL) {
+        if (_flat_item(item)) {
+          vector<T> v(_f);
+          _get_all_nns_flat(_flat_vector(item, &v[0]), n, search_k, result, distances);
+        }
+        return;
+      }
           
-      E(mdb_txn_begin(_env, NULL, MDB_RDONLY, &_txn));
+      _begin_txn(MDB_RDONLY, &_txn);
       E(mdb_dbi_open(_txn, DBN_RAW, MDB_CREATE, &_dbi_raw));
       
       bool fetch_result = _get_raw_data(item, d);
@@ -291,24 +912,146 @@ class AnnoyIndex : public AnnoyIndexInterface<S, T> {
 
     void get_nns_by_vector(const T* w, size_t n, size_t search_k, 
       vector<S>* result, vector<T>* distances) {
+      std::lock_guard<notifying_mutex> lock(_lock);
       
       if (_verbose) {
         printf("c++: get_nns_by_vector %d, %d\n", n, search_k);
       }
+      if (_flat != NULL) {
+        _get_all_nns_flat(w, n, search_k, result, distances);
+        return;
+      }
 
-      E(mdb_txn_begin(_env, NULL, MDB_RDONLY, &_txn));
+      _begin_txn(MDB_RDONLY, &_txn);
       E(mdb_dbi_open(_txn, DBN_RAW, MDB_INTEGERKEY, &_dbi_raw));
-      E(mdb_dbi_open(_txn, DBN_TREE, MDB_INTEGERKEY, &_dbi_tree));
+      _open_trees(0);
+      if (_codec != CODEC_FLOAT) {
+        E(mdb_dbi_open(_txn, DBN_CODE, MDB_INTEGERKEY, &_dbi_code));
+      }
 
-      _get_all_nns(w, n, search_k, result, distances);
+      _get_all_nns(_txn, w, n, search_k, result, distances);
       mdb_txn_abort(_txn);
       
       return ;
     }
 
-    void _get_all_nns(const T* v, size_t n, size_t search_k, vector<S>* result, vector<T>* distances) {
-      
+    // Readers let threads query a read only index concurrently. Each thread
+    // owns one, a read transaction that is renewed for every query instead
+    // of begun, and queries through it skip _lock. The index must outlive
+    // its readers, and unload() must not run while they query.
+    MDB_txn* begin_reader() {
+      std::lock_guard<notifying_mutex> lock(_lock);
+      if (!_read_only) {
+        return NULL;
+      }
+      // DBIs opened in a committed transaction stay open for all of them
+      _begin_txn(MDB_RDONLY, &_txn);
+      E(mdb_dbi_open(_txn, DBN_RAW, MDB_INTEGERKEY, &_dbi_raw));
+      _open_trees(0);
+      if (_codec != CODEC_FLOAT) {
+        E(mdb_dbi_open(_txn, DBN_CODE, MDB_INTEGERKEY, &_dbi_code));
+      }
+      E(mdb_txn_commit(_txn));
+      MDB_txn* reader;
+      _begin_txn(MDB_RDONLY, &reader);
+      mdb_txn_reset(reader);
+      return reader;
+    }
+
+    void end_reader(MDB_txn* reader) {
+      mdb_txn_abort(reader);
+    }
+
+    void get_nns_by_vector(MDB_txn* reader, const T* w, size_t n, size_t search_k,
+      vector<S>* result, vector<T>* distances) {
+      if (_flat != NULL) {
+        _get_all_nns_flat(w, n, search_k, result, distances);
+        return;
+      }
+      int rc; // the member is shared with other readers
+      E(mdb_txn_renew(reader));
+      _get_all_nns(reader, w, n, search_k, result, distances);
+      mdb_txn_reset(reader);
+    }
+
+    const Node* _flat_node(S i) {
+      return (const Node*) (_flat_nodes + (size_t) i * _flat_header->node_size);
+    }
+
+    // Node is packed, so its members may be misaligned for S and T: they
+    // are copied out instead of pointed to
+    T* _flat_vector(S i, T* out) {
+      memcpy(out, (const char*) _flat_node(i) + offsetof(Node, v), _f * sizeof(T));
+      return out;
+    }
+
+    void _flat_children(const Node* nd, S count, S* out) {
+      memcpy(out, (const char*) nd + offsetof(Node, children), count * sizeof(S));
+    }
+
+    bool _flat_item(S i) {
+      return i >= 0 && (uint64_t) i < _flat_header->n_items && _flat_node(i)->n_descendants == 1;
+    }
+
+    // _get_all_nns over the mapped file, no LMDB involved
+    void _get_all_nns_flat(const T* v, size_t n, size_t search_k, vector<S>* result, vector<T>* distances) {
+      const flat_header* h = _flat_header;
       std::priority_queue<pair<T, S> > q;
+      if (search_k == (size_t) (-1)) {
+        search_k = n * h->n_roots;
+      }
+      for (size_t i = 0; i < h->n_roots; i++) {
+        q.push(make_pair(numeric_limits<T>::infinity(), _flat_roots[i]));
+      }
+
+      vector<S> nns;
+      while (nns.size() < search_k && !q.empty()) {
+        T d = q.top().first;
+        const Node* nd = _flat_node(q.top().second);
+        q.pop();
+        S count = nd->n_descendants;
+        if ((uint64_t) count <= h->K) {
+          size_t m = nns.size();
+          nns.resize(m + count);
+          _flat_children(nd, count, &nns[m]);
+        } else {
+          S children[2];
+          _flat_children(nd, 2, children);
+          T margin = D::margin(nd, v, _f);
+          q.push(make_pair(std::min(d, +margin), children[0]));
+          q.push(make_pair(std::min(d, -margin), children[1]));
+        }
+      }
+
+      sort(nns.begin(), nns.end());
+      vector<pair<T, S> > nns_dist;
+      vector<T> u(_f);
+      S last = -1;
+      for (size_t i = 0; i < nns.size(); i++) {
+        S j = nns[i];
+        if (j == last) {
+          continue;
+        }
+        last = j;
+        nns_dist.push_back(make_pair(D::distance(v, _flat_vector(j, &u[0]), _f), j));
+      }
+
+      size_t m = nns_dist.size();
+      size_t p = n < m ? n : m; // Return this many items
+      std::partial_sort(nns_dist.begin(), nns_dist.begin() + p, nns_dist.end());
+      for (size_t i = 0; i < p; i++) {
+        if (distances) {
+          distances->push_back(D::normalized_distance(nns_dist[i].first));
+        }
+        result->push_back(nns_dist[i].second);
+      }
+    }
+
+    // the query, in txn: _txn under _lock, or a reader
+    void _get_all_nns(MDB_txn* txn, const T* v, size_t n, size_t search_k, vector<S>* result, vector<T>* distances) {
+      
+      // margin, and tree and node
+      std::priority_queue<pair<T, pair<int, int> > > q;
 
 
       std::map<S, bool> r;
@@ -321,50 +1064,77 @@ class AnnoyIndex : public AnnoyIndexInterface<S, T> {
 
       //put all root nodes in priority queue
       for (size_t i = 0; i < _tree_count; i++) {
-        q.push(make_pair(numeric_limits<T>::infinity(), _roots[i]));
+        q.push(make_pair(numeric_limits<T>::infinity(), make_pair((int) i, _roots[i])));
       }
+
+      QueryCodec qc;
+      _prepare_query(v, qc);
+      size_t record_size = _record_size();
+      vector<pair<T, S> > nns_dist; // candidates already scored in embedded leaves
+      vector<T> leaf_dist;
     
       vector<S> nns;
-      while (nns.size() < search_k && !q.empty()) {
-        const pair<T, S>& top = q.top();
+      while (c < search_k && !q.empty()) {
+        const pair<T, pair<int, int> >& top = q.top();
         T d = top.first;
-        S i = top.second;
+        int tree = top.second.first;
+        S i = top.second.second;
         tree_node tn;
-        bool result = _get_node_by_index(i, tn);
+        bool result = _get_node_by_index(txn, i, tn, tree);
         q.pop();
 
         if (tn.leaf()) {
+          bool embedded = tn.items_size() > 0 && tn.leaf_data().size() == tn.items_size() * record_size;
+          if (embedded) {
+            leaf_dist.resize(tn.items_size());
+            _score_records(qc, (const uint8_t*) tn.leaf_data().data(), tn.items_size(), &leaf_dist[0]);
+          }
           for (int i = 0; i < tn.items_size(); i ++) {
             int w = tn.items(i);
             if (r.find(w) == r.end()) {
-              nns.push_back(w);
+              if (embedded) {
+                nns_dist.push_back(make_pair(leaf_dist[i], w));
+              } else {
+                nns.push_back(w);
+              }
               r.insert(make_pair(w, true));
+              c++;
             }
           }
         } else {
           //T margin = D::margin(nd, v, _f);
-          T margin = D::margin(tn, v, _f);
-          q.push(make_pair(std::min(d, +margin), tn.left()));
-          q.push(make_pair(std::min(d, -margin), tn.right()));
+          T margin = _margin(tn, v);
+          q.push(make_pair(std::min(d, +margin), make_pair(tree, tn.left())));
+          q.push(make_pair(std::min(d, -margin), make_pair(tree, tn.right())));
         }
       }
       
       // Get distances for all items
       sort(nns.begin(), nns.end());
-      vector<pair<T, S> > nns_dist;
-      S last = -1;
-      for (size_t i = 0; i < nns.size(); i++) {
-        if (_verbose) printf(" NN candidates %d : %d \n", i, nns[i]);
-        S j = nns[i];
-        if (j == last)
-          continue;
-        last = j;
-        data_info di;
-        bool r = _get_raw_data(j, di);
-    
-        nns_dist.push_back(make_pair(D::distance(v, di,  _f), j));
+      if (_codec != CODEC_FLOAT) {
+        _get_code_distances(txn, qc, nns, nns_dist);
+        _rerank(txn, v, n, nns_dist);
+      } else {
+        vector<MDB_val> values;
+        _get_sorted(txn, _dbi_raw, nns, values);
+        S last = -1;
+        for (size_t i = 0; i < nns.size(); i++) {
+          if (_verbose) printf(" NN candidates %d : %d \n", i, nns[i]);
+          if (i + PREFETCH_AHEAD < values.size())
+            _prefetch(values[i + PREFETCH_AHEAD]);
+          S j = nns[i];
+          if (j == last || values[i].mv_data == NULL)
+            continue;
+          last = j;
+          data_info di;
+          di.ParseFromArray(values[i].mv_data, values[i].mv_size);
+      
+          nns_dist.push_back(make_pair(_distance(v, di), j));
+        }
       }
 
+      _scan_buffer(v, nns_dist);
+
       size_t m = nns_dist.size();
       size_t p = n < m ? n : m; // Return this many items
       std::partial_sort(&nns_dist[0], &nns_dist[p], &nns_dist[m]);
@@ -382,10 +1152,17 @@ class AnnoyIndex : public AnnoyIndexInterface<S, T> {
 
 
     S get_n_items() {
-      E(mdb_txn_begin(_env, NULL, 0, &_txn));
+      std::lock_guard<notifying_mutex> lock(_lock);
+      if (_flat != NULL) {
+        return _flat_header->n_items;
+      }
+      _begin_txn(MDB_RDONLY, &_txn);
       E(mdb_dbi_open(_txn, DBN_RAW, 0, &_dbi_raw));
       int max = _get_max_data_index();
       mdb_txn_abort(_txn);
+      if (!_buffer_rows.empty()) {
+        max = std::max(max, (int) _buffer_rows.rbegin()->first);
+      }
 
       return max+1;
     }
@@ -395,8 +1172,16 @@ class AnnoyIndex : public AnnoyIndexInterface<S, T> {
     }
     
     void get_item(S item, vector<T>* v)  {
+      std::lock_guard<notifying_mutex> lock(_lock);
+      if (_flat != NULL) {
+        if (_flat_item(item)) {
+          v->resize(v->size() + _f);
+          _flat_vector(item, &(*v)[v->size() - _f]);
+        }
+        return;
+      }
       data_info di;
-      E(mdb_txn_begin(_env, NULL, 0, &_txn));
+      _begin_txn(MDB_RDONLY, &_txn);
       E(mdb_dbi_open(_txn, DBN_RAW, 0, &_dbi_raw));
       bool result = _get_raw_data(item, di);
       if (result) {
@@ -409,74 +1194,382 @@ class AnnoyIndex : public AnnoyIndexInterface<S, T> {
     };
 
 
-    void add_item(int data_id, data_info& d) {
-
-      E(mdb_txn_begin(_env, NULL, 0, &_txn));
-      E(mdb_dbi_open(_txn, DBN_RAW, MDB_CREATE | MDB_INTEGERKEY, &_dbi_raw));
-      E(mdb_dbi_open(_txn, DBN_TREE, MDB_CREATE | MDB_INTEGERKEY, &_dbi_tree));
-      d.set_id(data_id);
-      _add_raw_data(data_id, d);
-      
-      //TODO: Implement some sort of thread pooling here.
-      vector<thread> t;
-      int concurrency = thread::hardware_concurrency();
-      for (int i = 0; i < _tree_count; i += concurrency) {
-        for(int j = i; j < std::min(_tree_count, concurrency); j++) {
-          t.push_back(thread(&AnnoyIndex::_add_item_to_tree, this, j, data_id, std::ref(d))); 
-          if(t[j].joinable()) {
-            t[j].join();
-          }
+    // walks one tree, to check how balanced its splits are
+    bool get_tree_stats(int tree, tree_stats* stats) {
+      std::lock_guard<notifying_mutex> lock(_lock);
+      if (tree < 0 || tree >= _tree_count) {
+        return false;
+      }
+      memset(stats, 0, sizeof(tree_stats));
+      _begin_txn(MDB_RDONLY, &_txn);
+      _open_trees(0);
+      double depth_sum = 0;
+      vector<pair<int, int> > stack(1, make_pair(_roots[tree], 0));
+      while (!stack.empty()) {
+        int index = stack.back().first;
+        int depth = stack.back().second;
+        stack.pop_back();
+        tree_node tn;
+        if (!_get_node_by_index(index, tn, tree)) {
+          continue;
+        }
+        stats->nodes++;
+        if (tn.leaf()) {
+          stats->leaves++;
+          stats->empty_leaves += tn.items_size() == 0;
+          stats->items += tn.items_size();
+          stats->max_depth = std::max(stats->max_depth, depth);
+          depth_sum += (double) depth * tn.items_size();
+        } else {
+          stack.push_back(make_pair(tn.left(), depth + 1));
+          stack.push_back(make_pair(tn.right(), depth + 1));
         }
       }
-       
-      mdb_txn_commit(_txn);
-      return;
+      mdb_txn_abort(_txn);
+      stats->mean_depth = stats->items ? depth_sum / stats->items : 0;
+      return true;
     }
-    
-        
-    void add_item_batch(S* items, size_t items_len, data_info* d) {
 
-      E(mdb_txn_begin(_env, NULL, 0, &_txn));
-      E(mdb_dbi_open(_txn, DBN_RAW, MDB_CREATE | MDB_INTEGERKEY, &_dbi_raw));
-      E(mdb_dbi_open(_txn, DBN_TREE, MDB_CREATE | MDB_INTEGERKEY, &_dbi_tree));
-      
-      for(int i = 0; i < items_len; i++) {
-        d[i].set_id(items[i]);
-        _add_raw_data(items[i], d[i]);
- 
-       //TODO: Implement some sort of thread pooling here.       
-        vector<thread> t;
-        int concurrency = thread::hardware_concurrency();
-        for (int j = 0; j < _tree_count; j += concurrency) {
-          for(int k = j; k < std::min(_tree_count, concurrency); k++) {
-            t.push_back(thread(&AnnoyIndex::_add_item_to_tree, this, k, items[i], std::ref(d[i])));
-            if(t[k].joinable()) {
-              t[k].join();
-            }
-          }
-        }   
+    // Drops one tree with its DBI and builds it again, bulk style, over
+    // every item of DBN_RAW. Vectors are held in memory meanwhile.
+    bool rebuild_tree(int tree) {
+      std::lock_guard<notifying_mutex> lock(_lock);
+      if (_read_only || tree < 0 || tree >= _tree_count || !_tree_dbs) {
+        return false;
       }
-      mdb_txn_commit(_txn);
-      return;
-    }
+      return _write([&] {
+        E(mdb_dbi_open(_txn, DBN_RAW, MDB_CREATE | MDB_INTEGERKEY, &_dbi_raw));
+        _open_trees(MDB_CREATE);
+        if (!_init_root(tree)) {
+          return false;
+        }
 
-    
-    //for debug
+        vector<int> items;
+        vector<T> vectors;
+        MDB_val key, data;
+        MDB_cursor *cursor;
+        E(mdb_cursor_open(_txn, _dbi_raw, &cursor));
+        while (mdb_cursor_get(cursor, &key, &data, MDB_NEXT) == MDB_SUCCESS) {
+          data_info d;
+          d.ParseFromArray(data.mv_data, data.mv_size);
+          _widen(d, _vector_type);
+          int data_id = 0;
+          memcpy(&data_id, key.mv_data, sizeof(int));
+          items.push_back(data_id);
+          vectors.insert(vectors.end(), d.data().begin(), d.data().end());
+        }
+        mdb_cursor_close(cursor);
 
-    void display_node(S node_index) {
-    
-      E(mdb_txn_begin(_env, NULL, 0, &_txn));
-      E(mdb_dbi_open(_txn, DBN_TREE, MDB_INTEGERKEY, &_dbi_tree));
-      
-      tree_node tn;
-      _get_node_by_index(node_index, tn);
-      tn.PrintDebugString();
-      mdb_txn_abort(_txn);
+        vector<int> rows(items.size());
+        for (size_t k = 0; k < rows.size(); k++) {
+          rows[k] = k;
+        }
+        _build_subtree(_roots[tree], rows, items, vectors, tree);
+        return true;
+      });
+    }
+
+    // Renumbers the nodes of every tree in the given LAYOUT_* order and
+    // writes them back in key order, so a descent reads neighbouring keys
+    // and the pages of a tree are filled up instead of half split. Each
+    // tree is rewritten in its own write transaction, in memory meanwhile.
+    bool compact_trees(int layout) {
+      std::lock_guard<notifying_mutex> lock(_lock);
+      if (_read_only || !_tree_dbs) {
+        return false;
+      }
+      for (int t = 0; t < _tree_count; t++) {
+        _write([&] {
+          _compact_tree(t, layout);
+          return true;
+        });
+        _roots[t] = 0;
+      }
+      return true;
+    }
+
+    // Rebuilds, bulk style, the subtrees whose height exceeds depth_ratio
+    // times the height of a balanced tree over the same items (plus one), or
+    // whose leaves are on average less than min_fill full. Each tree is
+    // handled in its own write transaction rebuilding at most max_items
+    // items, topmost degraded subtrees first. Returns the number of subtrees
+    // rebuilt.
+    size_t rebalance(double depth_ratio, double min_fill, size_t max_items) {
+      size_t rebuilt = 0;
+      for (int t = 0; t < _tree_count; t++) {
+        rebuilt += _rebalance_tree(t, depth_ratio, min_fill, max_items);
+      }
+      return rebuilt;
+    }
+
+    // Sizes leaves so that the records scored for one leaf, its embedded
+    // records or the ones fetched for its items, fill about page_size bytes:
+    // compact codes get wider leaves and shallower trees for the same bytes
+    // read per leaf. 0 goes back to the constructor's K. Applies to leaves
+    // as they fill up; rebalance() reshapes existing subtrees.
+    void set_leaf_page_size(int page_size) {
+      std::lock_guard<notifying_mutex> lock(_lock);
+      if (_read_only) {
+        return;
+      }
+      _write([&] {
+        _leaf_page_size = std::max(0, page_size);
+        _update_capacity();
+        _save_meta();
+        return true;
+      });
+    }
+
+    int get_leaf_capacity() {
+      return _capacity;
+    }
+
+    // Every tree draws from its own stream, seeded from seed and the tree
+    // id, so a build depends only on the seed and the inserted data, not on
+    // the order in which trees are visited. Sampling for train_pq uses
+    // the seed itself. The seed is kept in DBN_META, and the streams start
+    // over from it whenever the index is opened.
+    void set_seed(uint64_t seed) {
+      std::lock_guard<notifying_mutex> lock(_lock);
+      _reseed(seed);
+      if (!_read_only) {
+        _write([&] {
+          _save_meta();
+          return true;
+        });
+      }
+    }
+
+    void _reseed(uint64_t seed) {
+      _seed = seed;
+      _random = Random(seed);
+      _tree_random.clear();
+      for (int t = 0; t < _tree_count; t++) {
+        _tree_random.push_back(Random(_tree_seed(seed, t)));
+      }
+    }
+
+    // Buffers up to capacity added items in memory: add_item returns once
+    // the vector is copied, queries scan the buffer exactly next to the
+    // forest, and the items reach LMDB in one add_item_batch when the buffer
+    // is full, every flush_interval_ms on a background thread, on flush()
+    // and when the index is destroyed. capacity 0 flushes and turns the
+    // buffer off.
+    bool set_write_buffer(size_t capacity, int flush_interval_ms) {
+      if (_read_only) {
+        return false;
+      }
+      if (_flusher.joinable()) {
+        {
+          std::lock_guard<std::mutex> l(_flush_mutex);
+          _flush_stop = true;
+        }
+        _flush_cv.notify_all();
+        _flusher.join();
+      }
+
+      std::lock_guard<notifying_mutex> lock(_lock);
+      _flush_buffer();
+      _buffer_capacity = capacity;
+      // queries open DBN_RAW, which must exist before the first flush
+      _write([&] {
+        E(mdb_dbi_open(_txn, DBN_RAW, MDB_CREATE | MDB_INTEGERKEY, &_dbi_raw));
+        return true;
+      });
+      if (capacity > 0 && flush_interval_ms > 0) {
+        _flush_stop = false;
+        _flusher = thread(&AnnoyIndex::_flush_periodically, this, flush_interval_ms);
+      }
+      return true;
+    }
+
+    // makes everything added so far visible and durable: flushes the write
+    // buffer, commits the pending group and syncs the map to disk
+    void flush() {
+      std::lock_guard<notifying_mutex> lock(_lock);
+      if (_read_only) {
+        return;
+      }
+      _flush_buffer();
+      _commit_pending();
+      E(mdb_env_sync(_env, 1));
+    }
+
+    // runs rebalance every interval_ms on a background thread
+    bool start_maintenance(int interval_ms, double depth_ratio, double min_fill, size_t max_items) {
+      if (_read_only || interval_ms <= 0) {
+        return false;
+      }
+      stop_maintenance();
+      _maintenance_stop = false;
+      _maintenance = thread(&AnnoyIndex::_maintain, this, interval_ms, depth_ratio, min_fill, max_items);
+      return true;
+    }
+
+    void stop_maintenance() {
+      if (!_maintenance.joinable()) {
+        return;
+      }
+      {
+        std::lock_guard<std::mutex> l(_maintenance_mutex);
+        _maintenance_stop = true;
+      }
+      _maintenance_cv.notify_all();
+      _maintenance.join();
+    }
+
+    void add_item(int data_id, data_info& d) {
+      add_item_batch(&data_id, 1, &d);
+    }
+    
+        
+    void add_item_batch(S* items, size_t items_len, data_info* d) {
+      std::lock_guard<notifying_mutex> lock(_lock);
+
+      if (_group_items > 0) {
+        _run_on_writer([&] { _add_to_group(items, items_len, d); });
+        return;
+      }
+
+      _write([&] {
+        _insert(items, items_len, d);
+        return true;
+      });
+    }
+
+    // Coalesces inserts into one write transaction, committed once
+    // max_items items are pending or the oldest is max_delay_ms old, and on
+    // flush(). Pending items are not visible to readers until then. A
+    // group that fails to commit fails the next insert or flush.
+    // max_items 0 commits what is pending and turns grouping off.
+    void set_group_commit(size_t max_items, int max_delay_ms) {
+      std::lock_guard<notifying_mutex> lock(_lock);
+      if (_read_only) {
+        return;
+      }
+      if (_writer.joinable()) {
+        {
+          std::lock_guard<std::mutex> l(_writer_mutex);
+          _writer_stop = true;
+        }
+        _writer_cv.notify_all();
+        _writer.join();
+        _check_group();
+      }
+      _group_items = max_items;
+      _group_delay_ms = max_delay_ms;
+      if (max_items > 0) {
+        _writer_stop = false;
+        _writer = thread(&AnnoyIndex::_write_loop, this);
+      }
+    }
+
+    // how much of the LMDB map is in use. max_size given at open is only the
+    // initial map size, writes grow it when it runs full.
+    void get_map_usage(map_usage* usage) {
+      std::lock_guard<notifying_mutex> lock(_lock);
+      _map_usage(usage);
+    }
+
+    // Writes a compacted copy of the environment to dest_dir, which must
+    // exist and be empty. The copy holds only the live pages, laid out in
+    // B-tree order, so it is smaller and scans sequentially. With a layout
+    // (see LAYOUT_*) the trees are first renumbered in place, see
+    // compact_trees, so the nodes of a path share pages in the copy too.
+    // before and after describe the pages of this environment and of the copy.
+    bool compact(const char* dest_dir, int layout, page_report* before, page_report* after) {
+      std::lock_guard<notifying_mutex> lock(_lock);
+      if (layout >= 0 && !compact_trees(layout)) {
+        errno = EINVAL; // read only, or trees not in their own DBs
+        return false;
+      }
+      if (!_read_only) {
+        _flush_buffer();
+        _commit_pending();
+      }
+      _begin_txn(MDB_RDONLY, &_txn);
+      _page_report(_txn, before);
+      mdb_txn_abort(_txn);
+
+      rc = mdb_env_copy2(_env, dest_dir, MDB_CP_COMPACT);
+      if (rc != MDB_SUCCESS) {
+        printf("ERROR: copying to %s failed: %s\n", dest_dir, mdb_strerror(rc));
+        errno = rc > 0 ? rc : EIO;
+        return false;
+      }
+      if (_verbose) {
+        printf("compacted copy written to %s\n", dest_dir);
+      }
+
+      // the copy is written, a failure to open it only loses the report;
+      // the env is closed on every way out, also when a CHECK throws
+      struct copy_env {
+        MDB_env* env = NULL;
+        MDB_txn* txn = NULL;
+        ~copy_env() {
+          if (txn != NULL) {
+            mdb_txn_abort(txn);
+          }
+          if (env != NULL) {
+            mdb_env_close(env);
+          }
+        }
+      } copy;
+      rc = mdb_env_create(&copy.env);
+      if (rc == MDB_SUCCESS) {
+        rc = mdb_env_set_maxdbs(copy.env, std::max(100, _tree_count + 8));
+      }
+      if (rc == MDB_SUCCESS) {
+        rc = mdb_env_open(copy.env, dest_dir, MDB_RDONLY, 0664);
+      }
+      if (rc == MDB_SUCCESS) {
+        rc = mdb_txn_begin(copy.env, NULL, MDB_RDONLY, &copy.txn);
+      }
+      if (rc != MDB_SUCCESS) {
+        printf("ERROR: opening the copy in %s failed: %s\n", dest_dir, mdb_strerror(rc));
+        errno = rc > 0 ? rc : EIO;
+        return false;
+      }
+      _page_report(copy.txn, after);
+      return true;
+    }
+
+    // see DURABILITY_*
+    void set_durability(int policy) {
+      std::lock_guard<notifying_mutex> lock(_lock);
+      if (_read_only) {
+        return;
+      }
+      E(mdb_env_set_flags(_env, MDB_NOSYNC | MDB_NOMETASYNC | MDB_MAPASYNC, 0));
+      if (policy == DURABILITY_NOMETASYNC) {
+        E(mdb_env_set_flags(_env, MDB_NOMETASYNC, 1));
+      } else if (policy == DURABILITY_NOSYNC) {
+        E(mdb_env_set_flags(_env, MDB_NOSYNC | MDB_MAPASYNC, 1));
+      }
+    }
+
+    
+    //for debug
+
+    void display_node(S node_index, int tree) {
+      std::lock_guard<notifying_mutex> lock(_lock);
+      if (tree < 0 || tree >= _tree_count) {
+        return;
+      }
+    
+      _begin_txn(MDB_RDONLY, &_txn);
+      _open_trees(0);
+      
+      tree_node tn;
+      _get_node_by_index(node_index, tn, tree);
+      tn.PrintDebugString();
+      mdb_txn_abort(_txn);
 
     }
     void display_raw(S data_index) {
+      std::lock_guard<notifying_mutex> lock(_lock);
     
-      E(mdb_txn_begin(_env, NULL, 0, &_txn));
+      _begin_txn(MDB_RDONLY, &_txn);
       E(mdb_dbi_open(_txn, DBN_RAW, MDB_INTEGERKEY, &_dbi_raw));
       
       data_info di;
@@ -485,10 +1578,17 @@ class AnnoyIndex : public AnnoyIndexInterface<S, T> {
       mdb_txn_abort(_txn);
 
     }  
-    void _add_item_to_tree(int node_index, int data_id, data_info& data) {
+    // inserts into the subtree at node_index of tree `tree`, using only that
+    // tree's random stream and split scratch
+    void _add_item_to_tree(int node_index, int data_id, data_info& data, int tree) {
+      if (_map_full) {
+        return;
+      }
+      bool embed = tree < _leaf_embed_trees;
+      SplitArena<T>& arena = _split[tree];
       //check node type  
       tree_node tn;
-      bool result = _get_node_by_index(node_index, tn);  
+      bool result = _get_node_by_index(node_index, tn, tree);  
       if (!result)  {
         printf("ERROR: can not insert new item into node %d \n", node_index);
         return;
@@ -498,22 +1598,30 @@ class AnnoyIndex : public AnnoyIndexInterface<S, T> {
         printf("add item %d to tree node %d... \n", data_id, node_index); fflush(stdout);
       }
       
-      if (tn.leaf() && tn.items_size() < _K) {
+      if (tn.leaf() && tn.items_size() < _capacity) {
         tn.add_items(data_id);
-        _update_tree_node(node_index, tn); 
+        if (embed) {
+          _append_record(data, *tn.mutable_leaf_data());
+        }
+        _update_tree_node(node_index, tn, tree); 
         if (_verbose) {
           printf("add item %d node %d directly\n ", data_id, node_index); fflush(stdout);
         }
         return ;
       }
 
-      if (tn.leaf() && tn.items_size() >= _K) {
+      if (tn.leaf() && tn.items_size() >= _capacity) {
         //split
-        vector<data_info> data_pt;      
-        for (int k = 0; k < tn.items_size(); k ++) {         
-          data_info d;
-          _get_raw_data(tn.items(k), d);
-          data_pt.push_back(d);
+        size_t count = tn.items_size();
+        arena.points.resize(count * _f);
+        data_info d;
+        for (size_t k = 0; k < count; k ++) {         
+          T* point = &arena.points[k * _f];
+          if (_get_raw_data(tn.items(k), d)) {
+            memcpy(point, d.data().data(), _f * sizeof(T));
+          } else {
+            memset(point, 0, _f * sizeof(T));
+          }
         }
         
 
@@ -522,10 +1630,16 @@ class AnnoyIndex : public AnnoyIndexInterface<S, T> {
         tree_node right_node;
 
 
-        D::split(tn, data_pt, new_node, left_node, right_node, _random, _f );
+        D::split(tn, new_node, left_node, right_node, _tree_random[tree], _f, arena);
+        if (embed) {
+          for (size_t k = 0; k < count; k++) {
+            tree_node& side = arena.sides[k] ? left_node : right_node;
+            _append_record(&arena.points[k * _f], *side.mutable_leaf_data());
+          }
+        }
 
         if (_verbose) {
-          printf(" split %d node into left, and right... ", data_pt.size());
+          printf(" split %d node into left, and right... ", count);
           printf(" left nodes : ");
           left_node.PrintDebugString();
           printf(" right nodes : ");
@@ -533,93 +1647,1449 @@ class AnnoyIndex : public AnnoyIndexInterface<S, T> {
         }
          
 
-        int left_index = _add_node(left_node);
-        int right_index = _add_node(right_node);
+        int left_index = _add_node(left_node, tree);
+        int right_index = _add_node(right_node, tree);
         new_node.set_left(left_index);
         new_node.set_right(right_index);
         new_node.set_leaf(false);
         new_node.set_index(node_index);
-        _update_tree_node(node_index, new_node);
-        _get_node_by_index(node_index, tn); 
+        _update_tree_node(node_index, new_node, tree);
+        if (_map_full) {
+          return;
+        }
+        _get_node_by_index(node_index, tn, tree); 
       } 
 
-      //TODO: Add check to ensure that the hyperplane split the data.
-      bool side = D::side(tn, data, _f, _random);
+      bool side = _side(tn, data, _tree_random[tree]);
 
       if (side) {
-          _add_item_to_tree(tn.left(), data_id, data);
+          _add_item_to_tree(tn.left(), data_id, data, tree);
       } else {
-          _add_item_to_tree(tn.right(), data_id, data);
+          _add_item_to_tree(tn.right(), data_id, data, tree);
       }
       return;
 
     }
     
   protected:
-  
-    // node 0, ..., _tree_count - 1 will be reserved for root nodes    
-    bool init_roots() {
+
+    // per query state needed to score records of the active codec
+    struct QueryCodec {
+      const T* v;
+      vector<uint8_t> int8; // Int8Header and codes of the query, CODEC_INT8
+      vector<T> table;      // inner products with the centroids, CODEC_PQ
+    };
+
+    void _prepare_query(const T* v, QueryCodec& qc) {
+      qc.v = v;
+      if (_codec == CODEC_INT8) {
+        qc.int8.resize(sizeof(Int8Header) + _f);
+        Int8Header* qh = (Int8Header*) &qc.int8[0];
+        quantize_int8(v, _f, qh, (int8_t*)(qh + 1));
+      } else if (_codec == CODEC_PQ) {
+        vector<T> unit(_f);
+        _unit(v, &unit[0]);
+        qc.table.resize(_pq.m * _pq.ksub);
+        _pq.compute_table(&unit[0], &qc.table[0]);
+      }
+    }
+
+    // size of one record as stored in DBN_CODE and in leaf_data
+    size_t _record_size() {
+      if (_codec == CODEC_INT8)
+        return sizeof(Int8Header) + _f;
+      if (_codec == CODEC_PQ)
+        return _pq.code_size();
+      if (_vector_type != VECTOR_FLOAT32)
+        return _f * sizeof(uint16_t);
+      return _f * sizeof(T);
+    }
+
+    // append the record of a (float) vector to out
+    void _append_record(const data_info& d, string& out) {
+      _append_record(d.data().data(), out);
+    }
+
+    void _append_record(const T* v, string& out) {
+      size_t at = out.size();
+      out.resize(at + _record_size());
+      uint8_t* record = (uint8_t*) &out[at];
+      if (_codec == CODEC_PQ) {
+        vector<T> unit(_f);
+        _unit(v, &unit[0]);
+        _pq.encode(&unit[0], record);
+      } else if (_codec == CODEC_INT8) {
+        Int8Header* h = (Int8Header*) record;
+        quantize_int8(v, _f, h, (int8_t*)(h + 1));
+      } else if (_vector_type != VECTOR_FLOAT32) {
+        encode_half(v, _f, _vector_type, (uint16_t*) record);
+      } else {
+        memcpy(record, v, _f * sizeof(T));
+      }
+    }
+
+    // distances of count records stored back to back
+    void _score_records(const QueryCodec& qc, const uint8_t* records, size_t count, T* out) {
+      size_t record_size = _record_size();
+      if (_codec == CODEC_PQ) {
+        _pq.score_batch(&qc.table[0], records, count, out);
+        for (size_t i = 0; i < count; i++)
+          out[i] = D::distance_from_cos(out[i]);
+      } else if (_codec == CODEC_INT8) {
+        const Int8Header* qh = (const Int8Header*) &qc.int8[0];
+        for (size_t i = 0; i < count; i++)
+          out[i] = D::distance(qh, (const Int8Header*)(records + i * record_size), _f);
+      } else if (_vector_type != VECTOR_FLOAT32) {
+        for (size_t i = 0; i < count; i++)
+          out[i] = D::distance(qc.v, (const uint16_t*)(records + i * record_size), _f, _vector_type);
+      } else {
+        for (size_t i = 0; i < count; i++)
+          out[i] = D::distance(qc.v, (const T*)(records + i * record_size), _f);
+      }
+    }
+
+    // score the sorted candidates from DBN_CODE: their codes are gathered
+    // into one buffer and scored in a single pass
+    void _get_code_distances(MDB_txn* txn, const QueryCodec& qc, const vector<S>& nns,
+                             vector<pair<T, S> >& nns_dist) {
+      size_t code_size = _record_size();
+      vector<MDB_val> values;
+      _get_sorted(txn, _dbi_code, nns, values);
+      vector<uint8_t> codes;
+      vector<S> ids;
+      S last = -1;
+      for (size_t i = 0; i < nns.size(); i++) {
+        if (i + PREFETCH_AHEAD < values.size())
+          _prefetch(values[i + PREFETCH_AHEAD]);
+        S j = nns[i];
+        if (j == last || values[i].mv_size != code_size)
+          continue;
+        last = j;
+        const uint8_t* code = (const uint8_t*) values[i].mv_data;
+        codes.insert(codes.end(), code, code + code_size);
+        ids.push_back(j);
+      }
+      if (ids.empty()) {
+        return;
+      }
+
+      vector<T> dist(ids.size());
+      _score_records(qc, &codes[0], ids.size(), &dist[0]);
+      for (size_t i = 0; i < ids.size(); i++) {
+        nns_dist.push_back(make_pair(dist[i], ids[i]));
+      }
+    }
+
+    // rerank the best _rerank_k quantized candidates against their float
+    // vectors in DBN_RAW
+    void _rerank(MDB_txn* txn, const T* v, size_t n, vector<pair<T, S> >& nns_dist) {
+      if (_rerank_k == 0) {
+        return;
+      }
+      size_t m = std::min(nns_dist.size(), std::max(n, _rerank_k));
+      std::partial_sort(nns_dist.begin(), nns_dist.begin() + m, nns_dist.end());
+      nns_dist.resize(m);
+
+      // read the survivors in key order
+      std::sort(nns_dist.begin(), nns_dist.end(), _by_id);
+      vector<S> ids(m);
+      for (size_t i = 0; i < m; i++)
+        ids[i] = nns_dist[i].second;
+      vector<MDB_val> values;
+      _get_sorted(txn, _dbi_raw, ids, values);
+      for (size_t i = 0; i < m; i++) {
+        if (i + PREFETCH_AHEAD < m)
+          _prefetch(values[i + PREFETCH_AHEAD]);
+        if (values[i].mv_data == NULL)
+          continue;
+        data_info di;
+        di.ParseFromArray(values[i].mv_data, values[i].mv_size);
+        _widen(di, _vector_type);
+        nns_dist[i].first = D::distance(v, di, _f);
+      }
+    }
+
+    static bool _by_id(const pair<T, S>& a, const pair<T, S>& b) {
+      return a.second < b.second;
+    }
+
+    // Looks up the records of ascending ids with a single cursor. When the
+    // next id is the next key, MDB_NEXT steps to it within the current leaf
+    // page; otherwise MDB_SET_RANGE descends once and lands on or after it.
+    // Missing ids get a NULL mv_data. Values point into the map and stay
+    // valid until the transaction ends.
+    void _get_sorted(MDB_txn* txn, MDB_dbi dbi, const vector<S>& ids, vector<MDB_val>& values) {
+      int rc; // the member is shared with other readers
+      MDB_val empty;
+      empty.mv_size = 0;
+      empty.mv_data = NULL;
+      values.assign(ids.size(), empty);
+      if (ids.empty()) {
+        return;
+      }
+
+      MDB_cursor* cursor;
+      E(mdb_cursor_open(txn, dbi, &cursor));
+      MDB_val key, data;
+      int current = -1; // key under the cursor, -1 when not positioned
+      for (size_t i = 0; i < ids.size(); i++) {
+        int id = ids[i];
+        if (id < current) {
+          continue; // ids must be ascending
+        }
+        if (id > current) {
+          if (current >= 0 && id == current + 1) {
+            rc = mdb_cursor_get(cursor, &key, &data, MDB_NEXT);
+          } else {
+            key.mv_data = (uint8_t*) & id;
+            key.mv_size = sizeof(int);
+            rc = mdb_cursor_get(cursor, &key, &data, MDB_SET_RANGE);
+          }
+          if (rc != MDB_SUCCESS) {
+            break; // past the last key
+          }
+          current = *(int*) key.mv_data;
+        }
+        if (id == current) {
+          values[i] = data;
+        }
+      }
+      mdb_cursor_close(cursor);
+    }
+
+    // advises and reads the pages of [p, p + size), see warm_up
+    size_t _warm_range(const void* p, size_t size, bool lock,
+                       std::chrono::steady_clock::time_point deadline) {
+      if (p == NULL || size == 0) {
+        return 0;
+      }
+      size_t page = sysconf(_SC_PAGESIZE);
+      char* begin = (char*) ((uintptr_t) p / page * page);
+      size_t length = (const char*) p + size - begin;
+#ifdef MADV_WILLNEED
+      madvise(begin, length, MADV_WILLNEED);
+#endif
+      size_t pages = 0;
+      volatile char sink = 0;
+      for (size_t off = 0; off < length; off += page, pages++) {
+        if (pages % 1024 == 1023 && std::chrono::steady_clock::now() >= deadline) {
+          length = off;
+          break;
+        }
+        sink += begin[off];
+      }
+      if (lock && mlock(begin, length) != 0 && _verbose) {
+        printf("warm up: mlock of %d bytes failed\n", (int) length);
+      }
+      return pages;
+    }
+
+    // pull the head of a record into cache before it is parsed
+    static inline void _prefetch(const MDB_val& value) {
+      const char* p = (const char*) value.mv_data;
+      if (p == NULL) {
+        return;
+      }
+      for (size_t off = 0; off < value.mv_size && off < 256; off += 64) {
+        __builtin_prefetch(p + off);
+      }
+    }
+
+    // the product quantizer codes directions only, as the angular distance does
+    void _unit(const T* v, T* unit) {
+      T norm = 0;
+      for (int z = 0; z < _f; z++)
+        norm += v[z] * v[z];
+      norm = sqrt(norm);
+      for (int z = 0; z < _f; z++)
+        unit[z] = norm > 0 ? v[z] / norm : 0;
+    }
+
+    // (re)build DBN_CODE for the current codec, inside a write transaction
+    void _encode_all() {
+      if (_map_full) {
+        return;
+      }
+      E(mdb_dbi_open(_txn, DBN_RAW, MDB_CREATE | MDB_INTEGERKEY, &_dbi_raw));
+      E(mdb_dbi_open(_txn, DBN_CODE, MDB_CREATE | MDB_INTEGERKEY, &_dbi_code));
+      E(mdb_drop(_txn, _dbi_code, 0));
+      if (_codec == CODEC_FLOAT) {
+        return;
+      }
+
+      MDB_val key, data;
+      MDB_cursor *cursor;
+      E(mdb_cursor_open(_txn, _dbi_raw, &cursor));
+      while (!_map_full && mdb_cursor_get(cursor, &key, &data, MDB_NEXT) == MDB_SUCCESS) {
+        data_info d;
+        d.ParseFromArray(data.mv_data, data.mv_size);
+        _widen(d, _vector_type);
+        int data_id = 0;
+        memcpy(&data_id, key.mv_data, sizeof(int));
+        _add_code(data_id, d);
+      }
+      mdb_cursor_close(cursor);
+    }
+
+    // rebuild the leaf_data of every leaf, inside a write transaction
+    void _embed_all() {
+      if (_map_full) {
+        return;
+      }
+      E(mdb_dbi_open(_txn, DBN_RAW, MDB_CREATE | MDB_INTEGERKEY, &_dbi_raw));
+      _open_trees(MDB_CREATE);
+      for (int t = 0; t < _tree_count && !_map_full; t++) {
+        bool embed = t < _leaf_embed_trees;
+        vector<int> stack(1, _roots[t]);
+        while (!stack.empty() && !_map_full) {
+          int index = stack.back();
+          stack.pop_back();
+          tree_node tn;
+          if (!_get_node_by_index(index, tn, t)) {
+            continue;
+          }
+          if (!tn.leaf()) {
+            stack.push_back(tn.left());
+            stack.push_back(tn.right());
+            continue;
+          }
+          if (!embed && !tn.has_leaf_data()) {
+            continue;
+          }
+          tn.clear_leaf_data();
+          for (int k = 0; embed && k < tn.items_size(); k++) {
+            data_info d;
+            if (_get_raw_data(tn.items(k), d)) {
+              _append_record(d, *tn.mutable_leaf_data());
+            }
+          }
+          _update_tree_node(index, tn, t);
+        }
+      }
+    }
+
+    T _margin(const tree_node& tn, const T* v) {
+      if (tn.hv().size() == _f * sizeof(uint16_t)) {
+        return D::margin((const uint16_t*) tn.hv().data(), v, _f, _vector_type);
+      }
+      return D::margin(tn, v, _f);
+    }
+
+    T _distance(const T* v, data_info& d) {
+      if (d.hdata().size() == _f * sizeof(uint16_t)) {
+        return D::distance(v, (const uint16_t*) d.hdata().data(), _f, _vector_type);
+      }
+      return D::distance(v, d, _f);
+    }
+
+    bool _side(const tree_node& tn, const data_info& d, Random& random) {
+      T dot = _margin(tn, d.data().data());
+      if (dot != 0)
+        return (dot > 0);
+      else
+        return random.flip();
+    }
+
+    // serialize, moving the vector to the 16 bit field for half precision types
+    void _pack(const data_info& d, string& data_buffer) {
+      if (_vector_type == VECTOR_FLOAT32 || d.data_size() != _f) {
+        d.SerializeToString(&data_buffer);
+        return;
+      }
+      data_info packed;
+      packed.set_id(d.id());
+      string* h = packed.mutable_hdata();
+      h->resize(_f * sizeof(uint16_t));
+      encode_half(d.data().data(), _f, _vector_type, (uint16_t*) &(*h)[0]);
+      packed.SerializeToString(&data_buffer);
+    }
+
+    void _pack(const tree_node& tn, string& data_buffer) {
+      if (_vector_type == VECTOR_FLOAT32 || tn.v_size() != _f) {
+        tn.SerializeToString(&data_buffer);
+        return;
+      }
+      tree_node packed(tn);
+      packed.clear_v();
+      string* h = packed.mutable_hv();
+      h->resize(_f * sizeof(uint16_t));
+      encode_half(tn.v().data(), _f, _vector_type, (uint16_t*) &(*h)[0]);
+      packed.SerializeToString(&data_buffer);
+    }
+
+    // back to float fields, vector_type is the type the record was packed with
+    void _widen(data_info& d, int vector_type) {
+      if (d.hdata().size() != _f * sizeof(uint16_t)) {
+        return;
+      }
+      d.mutable_data()->Resize(_f, 0);
+      decode_half((const uint16_t*) d.hdata().data(), _f, vector_type, d.mutable_data()->mutable_data());
+      d.clear_hdata();
+    }
+
+    void _widen(tree_node& tn, int vector_type) {
+      if (tn.hv().size() != _f * sizeof(uint16_t)) {
+        return;
+      }
+      tn.mutable_v()->Resize(_f, 0);
+      decode_half((const uint16_t*) tn.hv().data(), _f, vector_type, tn.mutable_v()->mutable_data());
+      tn.clear_hv();
+    }
+
+    // inserts items into DBN_RAW, DBN_CODE and every tree, within _txn
+    void _insert(S* items, size_t items_len, data_info* d) {
+      E(mdb_dbi_open(_txn, DBN_RAW, MDB_CREATE | MDB_INTEGERKEY, &_dbi_raw));
+      _open_trees(MDB_CREATE);
+      if (_codec != CODEC_FLOAT) {
+        E(mdb_dbi_open(_txn, DBN_CODE, MDB_CREATE | MDB_INTEGERKEY, &_dbi_code));
+      }
       
+      for (size_t i = 0; i < items_len && !_map_full; i++) {
+        d[i].set_id(items[i]);
+        _add_raw_data(items[i], d[i]);
+        if (_codec != CODEC_FLOAT && !_map_full) {
+          _add_code(items[i], d[i]);
+        }
+ 
+        // the trees share _txn, which is bound to this thread
+        for (int k = 0; k < _tree_count && !_map_full; k++) {
+          _add_item_to_tree(_roots[k], items[i], d[i], k);
+        }
+      }
+    }
+
+    // rewrites the record under cursor in place, a full map sets _map_full
+    void _put_current(MDB_cursor* cursor, MDB_val* key, MDB_val* data) {
+      rc = mdb_cursor_put(cursor, key, data, MDB_CURRENT);
+      if (rc == MDB_MAP_FULL) {
+        _map_full = true;
+        return;
+      }
+      CHECK(rc == MDB_SUCCESS, "mdb_cursor_put");
+    }
+
+    // begins a write transaction in _txn for the calling thread, after
+    // committing a pending group that would otherwise hold the writer lock
+    void _begin_write() {
+      _commit_pending();
+      map_usage usage;
+      _map_usage(&usage);
+      if (usage.used_size > usage.map_size * MAP_HIGH_WATER) {
+        _grow_map();
+      }
+      _begin_txn(0, &_txn);
+    }
+
+    // Runs body in a write transaction in _txn and commits it. When a put of
+    // body or the commit runs the map full, the transaction is aborted, the
+    // map grown and body run again from the same random state; body must
+    // return soon once _map_full is set. Returns what body returned, a
+    // false body is aborted.
+    bool _write(const std::function<bool()>& body) {
+      vector<Random> tree_random = _tree_random;
+      Random random = _random;
+      while (true) {
+        _begin_write();
+        bool ok = body();
+        if (!_map_full) {
+          if (!ok) {
+            mdb_txn_abort(_txn);
+            return false;
+          }
+          rc = mdb_txn_commit(_txn);
+          if (rc != MDB_MAP_FULL) {
+            CHECK(rc == MDB_SUCCESS, "mdb_txn_commit");
+            return true;
+          }
+          // a failed commit has freed the transaction already
+        } else {
+          mdb_txn_abort(_txn);
+        }
+        _tree_random = tree_random;
+        _random = random;
+        _grow_map();
+      }
+    }
+
+    void _begin_txn(unsigned int flags, MDB_txn** txn) {
+      rc = mdb_txn_begin(_env, NULL, flags, txn);
+      if (rc == MDB_MAP_RESIZED) {
+        // another process grew the map, adopt its size
+        _wait_detached();
+        E(mdb_env_set_mapsize(_env, 0));
+        rc = mdb_txn_begin(_env, NULL, flags, txn);
+      }
+      CHECK(rc == MDB_SUCCESS, "mdb_txn_begin");
+    }
+
+    // without _lock, since the writer thread grows the map too
+    void _map_usage(map_usage* usage) {
+      MDB_envinfo info;
+      MDB_stat stat;
+      E(mdb_env_info(_env, &info));
+      E(mdb_env_stat(_env, &stat));
+      usage->map_size = info.me_mapsize;
+      usage->used_size = (info.me_last_pgno + 1) * (size_t) stat.ms_psize;
+      usage->page_size = stat.ms_psize;
+      usage->readers = info.me_numreaders;
+      usage->max_readers = info.me_maxreaders;
+    }
+
+    // counts the pages of the environment of txn; the names of the named
+    // DBs are the keys of the main DB
+    void _page_report(MDB_txn* txn, page_report* report) {
+      MDB_envinfo info;
+      MDB_stat stat;
+      MDB_dbi main_dbi;
+      E(mdb_env_info(mdb_txn_env(txn), &info));
+      E(mdb_dbi_open(txn, NULL, 0, &main_dbi));
+      E(mdb_stat(txn, main_dbi, &stat));
+      report->page_size = stat.ms_psize;
+      report->used_pages = info.me_last_pgno + 1;
+      report->live_pages = stat.ms_branch_pages + stat.ms_leaf_pages + stat.ms_overflow_pages;
+
+      MDB_val key;
+      MDB_cursor *cursor;
+      E(mdb_cursor_open(txn, main_dbi, &cursor));
+      while (mdb_cursor_get(cursor, &key, NULL, MDB_NEXT) == MDB_SUCCESS) {
+        string name((const char*) key.mv_data, key.mv_size);
+        MDB_dbi dbi;
+        if (mdb_dbi_open(txn, name.c_str(), 0, &dbi) != MDB_SUCCESS) {
+          continue; // a plain record, not a DB
+        }
+        E(mdb_stat(txn, dbi, &stat));
+        report->live_pages += stat.ms_branch_pages + stat.ms_leaf_pages + stat.ms_overflow_pages;
+      }
+      mdb_cursor_close(cursor);
+      // the file starts with two meta pages
+      report->free_pages = report->used_pages - std::min(report->used_pages, report->live_pages + 2);
+    }
+
+    // Grows the map MAP_GROWTH fold. LMDB only allows it while this process
+    // has no transaction open, which holds under _lock once the pending
+    // group is committed or aborted; readers in other processes pick the
+    // new size up as their next transaction begins, see _begin_txn.
+    void _grow_map() {
+      map_usage usage;
+      _map_usage(&usage);
+      size_t size = (size_t) (usage.map_size * MAP_GROWTH);
+      size = (size + usage.page_size - 1) / usage.page_size * usage.page_size;
+      if (_verbose) {
+        printf("map full, growing it from %zu to %zu bytes\n", usage.map_size, size);
+      }
+      _wait_detached();
+      E(mdb_env_set_mapsize(_env, size));
+      _map_full = false;
+    }
+
+    // with _lock held, so no new detached transaction begins meanwhile
+    void _wait_detached() {
+      std::unique_lock<std::mutex> l(_detached_mutex);
+      _detached_cv.wait(l, [this] { return _detached == 0; });
+    }
+
+    void _end_detached(MDB_txn* txn) {
+      mdb_txn_abort(txn);
+      std::lock_guard<std::mutex> l(_detached_mutex);
+      _detached--;
+      _detached_cv.notify_all();
+    }
+
+    void _commit_pending() {
+      if (_writer.joinable()) {
+        _run_on_writer([this] { _commit_group(); });
+      }
+    }
+
+    // runs job on the writer thread and waits for it, with _lock held
+    void _run_on_writer(const std::function<void()>& job) {
+      _check_group();
+      {
+        std::unique_lock<std::mutex> l(_writer_mutex);
+        _job = job;
+        _job_done = false;
+        _writer_cv.notify_all();
+        _writer_cv.wait(l, [this] { return _job_done; });
+      }
+      _check_group();
+    }
+
+    // The writer thread can not fail the caller of an insert it has
+    // acknowledged already, so a group that fails to commit fails the next
+    // insert, flush or commit instead, on the caller's thread. With _lock
+    // held, or the writer joined.
+    void _check_group() {
+      if (_group_error != MDB_SUCCESS) {
+        rc = _group_error;
+        _group_error = MDB_SUCCESS;
+        CHECK(false, "group commit");
+      }
+    }
+
+    void _write_loop() {
+      std::unique_lock<std::mutex> l(_writer_mutex);
+      while (true) {
+        if (_job) {
+          std::function<void()> job;
+          job.swap(_job);
+          l.unlock();
+          job();
+          l.lock();
+          _job_done = true;
+          _writer_cv.notify_all();
+          continue;
+        }
+        if (_writer_stop) {
+          _commit_group();
+          return;
+        }
+        if (_pending == NULL) {
+          _writer_cv.wait(l);
+          continue;
+        }
+        std::chrono::steady_clock::time_point due =
+          _pending_since + std::chrono::milliseconds(_group_delay_ms);
+        if (std::chrono::steady_clock::now() < due) {
+          _writer_cv.wait_until(l, due);
+        } else if (_lock.wait_or_lock(l)) {
+          // the commit may have to grow the map, which needs the
+          // transactions of this process closed, see _grow_map
+          l.unlock();
+          _commit_group();
+          _lock.unlock();
+          l.lock();
+        }
+        // else the holder of _lock handed a job over or released it
+      }
+    }
+
+    // on the writer thread only
+    void _add_to_group(S* items, size_t items_len, data_info* d) {
+      if (_pending == NULL) {
+        _begin_txn(0, &_pending);
+        _pending_since = std::chrono::steady_clock::now();
+        _pending_random = _tree_random;
+      }
+      _txn = _pending;
+      _insert(items, items_len, d);
+      _pending_ids.insert(_pending_ids.end(), items, items + items_len);
+      _pending_data.insert(_pending_data.end(), d, d + items_len);
+      if (_map_full) {
+        _regroup();
+      }
+      if (_pending_ids.size() >= _group_items) {
+        _commit_group();
+      }
+    }
+
+    // aborts the pending group and inserts it again into a grown map
+    void _regroup() {
+      while (true) {
+        if (_pending != NULL) {
+          mdb_txn_abort(_pending);
+        }
+        _grow_map();
+        _tree_random = _pending_random;
+        _begin_txn(0, &_pending);
+        _txn = _pending;
+        _insert(&_pending_ids[0], _pending_ids.size(), &_pending_data[0]);
+        if (!_map_full) {
+          return;
+        }
+      }
+    }
+
+    void _commit_group() {
+      while (_pending != NULL) {
+        int err = mdb_txn_commit(_pending);
+        _pending = NULL;
+        if (err == MDB_MAP_FULL) {
+          _regroup();
+          continue;
+        }
+        if (err != MDB_SUCCESS) {
+          // the items of the group are lost, see _check_group
+          fprintf(stderr, "group commit of %d items failed: %s\n", (int) _pending_ids.size(), mdb_strerror(err));
+          _group_error = err;
+        }
+      }
+      _pending_ids.clear();
+      _pending_data.clear();
+    }
+
+    void _flush_periodically(int interval_ms) {
+      while (true) {
+        {
+          std::unique_lock<std::mutex> l(_flush_mutex);
+          if (_flush_cv.wait_for(l, std::chrono::milliseconds(interval_ms),
+                                 [this] { return _flush_stop; })) {
+            return;
+          }
+        }
+        flush();
+      }
+    }
+
+    void _buffer_item(S item, const T* w) {
+      size_t row;
+      typename std::map<S, size_t>::iterator it = _buffer_rows.find(item);
+      if (it != _buffer_rows.end()) {
+        row = it->second; // a newer vector for a buffered item replaces it
+      } else {
+        row = _buffer_ids.size();
+        _buffer_ids.push_back(item);
+        _buffer_vectors.resize((row + 1) * _f);
+        _buffer_norms.resize(row + 1);
+        _buffer_rows[item] = row;
+      }
+      memcpy(&_buffer_vectors[row * _f], w, _f * sizeof(T));
+      _buffer_norms[row] = get_norm(&_buffer_vectors[row * _f], _f);
+      if (_buffer_ids.size() >= _buffer_capacity) {
+        _flush_buffer();
+      }
+    }
+
+    void _flush_buffer() {
+      size_t n = _buffer_ids.size();
+      if (n == 0) {
+        return;
+      }
+      vector<data_info> d(n);
+      for (size_t i = 0; i < n; i++) {
+        const T* w = &_buffer_vectors[i * _f];
+        d[i].mutable_data()->Reserve(_f);
+        for (int z = 0; z < _f; z++) {
+          d[i].add_data(w[z]);
+        }
+      }
+      add_item_batch(&_buffer_ids[0], n, &d[0]);
+      if (_verbose) {
+        printf("flushed %d buffered items\n", (int) n);
+      }
+      _buffer_ids.clear();
+      _buffer_vectors.clear();
+      _buffer_norms.clear();
+      _buffer_rows.clear();
+    }
+
+    // exact distances to all buffered items, in one dot_batch pass; a
+    // buffered item replaces the forest candidate of the same id, whose
+    // stored vector is older
+    void _scan_buffer(const T* v, vector<pair<T, S> >& nns_dist) {
+      size_t n = _buffer_ids.size();
+      if (n == 0) {
+        return;
+      }
+      size_t kept = 0;
+      for (size_t i = 0; i < nns_dist.size(); i++) {
+        if (_buffer_rows.find(nns_dist[i].second) == _buffer_rows.end()) {
+          nns_dist[kept++] = nns_dist[i];
+        }
+      }
+      nns_dist.resize(kept);
+      vector<T> dots(n);
+      dot_batch(v, &_buffer_vectors[0], n, _f, &dots[0]);
+      T v_norm = get_norm((T*) v, _f);
+      for (size_t i = 0; i < n; i++) {
+        T norms = v_norm * _buffer_norms[i];
+        T d = norms > 0 ? std::max<T>(0, D::distance_from_cos(dots[i] / norms)) : 2.0;
+        nns_dist.push_back(make_pair(d, _buffer_ids[i]));
+      }
+    }
+
+    // splitmix64 of seed and tree, so neighbouring trees get unrelated streams
+    static uint64_t _tree_seed(uint64_t seed, int tree) {
+      uint64_t z = seed + 0x9E3779B97F4A7C15ULL * (tree + 1);
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+      z ^= z >> 31;
+      return z ? z : 1; // the generators need a non zero seed
+    }
+
+    void _maintain(int interval_ms, double depth_ratio, double min_fill, size_t max_items) {
+      for (int t = 0; ; t = (t + 1) % _tree_count) {
+        {
+          std::unique_lock<std::mutex> l(_maintenance_mutex);
+          if (_maintenance_cv.wait_for(l, std::chrono::milliseconds(interval_ms),
+                                       [this] { return _maintenance_stop; })) {
+            return;
+          }
+        }
+        // one tree per wake up keeps each pause of the writers short
+        _rebalance_tree(t, depth_ratio, min_fill, max_items);
+      }
+    }
+
+    // a subtree planned by _plan_subtree: the old one as read, and the
+    // nodes to replace it with, nodes[0] in place of its root
+    struct subtree_plan {
+      int index;
+      vector<int> old_keys;
+      vector<string> old_nodes;
+      vector<tree_node> nodes;
+    };
+
+    struct subtree_shape {
+      size_t items;
+      size_t leaves;
+      int height; // a leaf has height 0
+      int left;
+      int right;
+    };
+
+    // inside a write transaction, stops once the map runs full
+    void _compact_tree(int tree, int layout) {
+      _open_trees(MDB_CREATE);
+
+      std::map<int, tree_node> nodes;
+      int height = _load_tree(_roots[tree], nodes, tree);
+      vector<int> order;
+      if (layout == LAYOUT_BFS) {
+        order.push_back(_roots[tree]);
+        for (size_t k = 0; k < order.size(); k++) {
+          const tree_node& tn = nodes[order[k]];
+          if (!tn.leaf()) {
+            order.push_back(tn.left());
+            order.push_back(tn.right());
+          }
+        }
+      } else {
+        _veb_order(_roots[tree], height + 1, nodes, order);
+      }
+
+      std::map<int, int> key; // old key to new
+      for (size_t k = 0; k < order.size(); k++) {
+        key[order[k]] = k;
+      }
+      E(mdb_drop(_txn, _dbi_trees[tree], 0));
+      string data_buffer;
+      for (size_t k = 0; k < order.size(); k++) {
+        tree_node& tn = nodes[order[k]];
+        tn.set_index(k);
+        if (!tn.leaf()) {
+          tn.set_left(key[tn.left()]);
+          tn.set_right(key[tn.right()]);
+        }
+        tn.SerializeToString(&data_buffer);
+        int index = k;
+        MDB_val k_val, d_val;
+        k_val.mv_data = (uint8_t*) & index;
+        k_val.mv_size = sizeof(int);
+        d_val.mv_data = (uint8_t*) data_buffer.c_str();
+        d_val.mv_size = data_buffer.length();
+        rc = mdb_put(_txn, _dbi_trees[tree], &k_val, &d_val, MDB_APPEND);
+        if (rc == MDB_MAP_FULL) {
+          _map_full = true;
+          return;
+        }
+        CHECK(rc == MDB_SUCCESS, "mdb_put");
+      }
+    }
+
+    // reads the subtree under index into nodes, returns its height
+    int _load_tree(int index, std::map<int, tree_node>& nodes, int tree) {
+      tree_node& tn = nodes[index];
+      if (!_get_node_by_index(index, tn, tree)) {
+        tn.set_leaf(true); // lost, kept as an empty leaf
+      }
+      if (tn.leaf()) {
+        return 0;
+      }
+      int l = _load_tree(tn.left(), nodes, tree);
+      int r = _load_tree(tn.right(), nodes, tree);
+      return 1 + std::max(l, r);
+    }
+
+    // appends the nodes less than levels below index, in van Emde Boas
+    // order: the top half of the levels, then each subtree hanging below it
+    void _veb_order(int index, int levels, std::map<int, tree_node>& nodes, vector<int>& order) {
+      if (levels == 1) {
+        order.push_back(index);
+        return;
+      }
+      int top = levels / 2;
+      _veb_order(index, top, nodes, order);
+      vector<int> below;
+      _frontier(index, top, nodes, below);
+      for (size_t k = 0; k < below.size(); k++) {
+        _veb_order(below[k], levels - top, nodes, order);
+      }
+    }
+
+    // the nodes exactly depth levels below index, left to right
+    void _frontier(int index, int depth, std::map<int, tree_node>& nodes, vector<int>& out) {
+      if (depth == 0) {
+        out.push_back(index);
+        return;
+      }
+      const tree_node& tn = nodes[index];
+      if (!tn.leaf()) {
+        _frontier(tn.left(), depth - 1, nodes, out);
+        _frontier(tn.right(), depth - 1, nodes, out);
+      }
+    }
+
+    struct FlatWriter {
+      FILE* file;
+      S next; // index of the next node written
+      size_t K;
+      vector<char> node;
+      bool failed; // a write failed, the file is not complete
+    };
+
+    void _write_file(FlatWriter& w, const void* data, size_t size) {
+      if (!w.failed && fwrite(data, size, 1, w.file) != 1) {
+        w.failed = true;
+      }
+    }
+
+    // appends one node, a list of count descendants or, when count > K, a
+    // split over the two children with hyperplane v (zero without), and
+    // returns its index
+    S _write_flat(FlatWriter& w, S count, const S* children, const T* v) {
+      std::fill(w.node.begin(), w.node.end(), 0);
+      Node* nd = (Node*) &w.node[0];
+      nd->n_descendants = count;
+      if (v != NULL) {
+        memcpy(nd->v, v, _f * sizeof(T));
+      }
+      // a long list runs on over v, only items keep a vector with it
+      if ((size_t) count <= w.K) {
+        if (count > 0) {
+          memcpy(nd->children, children, count * sizeof(S));
+        }
+      } else {
+        nd->children[0] = children[0];
+        nd->children[1] = children[1];
+      }
+      _write_file(w, &w.node[0], w.node.size());
+      return w.next++;
+    }
+
+    // writes the subtree under index children first and returns the index
+    // of its flat node. Subtrees of at most K items become one list.
+    S _flatten(FlatWriter& w, int index, std::map<int, subtree_shape>& shapes, int tree) {
+      const subtree_shape& s = shapes[index];
+      tree_node tn;
+      _get_node_by_index(index, tn, tree);
+      if (s.items <= w.K || tn.leaf()) {
+        vector<S> items;
+        vector<int> stack(1, index);
+        while (!stack.empty()) {
+          tree_node sub;
+          int i = stack.back();
+          stack.pop_back();
+          if (!_get_node_by_index(i, sub, tree)) {
+            continue;
+          }
+          if (sub.leaf()) {
+            items.insert(items.end(), sub.items().begin(), sub.items().end());
+          } else {
+            stack.push_back(sub.left());
+            stack.push_back(sub.right());
+          }
+        }
+        return _flatten_items(w, items, 0, items.size());
+      }
+      S children[2];
+      children[0] = _flatten(w, s.left, shapes, tree);
+      children[1] = _flatten(w, s.right, shapes, tree);
+      _widen(tn, _vector_type);
+      return _write_flat(w, s.items, children, tn.v_size() == _f ? tn.v().data() : NULL);
+    }
+
+    // a leaf too large for one list is cut in halves under zero hyperplanes,
+    // which queries descend on both sides
+    S _flatten_items(FlatWriter& w, const vector<S>& items, size_t begin, size_t end) {
+      if (end - begin == 1 && items[begin] < w.next) {
+        return items[begin]; // the item's own node lists it
+      }
+      if (end - begin <= w.K) {
+        return _write_flat(w, end - begin, end > begin ? &items[begin] : NULL, NULL);
+      }
+      size_t mid = begin + (end - begin) / 2;
+      S children[2];
+      children[0] = _flatten_items(w, items, begin, mid);
+      children[1] = _flatten_items(w, items, mid, end);
+      return _write_flat(w, end - begin, children, NULL);
+    }
+
+    // Subtrees are planned from a read transaction of their own, without
+    // _lock, so queries and inserts go on meanwhile. _lock is held to begin
+    // it and then for the write transaction that puts the planned subtrees
+    // in place of those nobody changed since.
+    size_t _rebalance_tree(int tree, double depth_ratio, double min_fill, size_t max_items) {
+      if (_read_only || tree < 0 || tree >= _tree_count) {
+        return 0;
+      }
+      MDB_txn* txn;
+      int root, capacity, vector_type;
+      Random random;
+      {
+        std::lock_guard<notifying_mutex> lock(_lock);
+        // DBIs opened in a committed transaction stay open for all of them
+        _begin_txn(MDB_RDONLY, &_txn);
+        if (mdb_dbi_open(_txn, DBN_RAW, MDB_INTEGERKEY, &_dbi_raw) != MDB_SUCCESS) {
+          mdb_txn_abort(_txn);
+          return 0; // no item yet
+        }
+        _open_trees(0);
+        E(mdb_txn_commit(_txn));
+        _begin_txn(MDB_RDONLY, &txn);
+        {
+          std::lock_guard<std::mutex> l(_detached_mutex);
+          _detached++;
+        }
+        root = _roots[tree];
+        capacity = _capacity;
+        vector_type = _vector_type;
+        random = _tree_random[tree];
+      }
+
+      std::map<int, subtree_shape> shapes;
+      _shape(txn, root, shapes, tree);
+      vector<int> degraded;
+      _select_degraded(root, shapes, depth_ratio, min_fill, capacity, max_items, degraded);
+      vector<subtree_plan> plans(degraded.size());
+      for (size_t i = 0; i < degraded.size(); i++) {
+        _plan_subtree(txn, degraded[i], tree, capacity, vector_type, random, plans[i]);
+      }
+      _end_detached(txn);
+      if (plans.empty()) {
+        return 0;
+      }
+
+      std::lock_guard<notifying_mutex> lock(_lock);
+      size_t rebuilt = 0;
+      _write([&] {
+        E(mdb_dbi_open(_txn, DBN_RAW, MDB_CREATE | MDB_INTEGERKEY, &_dbi_raw));
+        _open_trees(MDB_CREATE);
+        rebuilt = 0;
+        for (size_t i = 0; i < plans.size() && !_map_full; i++) {
+          if (_unchanged(plans[i], tree)) {
+            _put_subtree(plans[i], tree);
+            rebuilt++;
+          }
+        }
+        return true;
+      });
+      if (rebuilt > 0) {
+        _tree_random[tree] = random;
+      }
+      return rebuilt;
+    }
+
+    void _shape(MDB_txn* txn, int index, std::map<int, subtree_shape>& shapes, int tree) {
+      tree_node tn;
+      subtree_shape& s = shapes[index];
+      memset(&s, 0, sizeof(s));
+      if (!_get_node_by_index(txn, index, tn, tree)) {
+        return;
+      }
+      if (tn.leaf()) {
+        s.items = tn.items_size();
+        s.leaves = 1;
+        return;
+      }
+      s.left = tn.left();
+      s.right = tn.right();
+      _shape(txn, s.left, shapes, tree);
+      _shape(txn, s.right, shapes, tree);
+      const subtree_shape& l = shapes[s.left];
+      const subtree_shape& r = shapes[s.right];
+      s.items = l.items + r.items;
+      s.leaves = l.leaves + r.leaves;
+      s.height = 1 + std::max(l.height, r.height);
+    }
+
+    bool _degraded(const subtree_shape& s, double depth_ratio, double min_fill, int capacity) {
+      if (s.height < 2) {
+        return false;
+      }
+      int ideal = s.items > (size_t) capacity ? (int) ceil(log2((double) s.items / capacity)) : 0;
+      return s.height > depth_ratio * ideal + 1 || s.items < min_fill * s.leaves * capacity;
+    }
+
+    void _select_degraded(int index, std::map<int, subtree_shape>& shapes, double depth_ratio,
+                          double min_fill, int capacity, size_t& budget, vector<int>& out) {
+      const subtree_shape& s = shapes[index];
+      if (s.height < 2) {
+        return;
+      }
+      if (s.items <= budget && _degraded(s, depth_ratio, min_fill, capacity)) {
+        out.push_back(index);
+        budget -= s.items;
+        return;
+      }
+      _select_degraded(s.left, shapes, depth_ratio, min_fill, capacity, budget, out);
+      _select_degraded(s.right, shapes, depth_ratio, min_fill, capacity, budget, out);
+    }
+
+    // reads the subtree under index, as stored, and plans a balanced one
+    // over its items, without _lock
+    void _plan_subtree(MDB_txn* txn, int index, int tree, int capacity, int vector_type,
+                       Random& random, subtree_plan& plan) {
+      int rc; // for RES, the member is shared with the writers
+      plan.index = index;
+      vector<int> items;
+      vector<int> stack(1, index);
+      while (!stack.empty()) {
+        int i = stack.back();
+        stack.pop_back();
+        MDB_val key, data;
+        key.mv_data = (uint8_t*) & i;
+        key.mv_size = sizeof(int);
+        if (RES(MDB_NOTFOUND, mdb_get(txn, _dbi_trees[tree], &key, &data))) {
+          continue;
+        }
+        plan.old_keys.push_back(i);
+        plan.old_nodes.push_back(string((const char*) data.mv_data, data.mv_size));
+        tree_node tn;
+        tn.ParseFromArray(data.mv_data, data.mv_size);
+        if (tn.leaf()) {
+          items.insert(items.end(), tn.items().begin(), tn.items().end());
+        } else {
+          stack.push_back(tn.left());
+          stack.push_back(tn.right());
+        }
+      }
+
+      vector<T> vectors(items.size() * _f);
+      data_info d;
+      for (size_t k = 0; k < items.size(); k++) {
+        if (_parse_raw_data(txn, items[k], d)) {
+          _widen(d, vector_type);
+          memcpy(&vectors[k * _f], d.data().data(), _f * sizeof(T));
+        }
+      }
+      vector<int> rows(items.size());
+      for (size_t k = 0; k < rows.size(); k++) {
+        rows[k] = k;
+      }
+      SplitArena<T> arena;
+      _plan_build(rows, items, vectors, capacity, random, arena, plan.nodes);
+    }
+
+    // like _build_subtree, into nodes; returns the position of the new node,
+    // whose children are positions in nodes too
+    int _plan_build(const vector<int>& rows, const vector<int>& items, const vector<T>& vectors,
+                    int capacity, Random& random, SplitArena<T>& arena, vector<tree_node>& nodes) {
+      int pos = nodes.size();
+      nodes.push_back(tree_node());
+      tree_node tn;
+      tn.set_leaf(true);
+      for (size_t k = 0; k < rows.size(); k++) {
+        tn.add_items(items[rows[k]]);
+      }
+
+      if (rows.size() > (size_t) capacity) {
+        arena.points.resize(rows.size() * _f);
+        for (size_t k = 0; k < rows.size(); k++) {
+          memcpy(&arena.points[k * _f], &vectors[rows[k] * _f], _f * sizeof(T));
+        }
+        tree_node new_node, left_node, right_node;
+        D::split(tn, new_node, left_node, right_node, random, _f, arena);
+        vector<int> left_rows, right_rows;
+        for (size_t k = 0; k < rows.size(); k++) {
+          (arena.sides[k] ? left_rows : right_rows).push_back(rows[k]);
+        }
+        new_node.set_left(_plan_build(left_rows, items, vectors, capacity, random, arena, nodes));
+        new_node.set_right(_plan_build(right_rows, items, vectors, capacity, random, arena, nodes));
+        tn = new_node;
+      }
+      nodes[pos] = tn;
+      return pos;
+    }
+
+    // true when the subtree of plan is stored as it was planned from
+    bool _unchanged(const subtree_plan& plan, int tree) {
+      for (size_t k = 0; k < plan.old_keys.size(); k++) {
+        int index = plan.old_keys[k];
+        MDB_val key, data;
+        key.mv_data = (uint8_t*) & index;
+        key.mv_size = sizeof(int);
+        if (mdb_get(_txn, _dbi_trees[tree], &key, &data) != MDB_SUCCESS ||
+            plan.old_nodes[k].compare(0, string::npos, (const char*) data.mv_data, data.mv_size) != 0) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    // replaces the planned subtree, keeping its root key so the parent link
+    // stays valid; the other nodes get new keys
+    void _put_subtree(subtree_plan& plan, int tree) {
+      for (size_t k = 0; k < plan.old_keys.size(); k++) {
+        if (plan.old_keys[k] != plan.index) {
+          _del_tree_node(plan.old_keys[k], tree);
+        }
+      }
+      int base = _get_max_tree_index(tree) + 1;
+      for (size_t k = 0; k < plan.nodes.size() && !_map_full; k++) {
+        tree_node& tn = plan.nodes[k];
+        int index = k == 0 ? plan.index : base + (int) k - 1;
+        if (!tn.leaf()) {
+          tn.set_left(base + tn.left() - 1);
+          tn.set_right(base + tn.right() - 1);
+        } else if (tree < _leaf_embed_trees) {
+          for (int i = 0; i < tn.items_size(); i++) {
+            data_info d;
+            if (_get_raw_data(tn.items(i), d)) {
+              _append_record(d, *tn.mutable_leaf_data());
+            }
+          }
+        }
+        tn.set_index(index);
+        _update_tree_node(index, tn, tree);
+      }
+    }
+
+    // writes a balanced subtree over the given rows of items/vectors at
+    // index, or at a new node when index < 0, and returns its index
+    int _build_subtree(int index, const vector<int>& rows, const vector<int>& items,
+                       const vector<T>& vectors, int tree) {
+      if (_map_full) {
+        return -1;
+      }
+      SplitArena<T>& arena = _split[tree];
+      tree_node tn;
+      tn.set_leaf(true);
+      for (size_t k = 0; k < rows.size(); k++) {
+        tn.add_items(items[rows[k]]);
+      }
+
+      if (rows.size() > (size_t) _capacity) {
+        arena.points.resize(rows.size() * _f);
+        for (size_t k = 0; k < rows.size(); k++) {
+          memcpy(&arena.points[k * _f], &vectors[rows[k] * _f], _f * sizeof(T));
+        }
+        tree_node new_node, left_node, right_node;
+        D::split(tn, new_node, left_node, right_node, _tree_random[tree], _f, arena);
+        vector<int> left_rows, right_rows;
+        for (size_t k = 0; k < rows.size(); k++) {
+          (arena.sides[k] ? left_rows : right_rows).push_back(rows[k]);
+        }
+        new_node.set_left(_build_subtree(-1, left_rows, items, vectors, tree));
+        new_node.set_right(_build_subtree(-1, right_rows, items, vectors, tree));
+        tn = new_node;
+      } else if (tree < _leaf_embed_trees) {
+        for (size_t k = 0; k < rows.size(); k++) {
+          _append_record(&vectors[rows[k] * _f], *tn.mutable_leaf_data());
+        }
+      }
+
+      if (index < 0) {
+        return _add_node(tn, tree);
+      }
+      tn.set_index(index);
+      _update_tree_node(index, tn, tree);
+      return index;
+    }
+
+    bool _del_tree_node(int index, int tree) {
+      MDB_val key;
+      key.mv_data = (uint8_t*) & index;
+      key.mv_size = sizeof(int);
+      return mdb_del(_txn, _dbi_trees[tree], &key, NULL) == MDB_SUCCESS;
+    }
+
+    // opens the DBI of every tree in _txn
+    void _open_trees(unsigned int flags) {
+      _dbi_trees.resize(_tree_count);
+      char name[32];
+      for (int t = 0; t < _tree_count; t++) {
+        if (_tree_dbs) {
+          snprintf(name, sizeof(name), "%s.%d", DBN_TREE, t);
+        } else {
+          snprintf(name, sizeof(name), "%s", DBN_TREE);
+        }
+        E(mdb_dbi_open(_txn, name, flags | MDB_INTEGERKEY, &_dbi_trees[t]));
+      }
+    }
+
+    void _update_capacity() {
+      if (_leaf_page_size == 0) {
+        _capacity = _K;
+        return;
+      }
+      // each item costs its id and its record, a leaf also pays for the
+      // LMDB page and node headers and its own protobuf fields
+      int per_item = _record_size() + sizeof(S);
+      _capacity = std::max(2, (_leaf_page_size - LEAF_OVERHEAD) / per_item);
+    }
+
+    void _load_meta() {
+      MDB_txn *txn;
+      MDB_dbi dbi_meta;
+      MDB_val key, data;
+
+      _begin_txn(MDB_RDONLY, &txn);
+      // indexes written before DBN_META existed have no such database
+      if (mdb_dbi_open(txn, DBN_META, 0, &dbi_meta) == MDB_SUCCESS) {
+        key.mv_data = (void*) META_KEY;
+        key.mv_size = strlen(META_KEY);
+        if (mdb_get(txn, dbi_meta, &key, &data) == MDB_SUCCESS) {
+          index_meta meta;
+          meta.ParseFromArray(data.mv_data, data.mv_size);
+          _codec = meta.codec();
+          _vector_type = meta.vector_type();
+          _leaf_embed_trees = meta.leaf_embed_trees();
+          _tree_dbs = meta.tree_dbs();
+          _leaf_page_size = meta.leaf_page_size();
+          if (meta.has_leaf_capacity()) {
+            _capacity = meta.leaf_capacity();
+          }
+          if (meta.has_seed()) {
+            _reseed(meta.seed());
+          }
+        }
+
+        key.mv_data = (void*) PQ_KEY;
+        key.mv_size = strlen(PQ_KEY);
+        if (mdb_get(txn, dbi_meta, &key, &data) == MDB_SUCCESS) {
+          pq_codebook codebook;
+          codebook.ParseFromArray(data.mv_data, data.mv_size);
+          _pq.init(_f, codebook.m(), codebook.nbits());
+          if (codebook.centroids_size() == (int) _pq.centroids.size()) {
+            std::copy(codebook.centroids().begin(), codebook.centroids().end(), _pq.centroids.begin());
+          }
+        }
+      }
+      mdb_txn_abort(txn);
+      _roots.assign(_tree_count, 0);
+      for (int i = 0; i < _tree_count && !_tree_dbs; i ++) {
+        _roots[i] = i;
+      }
+    }
+
+    // must be called inside a write transaction
+    void _save_meta() {
+      if (_map_full) {
+        return;
+      }
+      MDB_dbi dbi_meta;
+      MDB_val key, data;
+      E(mdb_dbi_open(_txn, DBN_META, MDB_CREATE, &dbi_meta));
+
+      index_meta meta;
+      meta.set_codec(_codec);
+      meta.set_vector_type(_vector_type);
+      meta.set_leaf_embed_trees(_leaf_embed_trees);
+      meta.set_leaf_page_size(_leaf_page_size);
+      meta.set_leaf_capacity(_capacity);
+      meta.set_tree_dbs(_tree_dbs);
+      meta.set_seed(_seed);
+      string data_buffer;
+      meta.SerializeToString(&data_buffer);
+
+      key.mv_data = (void*) META_KEY;
+      key.mv_size = strlen(META_KEY);
+      data.mv_size = data_buffer.length();
+      data.mv_data = (uint8_t*)data_buffer.c_str();
+      _put_meta(dbi_meta, &key, &data);
+    }
+
+    // must be called inside a write transaction
+    void _save_codebook() {
+      if (_map_full) {
+        return;
+      }
+      MDB_dbi dbi_meta;
       MDB_val key, data;
-      MDB_txn *txn;
-      MDB_dbi dbi;
-      bool success = true;
-      
-      _roots.clear();
-      
+      E(mdb_dbi_open(_txn, DBN_META, MDB_CREATE, &dbi_meta));
 
-      E(mdb_txn_begin(_env, NULL, 0 , &txn));
-      MDB_dbi dbi_tree;
-      E(mdb_dbi_open(txn, DBN_TREE, MDB_CREATE | MDB_INTEGERKEY, &dbi_tree));
-      for (int i = 0; i < _tree_count; i ++) {
-        key.mv_data = (uint8_t*) & i;
-        key.mv_size = sizeof(int);
-        tree_node tn;
-        tn.set_index(i);
-        tn.set_leaf(true);
-        tn.clear_left();
-        tn.clear_right();
-        tn.clear_items();
-        string str;
-        tn.SerializeToString(&str);
-        data.mv_data = (uint8_t*)str.c_str();
-        data.mv_size = str.length();
-        int retval = mdb_put(txn, dbi_tree, &key, &data, 0);
-        if (retval != MDB_SUCCESS) {
-            printf("failed add root for tree %d, due to %s \n" , i, mdb_strerror(retval));
-            fflush(stdout);
-            success = false;
-            break;
-        }
-        _roots.push_back(i);
+      pq_codebook codebook;
+      codebook.set_m(_pq.m);
+      codebook.set_nbits(_pq.nbits);
+      for (size_t i = 0; i < _pq.centroids.size(); i++) {
+        codebook.add_centroids(_pq.centroids[i]);
       }
-      if (success) {
-        E(mdb_txn_commit(txn));
-      } else {
-        mdb_txn_abort(txn);
+      string data_buffer;
+      codebook.SerializeToString(&data_buffer);
+
+      key.mv_data = (void*) PQ_KEY;
+      key.mv_size = strlen(PQ_KEY);
+      data.mv_size = data_buffer.length();
+      data.mv_data = (uint8_t*)data_buffer.c_str();
+      _put_meta(dbi_meta, &key, &data);
+    }
+  
+    void _put_meta(MDB_dbi dbi_meta, MDB_val* key, MDB_val* data) {
+      rc = mdb_put(_txn, dbi_meta, key, data, 0);
+      if (rc == MDB_MAP_FULL) {
+        _map_full = true;
+        return;
+      }
+      CHECK(rc == MDB_SUCCESS, "mdb_put");
+    }
+
+    // every tree starts over as an empty leaf at key 0 of its own DBI
+    bool init_roots() {
+      std::lock_guard<notifying_mutex> lock(_lock);
+      bool legacy = !_tree_dbs;
+      bool success = _write([&] {
+        // trees of an index written before per tree DBIs, all in DBN_TREE
+        MDB_dbi dbi_tree;
+        if (legacy && mdb_dbi_open(_txn, DBN_TREE, MDB_INTEGERKEY, &dbi_tree) == MDB_SUCCESS) {
+          E(mdb_drop(_txn, dbi_tree, 1));
+        }
+        _tree_dbs = true;
+        _open_trees(MDB_CREATE);
+        _roots.clear();
+        bool ok = true;
+        for (int i = 0; i < _tree_count && ok; i ++) {
+          ok = _init_root(i);
+          _roots.push_back(0);
+        }
+        if (ok) {
+          _save_meta();
+        }
+        return ok;
+      });
+      if (!success) {
+        _tree_dbs = !legacy;
         _roots.clear();
       }
       if (success && _verbose) {
         for (int i = 0; i < _tree_count; i ++) {
-          display_node(i);
+          display_node(_roots[i], i);
         }
       }
 
       return success;
     }
+
+    // empties a tree, with its DBI open in _txn
+    bool _init_root(int tree) {
+      E(mdb_drop(_txn, _dbi_trees[tree], 0));
+      tree_node tn;
+      tn.set_index(0);
+      tn.set_leaf(true);
+      if (!_update_tree_node(0, tn, tree)) {
+        if (_map_full) {
+          return false;
+        }
+        printf("failed add root for tree %d\n", tree);
+        fflush(stdout);
+        return false;
+      }
+      return true;
+    }
   
   
-    int _get_max_tree_index() {
+    int _get_max_tree_index(int tree) {
       
         MDB_val key, data;
         MDB_cursor *cursor;
         
         
-        E(mdb_cursor_open(_txn, _dbi_tree, &cursor));
+        E(mdb_cursor_open(_txn, _dbi_trees[tree], &cursor));
         rc = mdb_cursor_get(cursor, &key, &data, MDB_LAST);
 
-        int index_last = 0;
-        memcpy(&index_last, key.mv_data, sizeof(int));
+        int index_last = -1; // empty tree
+        if (rc == MDB_SUCCESS) {
+          memcpy(&index_last, key.mv_data, sizeof(int));
+        }
         
         //int index_last = atoi((char*)key.mv_data);
 
@@ -642,8 +3112,10 @@ class AnnoyIndex : public AnnoyIndexInterface<S, T> {
         E(mdb_cursor_open(_txn, _dbi_raw, &cursor));
         rc = mdb_cursor_get(cursor, &key, &data, MDB_LAST);
 
-        int index_last = 0;
-        memcpy(&index_last, key.mv_data, sizeof(int));
+        int index_last = -1; // no item yet
+        if (rc == MDB_SUCCESS) {
+          memcpy(&index_last, key.mv_data, sizeof(int));
+        }
         
         //int index_last = atoi((char*)key.mv_data);
 
@@ -659,16 +3131,19 @@ class AnnoyIndex : public AnnoyIndexInterface<S, T> {
     }
     
     
-    int _add_node(tree_node & tn) {
+    int _add_node(tree_node & tn, int tree) {
+        if (_map_full) {
+          return -1;
+        }
         
         //get the largest index
-        int max_index = _get_max_tree_index();
+        int max_index = _get_max_tree_index(tree);
 
         if (_verbose) {
           printf("adding node %d : ", max_index + 1);
         }
         tn.set_index(max_index + 1);
-        bool result = _update_tree_node(max_index + 1, tn);       
+        bool result = _update_tree_node(max_index + 1, tn, tree);       
        //max_index = _get_max_tree_index();
         if (result)
           return max_index + 1;
@@ -676,21 +3151,24 @@ class AnnoyIndex : public AnnoyIndexInterface<S, T> {
         
     }
     
-    bool _update_tree_node(int index, tree_node & tn) {
+    bool _update_tree_node(int index, tree_node & tn, int tree) {
         int success = 0;
+        if (_map_full) {
+          return false;
+        }
         MDB_val key, data;
         
         key.mv_data = (uint8_t*) & index;
         key.mv_size = sizeof(int);
         
         string data_buffer;
-        tn.SerializeToString(&data_buffer);
+        _pack(tn, data_buffer);
         
         data.mv_size = data_buffer.length();
         data.mv_data = (uint8_t*)data_buffer.c_str();
 
         
-        int retval = mdb_put(_txn, _dbi_tree, &key, &data, 0);
+        int retval = mdb_put(_txn, _dbi_trees[tree], &key, &data, 0);
         
         
         if (retval == MDB_SUCCESS) {
@@ -708,6 +3186,10 @@ class AnnoyIndex : public AnnoyIndexInterface<S, T> {
             
             success = 1;
         }
+        else if (retval == MDB_MAP_FULL) {
+            // the writer grows the map and inserts again
+            _map_full = true;
+        }
         else if (retval == MDB_KEYEXIST) {
             printf(" key/data pair is duplicated.\n");
             success = 0;
@@ -725,12 +3207,16 @@ class AnnoyIndex : public AnnoyIndexInterface<S, T> {
 
     }
     
-    bool _get_node_by_index(int index,  tree_node & tn ) {
+    bool _get_node_by_index(int index,  tree_node & tn, int tree) {
+        return _get_node_by_index(_txn, index, tn, tree);
+    }
+
+    bool _get_node_by_index(MDB_txn* txn, int index,  tree_node & tn, int tree) {
         
         MDB_val key, data;
         key.mv_data = (uint8_t*) & index;
         key.mv_size = sizeof(int);
-        rc = mdb_get(_txn, _dbi_tree, &key, &data);
+        int rc = mdb_get(txn, _dbi_trees[tree], &key, &data);
         if (rc == 0) {
             string s_data((char*) data.mv_data, data.mv_size);
             tn.ParseFromString(s_data);
@@ -744,11 +3230,38 @@ class AnnoyIndex : public AnnoyIndexInterface<S, T> {
        
     
     bool _get_raw_data(int data_id,  data_info & rdata ) {
+        if (!_parse_raw_data(data_id, rdata)) {
+            return _get_buffered_data(data_id, rdata);
+        }
+        _widen(rdata, _vector_type);
+        return true;
+    }
+
+    bool _get_buffered_data(int data_id, data_info & rdata) {
+        typename std::map<S, size_t>::iterator it = _buffer_rows.find(data_id);
+        if (it == _buffer_rows.end()) {
+            return false;
+        }
+        const T* w = &_buffer_vectors[it->second * _f];
+        rdata.Clear();
+        for (int z = 0; z < _f; z++) {
+            rdata.add_data(w[z]);
+        }
+        rdata.set_id(data_id);
+        return true;
+    }
+
+    // like _get_raw_data, but leaves a half precision vector in hdata
+    bool _parse_raw_data(int data_id,  data_info & rdata ) {
+        return _parse_raw_data(_txn, data_id, rdata);
+    }
+
+    bool _parse_raw_data(MDB_txn* txn, int data_id,  data_info & rdata ) {
  
         MDB_val key, data;
         key.mv_data = (uint8_t*) & data_id;
         key.mv_size = sizeof(int);
-        rc = mdb_get(_txn, _dbi_raw, &key, &data);
+        int rc = mdb_get(txn, _dbi_raw, &key, &data);
         if (rc == 0) {
             string s_data((char*) data.mv_data, data.mv_size);
             rdata.ParseFromString(s_data);
@@ -761,6 +3274,29 @@ class AnnoyIndex : public AnnoyIndexInterface<S, T> {
     }
     
     
+    int _add_code(int data_id, data_info& rdata) {
+        MDB_val key, data;
+        key.mv_data = (uint8_t*) & data_id;
+        key.mv_size = sizeof(int);
+
+        string data_buffer;
+        _append_record(rdata, data_buffer);
+
+        data.mv_size = data_buffer.size();
+        data.mv_data = (uint8_t*)data_buffer.c_str();
+
+        int retval = mdb_put(_txn, _dbi_code, &key, &data, 0);
+        if (retval == MDB_MAP_FULL) {
+            _map_full = true;
+            return 0;
+        }
+        if (retval != MDB_SUCCESS) {
+            printf("failed to put code for %d, due to : %s\n", data_id, mdb_strerror(retval));
+            return 0;
+        }
+        return 1;
+    }
+
     int _add_raw_data(int data_id, data_info& rdata) {
         
         int success = 0;
@@ -770,7 +3306,7 @@ class AnnoyIndex : public AnnoyIndexInterface<S, T> {
         key.mv_size = sizeof(int);
         
         string data_buffer;
-        rdata.SerializeToString(&data_buffer);
+        _pack(rdata, data_buffer);
         
         data.mv_size = data_buffer.length();
         data.mv_data = (uint8_t*)data_buffer.c_str();
@@ -793,6 +3329,10 @@ class AnnoyIndex : public AnnoyIndexInterface<S, T> {
             }
 
         }
+        else if (retval == MDB_MAP_FULL) {
+            // the writer grows the map and inserts again
+            _map_full = true;
+        }
         else if (retval == MDB_KEYEXIST) {
             printf(" key/data pair is duplicated.\n");
             success = 0;
@@ -813,4 +3353,613 @@ class AnnoyIndex : public AnnoyIndexInterface<S, T> {
 
 
 
+// Serving handle over successive versions of a read-only index, each in its
+// own directory. Every call runs against a reference to the version that
+// was current when it started, so swap() can open and warm the next version
+// off to the side, publish it for new calls, and close the old one only once
+// the calls still running on it have returned. A swap fails no query.
+template<typename S, typename T>
+class AnnoyHandle : public AnnoyIndexInterface<S, T> {
+  public:
+    typedef AnnoyIndexInterface<S, T> Index;
+    // opens a version read only, NULL when there is none in the directory
+    typedef std::function<Index*(const char*)> Opener;
+
+  protected:
+    std::shared_ptr<Index> _current;
+    std::mutex _current_mutex; // held only to copy or replace _current
+    std::mutex _drain_mutex;
+    std::condition_variable _drained;
+    std::set<Index*> _released; // versions whose last reference is gone
+    std::mutex _swap_mutex; // one swap at a time
+    Opener _open;
+    string _dir; // of the current version
+    uint64_t _version; // number of swaps done
+    std::thread _swapper; // see swap_async
+    bool _swapped;
+
+    std::shared_ptr<Index> _get() {
+      std::lock_guard<std::mutex> lock(_current_mutex);
+      return _current;
+    }
+
+    // a reference to index that, once the last copy is gone, only reports
+    // it; the version is closed by whoever waits for that in _drain
+    std::shared_ptr<Index> _share(Index* index) {
+      return std::shared_ptr<Index>(index, [this](Index* released) {
+        std::lock_guard<std::mutex> lock(_drain_mutex);
+        _released.insert(released);
+        _drained.notify_all();
+      });
+    }
+
+    // drops the reference to a version, waits for the calls still running
+    // on it to return, and closes it
+    void _drain(std::shared_ptr<Index>& version) {
+      Index* index = version.get();
+      version.reset();
+      {
+        std::unique_lock<std::mutex> lock(_drain_mutex);
+        _drained.wait(lock, [this, index]() { return _released.count(index) > 0; });
+        _released.erase(index);
+      }
+      delete index;
+    }
+
+  public:
+    AnnoyHandle(Index* index, const char* dir, Opener open) : _open(open), _dir(dir) {
+      _current = _share(index);
+      _version = 0;
+      _swapped = false;
+    }
+
+    ~AnnoyHandle() {
+      wait_swap();
+      _drain(_current);
+    }
+
+    // opens the version in dir, warms its top levels (see warm_up) and
+    // makes it current, then waits for the readers of the old version to
+    // drain before closing it
+    bool swap(const char* dir, int warm_levels, bool warm_raw, int budget_ms) {
+      std::lock_guard<std::mutex> lock(_swap_mutex);
+      // LMDB must not open an environment twice in one process
+      if (_dir == dir) {
+        printf("ERROR: %s is the current version\n", dir);
+        return false;
+      }
+      Index* opened = _open(dir);
+      if (opened == NULL) {
+        printf("ERROR: no index at %s\n", dir);
+        return false;
+      }
+      std::shared_ptr<Index> next = _share(opened);
+      if (warm_levels > 0 || warm_raw) {
+        next->warm_up(warm_levels, warm_raw, false, budget_ms);
+      }
+
+      std::shared_ptr<Index> old;
+      {
+        std::lock_guard<std::mutex> current_lock(_current_mutex);
+        old = _current;
+        _current = next;
+        _dir = dir;
+        _version++;
+      }
+      next.reset();
+      // no call can take the old version any more, the ones that did hold
+      // a reference until they return
+      _drain(old);
+      return true;
+    }
+
+    // swap() on a background thread, wait_swap() returns its result. Both
+    // are meant to be called from one control thread.
+    void swap_async(const char* dir, int warm_levels, bool warm_raw, int budget_ms) {
+      wait_swap();
+      string d(dir);
+      _swapper = std::thread([this, d, warm_levels, warm_raw, budget_ms]() {
+        _swapped = swap(d.c_str(), warm_levels, warm_raw, budget_ms);
+      });
+    }
+
+    bool wait_swap() {
+      if (_swapper.joinable()) {
+        _swapper.join();
+      }
+      return _swapped;
+    }
+
+    uint64_t get_version() {
+      std::lock_guard<std::mutex> lock(_current_mutex);
+      return _version;
+    }
+
+    void add_item(S item, const T* w) { _get()->add_item(item, w); }
+    void add_item_batch(S* items, size_t items_len, T** w) { _get()->add_item_batch(items, items_len, w); }
+    void build(int q) { _get()->build(q); }
+    bool save(const char* filename) { return _get()->save(filename); }
+    void reinitialize() { _get()->reinitialize(); }
+    void unload() { _get()->unload(); }
+    bool load(const char* filename) { return _get()->load(filename); }
+    T get_distance(S i, S j) { return _get()->get_distance(i, j); }
+    void get_nns_by_item(S item, size_t n, size_t search_k, vector<S>* result, vector<T>* distances) {
+      _get()->get_nns_by_item(item, n, search_k, result, distances);
+    }
+    void get_nns_by_vector(const T* w, size_t n, size_t search_k, vector<S>* result, vector<T>* distances) {
+      _get()->get_nns_by_vector(w, n, search_k, result, distances);
+    }
+    S get_n_items() { return _get()->get_n_items(); }
+    void verbose(bool v) { _get()->verbose(v); }
+    void get_item(S item, vector<T>* v) { _get()->get_item(item, v); }
+    void set_codec(int codec) { _get()->set_codec(codec); }
+    void set_rerank(size_t rerank_k) { _get()->set_rerank(rerank_k); }
+    void set_vector_type(int vector_type) { _get()->set_vector_type(vector_type); }
+    bool train_pq(int m, int nbits, size_t sample_size) { return _get()->train_pq(m, nbits, sample_size); }
+    void set_leaf_embedding(int trees) { _get()->set_leaf_embedding(trees); }
+    bool get_tree_stats(int tree, tree_stats* stats) { return _get()->get_tree_stats(tree, stats); }
+    size_t rebalance(double depth_ratio, double min_fill, size_t max_items) {
+      return _get()->rebalance(depth_ratio, min_fill, max_items);
+    }
+    bool rebuild_tree(int tree) { return _get()->rebuild_tree(tree); }
+    bool compact_trees(int layout) { return _get()->compact_trees(layout); }
+    bool start_maintenance(int interval_ms, double depth_ratio, double min_fill, size_t max_items) {
+      return _get()->start_maintenance(interval_ms, depth_ratio, min_fill, max_items);
+    }
+    void stop_maintenance() { _get()->stop_maintenance(); }
+    void set_leaf_page_size(int page_size) { _get()->set_leaf_page_size(page_size); }
+    int get_leaf_capacity() { return _get()->get_leaf_capacity(); }
+    void set_seed(uint64_t seed) { _get()->set_seed(seed); }
+    bool set_write_buffer(size_t capacity, int flush_interval_ms) {
+      return _get()->set_write_buffer(capacity, flush_interval_ms);
+    }
+    void flush() { _get()->flush(); }
+    void set_group_commit(size_t max_items, int max_delay_ms) { _get()->set_group_commit(max_items, max_delay_ms); }
+    void set_durability(int policy) { _get()->set_durability(policy); }
+    void get_map_usage(map_usage* usage) { _get()->get_map_usage(usage); }
+    size_t warm_up(int levels, bool raw, bool lock, int budget_ms) {
+      return _get()->warm_up(levels, raw, lock, budget_ms);
+    }
+    bool compact(const char* dest_dir, int layout, page_report* before, page_report* after) {
+      return _get()->compact(dest_dir, layout, before, after);
+    }
+    bool create() { return _get()->create(); }
+    void display_node(S item, int tree) { _get()->display_node(item, tree); }
+    void display_raw(S item) { _get()->display_raw(item); }
+};
+
+
+// Forest partitioned by item id over several environments, the shards, in
+// dir/shard.<i>. An LMDB environment has one writer at a time, so inserts
+// are split by shard and each shard writes on its own worker thread, with
+// its own trees, write buffer and group commit. A query runs on every shard
+// at once, on the same workers, and their top n lists are merged by
+// distance.
+template<typename S, typename T, template<typename, typename, typename> class Distance, class Random>
+class AnnoyShardedIndex : public AnnoyIndexInterface<S, T> {
+  protected:
+    typedef Distance<S, T, Random> D;
+    typedef AnnoyIndex<S, T, Distance, Random> Shard;
+
+    // one per shard, started once and fed jobs by _each
+    struct shard_worker {
+      std::thread thread;
+      std::mutex mutex;
+      std::condition_variable cv;
+      std::deque<std::function<void()> > jobs;
+      bool stop;
+    };
+
+    int _f;
+    vector<Shard*> _shards;
+    vector<std::unique_ptr<shard_worker> > _workers; // empty with one shard
+
+    int _shard(S item) {
+      // mixes the id so runs of ids spread evenly
+      uint64_t h = ((uint64_t) item + 1) * 0x9E3779B97F4A7C15ULL;
+      return (int) ((h >> 32) % _shards.size());
+    }
+
+    // runs fn(shard) for every shard, each on the worker of its shard, and
+    // waits for them; the first exception of fn is thrown again here
+    void _each(const std::function<void(int)>& fn) {
+      if (_workers.empty()) {
+        fn(0);
+        return;
+      }
+      std::mutex done_mutex;
+      std::condition_variable done_cv;
+      size_t left = _workers.size();
+      std::exception_ptr error;
+      for (size_t i = 0; i < _workers.size(); i++) {
+        shard_worker& w = *_workers[i];
+        std::lock_guard<std::mutex> l(w.mutex);
+        w.jobs.push_back([&, i] {
+          std::exception_ptr e;
+          try {
+            fn((int) i);
+          } catch (...) {
+            e = std::current_exception();
+          }
+          std::lock_guard<std::mutex> done(done_mutex);
+          if (e && !error) {
+            error = e;
+          }
+          if (--left == 0) {
+            done_cv.notify_all();
+          }
+        });
+        w.cv.notify_one();
+      }
+      std::unique_lock<std::mutex> l(done_mutex);
+      done_cv.wait(l, [&] { return left == 0; });
+      if (error) {
+        std::rethrow_exception(error);
+      }
+    }
+
+    void _work(shard_worker* w) {
+      std::unique_lock<std::mutex> l(w->mutex);
+      while (true) {
+        w->cv.wait(l, [w] { return w->stop || !w->jobs.empty(); });
+        if (w->jobs.empty()) {
+          return;
+        }
+        std::function<void()> job;
+        job.swap(w->jobs.front());
+        w->jobs.pop_front();
+        l.unlock();
+        job();
+        l.lock();
+      }
+    }
+
+    string _path(const char* base, int shard) {
+      char name[32];
+      snprintf(name, sizeof(name), "/shard.%d", shard);
+      return string(base) + name;
+    }
+
+  public:
+    AnnoyShardedIndex(int f, int K, int r, const char* dir, int shards, int maxreaders, uint64_t maxsize, int read_only) {
+      _f = f;
+      for (int i = 0; i < std::max(shards, 1); i++) {
+        string path = _path(dir, i);
+        if (read_only != 1) {
+          mkdir(path.c_str(), 0775);
+        }
+        _shards.push_back(new Shard(f, K, r, path.c_str(), maxreaders, maxsize, read_only));
+      }
+      for (size_t i = 0; _shards.size() > 1 && i < _shards.size(); i++) {
+        _workers.push_back(std::unique_ptr<shard_worker>(new shard_worker()));
+        _workers[i]->stop = false;
+        _workers[i]->thread = std::thread(&AnnoyShardedIndex::_work, this, _workers[i].get());
+      }
+    }
+
+    ~AnnoyShardedIndex() {
+      for (size_t i = 0; i < _workers.size(); i++) {
+        {
+          std::lock_guard<std::mutex> l(_workers[i]->mutex);
+          _workers[i]->stop = true;
+        }
+        _workers[i]->cv.notify_one();
+        _workers[i]->thread.join();
+      }
+      for (size_t i = 0; i < _shards.size(); i++) {
+        delete _shards[i];
+      }
+    }
+
+    void add_item(S item, const T* w) {
+      _shards[_shard(item)]->add_item(item, w);
+    }
+
+    void add_item_batch(S* items, size_t items_len, T** w) {
+      vector<vector<S> > ids(_shards.size());
+      vector<vector<T*> > vectors(_shards.size());
+      for (size_t i = 0; i < items_len; i++) {
+        int s = _shard(items[i]);
+        ids[s].push_back(items[i]);
+        vectors[s].push_back(w[i]);
+      }
+      _each([&](int s) {
+        if (!ids[s].empty()) {
+          _shards[s]->add_item_batch(&ids[s][0], ids[s].size(), &vectors[s][0]);
+        }
+      });
+    }
+
+    void build(int q) {
+      _each([&](int s) { _shards[s]->build(q); });
+    }
+
+    // one flat file per shard, filename.<i>
+    bool save(const char* filename) {
+      bool ok = true;
+      for (size_t i = 0; i < _shards.size(); i++) {
+        ok = _shards[i]->save((string(filename) + "." + std::to_string(i)).c_str()) && ok;
+      }
+      return ok;
+    }
+
+    void reinitialize() {
+      for (size_t i = 0; i < _shards.size(); i++) {
+        _shards[i]->reinitialize();
+      }
+    }
+
+    void unload() {
+      for (size_t i = 0; i < _shards.size(); i++) {
+        _shards[i]->unload();
+      }
+    }
+
+    bool load(const char* filename) {
+      bool ok = true;
+      for (size_t i = 0; i < _shards.size(); i++) {
+        ok = _shards[i]->load((string(filename) + "." + std::to_string(i)).c_str()) && ok;
+      }
+      return ok;
+    }
+
+    T get_distance(S i, S j) {
+      vector<T> vi, vj;
+      get_item(i, &vi);
+      get_item(j, &vj);
+      if ((int) vi.size() != _f || (int) vj.size() != _f) {
+        return 0;
+      }
+      return D::distance(&vi[0], &vj[0], _f);
+    }
+
+    void get_nns_by_item(S item, size_t n, size_t search_k, vector<S>* result, vector<T>* distances) {
+      vector<T> v;
+      get_item(item, &v);
+      if ((int) v.size() == _f) {
+        get_nns_by_vector(&v[0], n, search_k, result, distances);
+      }
+    }
+
+    // search_k applies to each shard
+    void get_nns_by_vector(const T* w, size_t n, size_t search_k, vector<S>* result, vector<T>* distances) {
+      vector<vector<S> > ids(_shards.size());
+      vector<vector<T> > dists(_shards.size());
+      _each([&](int s) {
+        _shards[s]->get_nns_by_vector(w, n, search_k, &ids[s], &dists[s]);
+      });
+
+      // k-way merge, each list is sorted by distance
+      typedef pair<T, int> Head; // distance, shard
+      std::priority_queue<Head, vector<Head>, std::greater<Head> > heads;
+      vector<size_t> next(_shards.size(), 0);
+      for (size_t s = 0; s < _shards.size(); s++) {
+        if (!dists[s].empty()) {
+          heads.push(make_pair(dists[s][0], (int) s));
+        }
+      }
+      while (!heads.empty() && result->size() < n) {
+        int s = heads.top().second;
+        heads.pop();
+        result->push_back(ids[s][next[s]]);
+        if (distances) {
+          distances->push_back(dists[s][next[s]]);
+        }
+        if (++next[s] < dists[s].size()) {
+          heads.push(make_pair(dists[s][next[s]], s));
+        }
+      }
+    }
+
+    // like AnnoyIndex, the largest id + 1 rather than a count: the largest
+    // id over the shards, since each holds some of the ids
+    S get_n_items() {
+      S n = 0;
+      for (size_t i = 0; i < _shards.size(); i++) {
+        n = std::max(n, _shards[i]->get_n_items());
+      }
+      return n;
+    }
+
+    void verbose(bool v) {
+      for (size_t i = 0; i < _shards.size(); i++) {
+        _shards[i]->verbose(v);
+      }
+    }
+
+    void get_item(S item, vector<T>* v) {
+      _shards[_shard(item)]->get_item(item, v);
+    }
+
+    void set_codec(int codec) {
+      _each([&](int s) { _shards[s]->set_codec(codec); });
+    }
+
+    void set_rerank(size_t rerank_k) {
+      for (size_t i = 0; i < _shards.size(); i++) {
+        _shards[i]->set_rerank(rerank_k);
+      }
+    }
+
+    void set_vector_type(int vector_type) {
+      _each([&](int s) { _shards[s]->set_vector_type(vector_type); });
+    }
+
+    // each shard trains its own codebooks on its own items
+    bool train_pq(int m, int nbits, size_t sample_size) {
+      vector<char> ok(_shards.size());
+      _each([&](int s) { ok[s] = _shards[s]->train_pq(m, nbits, sample_size); });
+      return std::find(ok.begin(), ok.end(), 0) == ok.end();
+    }
+
+    void set_leaf_embedding(int trees) {
+      _each([&](int s) { _shards[s]->set_leaf_embedding(trees); });
+    }
+
+    // tree t over all the shards
+    bool get_tree_stats(int tree, tree_stats* stats) {
+      memset(stats, 0, sizeof(tree_stats));
+      double depth_sum = 0;
+      for (size_t i = 0; i < _shards.size(); i++) {
+        tree_stats shard;
+        if (!_shards[i]->get_tree_stats(tree, &shard)) {
+          return false;
+        }
+        stats->nodes += shard.nodes;
+        stats->leaves += shard.leaves;
+        stats->empty_leaves += shard.empty_leaves;
+        stats->items += shard.items;
+        stats->max_depth = std::max(stats->max_depth, shard.max_depth);
+        depth_sum += shard.mean_depth * shard.items;
+      }
+      stats->mean_depth = stats->items > 0 ? depth_sum / stats->items : 0;
+      return true;
+    }
+
+    size_t rebalance(double depth_ratio, double min_fill, size_t max_items) {
+      vector<size_t> rebuilt(_shards.size());
+      _each([&](int s) { rebuilt[s] = _shards[s]->rebalance(depth_ratio, min_fill, max_items); });
+      size_t total = 0;
+      for (size_t i = 0; i < rebuilt.size(); i++) {
+        total += rebuilt[i];
+      }
+      return total;
+    }
+
+    bool rebuild_tree(int tree) {
+      vector<char> ok(_shards.size());
+      _each([&](int s) { ok[s] = _shards[s]->rebuild_tree(tree); });
+      return std::find(ok.begin(), ok.end(), 0) == ok.end();
+    }
+
+    bool compact_trees(int layout) {
+      vector<char> ok(_shards.size());
+      _each([&](int s) { ok[s] = _shards[s]->compact_trees(layout); });
+      return std::find(ok.begin(), ok.end(), 0) == ok.end();
+    }
+
+    bool start_maintenance(int interval_ms, double depth_ratio, double min_fill, size_t max_items) {
+      bool ok = true;
+      for (size_t i = 0; i < _shards.size(); i++) {
+        ok = _shards[i]->start_maintenance(interval_ms, depth_ratio, min_fill, max_items) && ok;
+      }
+      return ok;
+    }
+
+    void stop_maintenance() {
+      for (size_t i = 0; i < _shards.size(); i++) {
+        _shards[i]->stop_maintenance();
+      }
+    }
+
+    void set_leaf_page_size(int page_size) {
+      for (size_t i = 0; i < _shards.size(); i++) {
+        _shards[i]->set_leaf_page_size(page_size);
+      }
+    }
+
+    int get_leaf_capacity() {
+      return _shards[0]->get_leaf_capacity();
+    }
+
+    // shard i draws from seed + i
+    void set_seed(uint64_t seed) {
+      for (size_t i = 0; i < _shards.size(); i++) {
+        _shards[i]->set_seed(seed + i);
+      }
+    }
+
+    // capacity is per shard
+    bool set_write_buffer(size_t capacity, int flush_interval_ms) {
+      bool ok = true;
+      for (size_t i = 0; i < _shards.size(); i++) {
+        ok = _shards[i]->set_write_buffer(capacity, flush_interval_ms) && ok;
+      }
+      return ok;
+    }
+
+    void flush() {
+      _each([&](int s) { _shards[s]->flush(); });
+    }
+
+    void set_group_commit(size_t max_items, int max_delay_ms) {
+      for (size_t i = 0; i < _shards.size(); i++) {
+        _shards[i]->set_group_commit(max_items, max_delay_ms);
+      }
+    }
+
+    void set_durability(int policy) {
+      for (size_t i = 0; i < _shards.size(); i++) {
+        _shards[i]->set_durability(policy);
+      }
+    }
+
+    // sizes and readers summed over the shards
+    void get_map_usage(map_usage* usage) {
+      memset(usage, 0, sizeof(map_usage));
+      for (size_t i = 0; i < _shards.size(); i++) {
+        map_usage shard;
+        _shards[i]->get_map_usage(&shard);
+        usage->map_size += shard.map_size;
+        usage->used_size += shard.used_size;
+        usage->page_size = shard.page_size;
+        usage->readers += shard.readers;
+        usage->max_readers += shard.max_readers;
+      }
+    }
+
+    size_t warm_up(int levels, bool raw, bool lock, int budget_ms) {
+      vector<size_t> pages(_shards.size());
+      _each([&](int s) { pages[s] = _shards[s]->warm_up(levels, raw, lock, budget_ms); });
+      size_t total = 0;
+      for (size_t i = 0; i < pages.size(); i++) {
+        total += pages[i];
+      }
+      return total;
+    }
+
+    // copies shard i to dest_dir/shard.<i>, the reports are summed
+    bool compact(const char* dest_dir, int layout, page_report* before, page_report* after) {
+      memset(before, 0, sizeof(page_report));
+      memset(after, 0, sizeof(page_report));
+      for (size_t i = 0; i < _shards.size(); i++) {
+        string path = _path(dest_dir, i);
+        page_report b, a;
+        mkdir(path.c_str(), 0775);
+        if (!_shards[i]->compact(path.c_str(), layout, &b, &a)) {
+          return false;
+        }
+        page_report* totals[2] = {before, after};
+        page_report* shard[2] = {&b, &a};
+        for (int k = 0; k < 2; k++) {
+          totals[k]->page_size = shard[k]->page_size;
+          totals[k]->used_pages += shard[k]->used_pages;
+          totals[k]->live_pages += shard[k]->live_pages;
+          totals[k]->free_pages += shard[k]->free_pages;
+        }
+      }
+      return true;
+    }
+
+    bool create() {
+      bool ok = true;
+      for (size_t i = 0; i < _shards.size(); i++) {
+        ok = _shards[i]->create() && ok;
+      }
+      return ok;
+    }
+
+    void display_node(S item, int tree) {
+      for (size_t i = 0; i < _shards.size(); i++) {
+        printf("shard %d: ", (int) i);
+        _shards[i]->display_node(item, tree);
+      }
+    }
+
+    void display_raw(S item) {
+      _shards[_shard(item)]->display_raw(item);
+    }
+};
+
+
 #endif
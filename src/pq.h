@@ -0,0 +1,262 @@
+// Copyright (c) 2013 Spotify AB
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#ifndef PQ_H
+#define PQ_H
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include <limits>
+#include <algorithm>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// Product quantizer. The f dimensions are cut into m subspaces of f/m
+// dimensions, and each subspace is coded with the index of one of 2^nbits
+// centroids (nbits is 4 or 8). A query is scored against codes through a
+// per-query table of m * 2^nbits inner products (asymmetric distance
+// computation), so scoring a candidate costs m table lookups.
+//
+// Codes are m bytes for nbits = 8. For nbits = 4 two subspaces share a byte,
+// subspace 2k in the low nibble and 2k+1 in the high one, and batches are
+// scored 32 candidates at a time with byte shuffles over a uint8 table.
+template<typename T>
+struct ProductQuantizer {
+  int f;
+  int m;
+  int nbits;
+  int dsub; // dimensions per subspace
+  int ksub; // centroids per subspace
+  std::vector<T> centroids; // m x ksub x dsub
+
+  ProductQuantizer() : f(0), m(0), nbits(0), dsub(0), ksub(0) {}
+
+  bool init(int dim, int subspaces, int bits) {
+    if (subspaces <= 0 || dim % subspaces != 0 || (bits != 4 && bits != 8))
+      return false;
+    f = dim;
+    m = subspaces;
+    nbits = bits;
+    dsub = f / m;
+    ksub = 1 << nbits;
+    centroids.assign((size_t)m * ksub * dsub, 0);
+    return true;
+  }
+
+  bool trained() const {
+    return m > 0 && centroids.size() == (size_t)m * ksub * dsub;
+  }
+
+  size_t code_size() const {
+    return nbits == 4 ? (m + 1) / 2 : m;
+  }
+
+  inline const T* centroid(int j, int c) const {
+    return &centroids[((size_t)j * ksub + c) * dsub];
+  }
+
+  static inline T l2(const T* x, const T* y, int d) {
+    T s = 0;
+    for (int z = 0; z < d; z++)
+      s += (x[z] - y[z]) * (x[z] - y[z]);
+    return s;
+  }
+
+  // k-means per subspace over n vectors laid out contiguously in data
+  template<class Random>
+  bool train(const T* data, size_t n, int iterations, Random& random) {
+    if (n < (size_t)ksub)
+      return false;
+    std::vector<T> sub(n * dsub);
+    std::vector<int> assign(n);
+    std::vector<int> counts(ksub);
+    for (int j = 0; j < m; j++) {
+      for (size_t i = 0; i < n; i++)
+        memcpy(&sub[i * dsub], data + i * f + j * dsub, dsub * sizeof(T));
+      T* cent = &centroids[(size_t)j * ksub * dsub];
+
+      // seed with distinct random points
+      std::vector<size_t> perm(n);
+      for (size_t i = 0; i < n; i++)
+        perm[i] = i;
+      for (int c = 0; c < ksub; c++) {
+        size_t k = c + random.index(n - c);
+        std::swap(perm[c], perm[k]);
+        memcpy(cent + c * dsub, &sub[perm[c] * dsub], dsub * sizeof(T));
+      }
+
+      for (int it = 0; it < iterations; it++) {
+        for (size_t i = 0; i < n; i++)
+          assign[i] = nearest(cent, &sub[i * dsub]);
+        std::fill(cent, cent + (size_t)ksub * dsub, 0);
+        std::fill(counts.begin(), counts.end(), 0);
+        for (size_t i = 0; i < n; i++) {
+          counts[assign[i]]++;
+          for (int z = 0; z < dsub; z++)
+            cent[assign[i] * dsub + z] += sub[i * dsub + z];
+        }
+        for (int c = 0; c < ksub; c++) {
+          if (counts[c] == 0) {
+            // empty cluster, reseed from a random point
+            memcpy(cent + c * dsub, &sub[random.index(n) * dsub], dsub * sizeof(T));
+            continue;
+          }
+          for (int z = 0; z < dsub; z++)
+            cent[c * dsub + z] /= counts[c];
+        }
+      }
+    }
+    return true;
+  }
+
+  inline int nearest(const T* cent, const T* x) const {
+    int best = 0;
+    T best_d = std::numeric_limits<T>::infinity();
+    for (int c = 0; c < ksub; c++) {
+      T d = l2(cent + c * dsub, x, dsub);
+      if (d < best_d) {
+        best_d = d;
+        best = c;
+      }
+    }
+    return best;
+  }
+
+  void encode(const T* v, uint8_t* code) const {
+    memset(code, 0, code_size());
+    for (int j = 0; j < m; j++) {
+      int c = nearest(&centroids[(size_t)j * ksub * dsub], v + j * dsub);
+      if (nbits == 8)
+        code[j] = (uint8_t)c;
+      else
+        code[j / 2] |= (uint8_t)(c << ((j & 1) * 4));
+    }
+  }
+
+  void decode(const uint8_t* code, T* v) const {
+    for (int j = 0; j < m; j++)
+      memcpy(v + j * dsub, centroid(j, get(code, j)), dsub * sizeof(T));
+  }
+
+  inline int get(const uint8_t* code, int j) const {
+    if (nbits == 8)
+      return code[j];
+    return (code[j / 2] >> ((j & 1) * 4)) & 0xf;
+  }
+
+  // table[j * ksub + c] = <q_j, centroid(j, c)>
+  void compute_table(const T* q, T* table) const {
+    for (int j = 0; j < m; j++)
+      for (int c = 0; c < ksub; c++) {
+        const T* cent = centroid(j, c);
+        T dot = 0;
+        for (int z = 0; z < dsub; z++)
+          dot += q[j * dsub + z] * cent[z];
+        table[j * ksub + c] = dot;
+      }
+  }
+
+  inline T score(const T* table, const uint8_t* code) const {
+    T dot = 0;
+    int j = 0;
+#ifdef __AVX2__
+    if (nbits == 8 && sizeof(T) == sizeof(float)) {
+      // gather 8 subspaces per step
+      const __m256i rows = _mm256_setr_epi32(0, 256, 512, 768, 1024, 1280, 1536, 1792);
+      __m256 acc = _mm256_setzero_ps();
+      for (; j + 8 <= m; j += 8) {
+        __m256i idx = _mm256_add_epi32(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(code + j))), rows);
+        acc = _mm256_add_ps(acc, _mm256_i32gather_ps((const float*)(table + j * 256), idx, 4));
+      }
+      __m128 s = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+      s = _mm_hadd_ps(s, s);
+      s = _mm_hadd_ps(s, s);
+      dot = _mm_cvtss_f32(s);
+    }
+#endif
+    for (; j < m; j++)
+      dot += table[j * ksub + get(code, j)];
+    return dot;
+  }
+
+  // scores n codes stored back to back, out[i] ~= <q, x_i>
+  void score_batch(const T* table, const uint8_t* codes, size_t n, T* out) const {
+    size_t i = 0;
+    if (nbits == 4)
+      i = score_batch4(table, codes, n, out);
+    for (; i < n; i++)
+      out[i] = score(table, codes + i * code_size());
+  }
+
+ protected:
+  size_t score_batch4(const T* table, const uint8_t* codes, size_t n, T* out) const {
+#ifdef __AVX2__
+    // Quantize the table to uint8 with one shared step so the partial sums
+    // of all subspaces add up in uint16 (m * 255 must fit).
+    if (m > 256)
+      return 0;
+    std::vector<uint8_t> lut((size_t)m * 16);
+    T bias = 0, step = 0;
+    for (int j = 0; j < m; j++) {
+      const T* t = table + j * 16;
+      step = std::max(step, *std::max_element(t, t + 16) - *std::min_element(t, t + 16));
+    }
+    step = step > 0 ? step / 255 : 1;
+    for (int j = 0; j < m; j++) {
+      const T* t = table + j * 16;
+      T lo = *std::min_element(t, t + 16);
+      bias += lo;
+      for (int c = 0; c < 16; c++)
+        lut[j * 16 + c] = (uint8_t)std::min<T>(255, (t[c] - lo) / step + (T)0.5);
+    }
+
+    size_t cs = code_size();
+    size_t i = 0;
+    uint8_t column[32] __attribute__((aligned(32)));
+    uint16_t acc16[32] __attribute__((aligned(32)));
+    const __m256i low4 = _mm256_set1_epi8(0x0f);
+    for (; i + 32 <= n; i += 32) {
+      __m256i acc_lo = _mm256_setzero_si256();
+      __m256i acc_hi = _mm256_setzero_si256();
+      for (size_t b = 0; b < cs; b++) {
+        // byte b of 32 consecutive codes, holds subspaces 2b and 2b+1
+        for (int k = 0; k < 32; k++)
+          column[k] = codes[(i + k) * cs + b];
+        __m256i col = _mm256_load_si256((const __m256i*)column);
+        __m256i idx[2] = { _mm256_and_si256(col, low4),
+                           _mm256_and_si256(_mm256_srli_epi16(col, 4), low4) };
+        for (int h = 0; h < 2 && 2 * (int)b + h < m; h++) {
+          __m256i t = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)&lut[(2 * b + h) * 16]));
+          __m256i part = _mm256_shuffle_epi8(t, idx[h]);
+          acc_lo = _mm256_add_epi16(acc_lo, _mm256_cvtepu8_epi16(_mm256_castsi256_si128(part)));
+          acc_hi = _mm256_add_epi16(acc_hi, _mm256_cvtepu8_epi16(_mm256_extracti128_si256(part, 1)));
+        }
+      }
+      _mm256_store_si256((__m256i*)acc16, acc_lo);
+      _mm256_store_si256((__m256i*)(acc16 + 16), acc_hi);
+      for (int k = 0; k < 32; k++)
+        out[i + k] = bias + step * acc16[k];
+    }
+    return i;
+#else
+    return 0;
+#endif
+  }
+};
+
+#endif
+// vim: tabstop=2 shiftwidth=2
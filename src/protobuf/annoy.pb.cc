@@ -1,833 +1,838 @@
 // Generated by the protocol buffer compiler.  DO NOT EDIT!
 // source: protobuf/annoy.proto
 
-#define INTERNAL_SUPPRESS_PROTOBUF_FIELD_DEPRECATION
 #include "protobuf/annoy.pb.h"
 
 #include <algorithm>
 
-#include <google/protobuf/stubs/common.h>
-#include <google/protobuf/stubs/once.h>
 #include <google/protobuf/io/coded_stream.h>
-#include <google/protobuf/wire_format_lite_inl.h>
+#include <google/protobuf/extension_set.h>
+#include <google/protobuf/wire_format_lite.h>
 #include <google/protobuf/descriptor.h>
 #include <google/protobuf/generated_message_reflection.h>
 #include <google/protobuf/reflection_ops.h>
 #include <google/protobuf/wire_format.h>
 // @@protoc_insertion_point(includes)
-
-namespace {
-
-const ::google::protobuf::Descriptor* data_info_descriptor_ = NULL;
-const ::google::protobuf::internal::GeneratedMessageReflection*
-  data_info_reflection_ = NULL;
-const ::google::protobuf::Descriptor* tree_node_descriptor_ = NULL;
-const ::google::protobuf::internal::GeneratedMessageReflection*
-  tree_node_reflection_ = NULL;
-
-}  // namespace
-
-
-void protobuf_AssignDesc_protobuf_2fannoy_2eproto() {
-  protobuf_AddDesc_protobuf_2fannoy_2eproto();
-  const ::google::protobuf::FileDescriptor* file =
-    ::google::protobuf::DescriptorPool::generated_pool()->FindFileByName(
-      "protobuf/annoy.proto");
-  GOOGLE_CHECK(file != NULL);
-  data_info_descriptor_ = file->message_type(0);
-  static const int data_info_offsets_[2] = {
-    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(data_info, data_),
-    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(data_info, id_),
+#include <google/protobuf/port_def.inc>
+
+PROTOBUF_PRAGMA_INIT_SEG
+
+namespace _pb = ::PROTOBUF_NAMESPACE_ID;
+namespace _pbi = _pb::internal;
+
+PROTOBUF_CONSTEXPR data_info::data_info(
+    ::_pbi::ConstantInitialized): _impl_{
+    /*decltype(_impl_._has_bits_)*/{}
+  , /*decltype(_impl_._cached_size_)*/{}
+  , /*decltype(_impl_.data_)*/{}
+  , /*decltype(_impl_.hdata_)*/{&::_pbi::fixed_address_empty_string, ::_pbi::ConstantInitialized{}}
+  , /*decltype(_impl_.id_)*/0u} {}
+struct data_infoDefaultTypeInternal {
+  PROTOBUF_CONSTEXPR data_infoDefaultTypeInternal()
+      : _instance(::_pbi::ConstantInitialized{}) {}
+  ~data_infoDefaultTypeInternal() {}
+  union {
+    data_info _instance;
   };
-  data_info_reflection_ =
-    ::google::protobuf::internal::GeneratedMessageReflection::NewGeneratedMessageReflection(
-      data_info_descriptor_,
-      data_info::default_instance_,
-      data_info_offsets_,
-      GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(data_info, _has_bits_[0]),
-      -1,
-      -1,
-      sizeof(data_info),
-      GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(data_info, _internal_metadata_),
-      -1);
-  tree_node_descriptor_ = file->message_type(1);
-  static const int tree_node_offsets_[6] = {
-    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(tree_node, index_),
-    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(tree_node, leaf_),
-    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(tree_node, left_),
-    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(tree_node, right_),
-    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(tree_node, items_),
-    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(tree_node, v_),
+};
+PROTOBUF_ATTRIBUTE_NO_DESTROY PROTOBUF_CONSTINIT PROTOBUF_ATTRIBUTE_INIT_PRIORITY1 data_infoDefaultTypeInternal _data_info_default_instance_;
+PROTOBUF_CONSTEXPR tree_node::tree_node(
+    ::_pbi::ConstantInitialized): _impl_{
+    /*decltype(_impl_._has_bits_)*/{}
+  , /*decltype(_impl_._cached_size_)*/{}
+  , /*decltype(_impl_.items_)*/{}
+  , /*decltype(_impl_.v_)*/{}
+  , /*decltype(_impl_.hv_)*/{&::_pbi::fixed_address_empty_string, ::_pbi::ConstantInitialized{}}
+  , /*decltype(_impl_.leaf_data_)*/{&::_pbi::fixed_address_empty_string, ::_pbi::ConstantInitialized{}}
+  , /*decltype(_impl_.index_)*/0u
+  , /*decltype(_impl_.leaf_)*/false
+  , /*decltype(_impl_.left_)*/0u
+  , /*decltype(_impl_.right_)*/0u} {}
+struct tree_nodeDefaultTypeInternal {
+  PROTOBUF_CONSTEXPR tree_nodeDefaultTypeInternal()
+      : _instance(::_pbi::ConstantInitialized{}) {}
+  ~tree_nodeDefaultTypeInternal() {}
+  union {
+    tree_node _instance;
   };
-  tree_node_reflection_ =
-    ::google::protobuf::internal::GeneratedMessageReflection::NewGeneratedMessageReflection(
-      tree_node_descriptor_,
-      tree_node::default_instance_,
-      tree_node_offsets_,
-      GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(tree_node, _has_bits_[0]),
-      -1,
-      -1,
-      sizeof(tree_node),
-      GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(tree_node, _internal_metadata_),
-      -1);
-}
-
-namespace {
-
-GOOGLE_PROTOBUF_DECLARE_ONCE(protobuf_AssignDescriptors_once_);
-inline void protobuf_AssignDescriptorsOnce() {
-  ::google::protobuf::GoogleOnceInit(&protobuf_AssignDescriptors_once_,
-                 &protobuf_AssignDesc_protobuf_2fannoy_2eproto);
-}
-
-void protobuf_RegisterTypes(const ::std::string&) {
-  protobuf_AssignDescriptorsOnce();
-  ::google::protobuf::MessageFactory::InternalRegisterGeneratedMessage(
-      data_info_descriptor_, &data_info::default_instance());
-  ::google::protobuf::MessageFactory::InternalRegisterGeneratedMessage(
-      tree_node_descriptor_, &tree_node::default_instance());
-}
-
-}  // namespace
-
-void protobuf_ShutdownFile_protobuf_2fannoy_2eproto() {
-  delete data_info::default_instance_;
-  delete data_info_reflection_;
-  delete tree_node::default_instance_;
-  delete tree_node_reflection_;
-}
-
-void protobuf_AddDesc_protobuf_2fannoy_2eproto() {
-  static bool already_here = false;
-  if (already_here) return;
-  already_here = true;
-  GOOGLE_PROTOBUF_VERIFY_VERSION;
-
-  ::google::protobuf::DescriptorPool::InternalAddGeneratedFile(
-    "\n\024protobuf/annoy.proto\")\n\tdata_info\022\020\n\004d"
-    "ata\030\001 \003(\002B\002\020\001\022\n\n\002id\030\002 \001(\r\"c\n\ttree_node\022\r"
-    "\n\005index\030\001 \002(\r\022\014\n\004leaf\030\002 \002(\010\022\014\n\004left\030\003 \001("
-    "\r\022\r\n\005right\030\004 \001(\r\022\r\n\005items\030\005 \003(\r\022\r\n\001v\030\006 \003"
-    "(\002B\002\020\001", 166);
-  ::google::protobuf::MessageFactory::InternalRegisterGeneratedFile(
-    "protobuf/annoy.proto", &protobuf_RegisterTypes);
-  data_info::default_instance_ = new data_info();
-  tree_node::default_instance_ = new tree_node();
-  data_info::default_instance_->InitAsDefaultInstance();
-  tree_node::default_instance_->InitAsDefaultInstance();
-  ::google::protobuf::internal::OnShutdown(&protobuf_ShutdownFile_protobuf_2fannoy_2eproto);
-}
-
-// Force AddDescriptors() to be called at static initialization time.
-struct StaticDescriptorInitializer_protobuf_2fannoy_2eproto {
-  StaticDescriptorInitializer_protobuf_2fannoy_2eproto() {
-    protobuf_AddDesc_protobuf_2fannoy_2eproto();
-  }
-} static_descriptor_initializer_protobuf_2fannoy_2eproto_;
-
-namespace {
-
-static void MergeFromFail(int line) GOOGLE_ATTRIBUTE_COLD;
-static void MergeFromFail(int line) {
-  GOOGLE_CHECK(false) << __FILE__ << ":" << line;
-}
-
-}  // namespace
-
+};
+PROTOBUF_ATTRIBUTE_NO_DESTROY PROTOBUF_CONSTINIT PROTOBUF_ATTRIBUTE_INIT_PRIORITY1 tree_nodeDefaultTypeInternal _tree_node_default_instance_;
+PROTOBUF_CONSTEXPR index_meta::index_meta(
+    ::_pbi::ConstantInitialized): _impl_{
+    /*decltype(_impl_._has_bits_)*/{}
+  , /*decltype(_impl_._cached_size_)*/{}
+  , /*decltype(_impl_.codec_)*/0u
+  , /*decltype(_impl_.vector_type_)*/0u
+  , /*decltype(_impl_.leaf_embed_trees_)*/0u
+  , /*decltype(_impl_.leaf_page_size_)*/0u
+  , /*decltype(_impl_.leaf_capacity_)*/0u
+  , /*decltype(_impl_.tree_dbs_)*/false
+  , /*decltype(_impl_.seed_)*/uint64_t{0u}} {}
+struct index_metaDefaultTypeInternal {
+  PROTOBUF_CONSTEXPR index_metaDefaultTypeInternal()
+      : _instance(::_pbi::ConstantInitialized{}) {}
+  ~index_metaDefaultTypeInternal() {}
+  union {
+    index_meta _instance;
+  };
+};
+PROTOBUF_ATTRIBUTE_NO_DESTROY PROTOBUF_CONSTINIT PROTOBUF_ATTRIBUTE_INIT_PRIORITY1 index_metaDefaultTypeInternal _index_meta_default_instance_;
+PROTOBUF_CONSTEXPR pq_codebook::pq_codebook(
+    ::_pbi::ConstantInitialized): _impl_{
+    /*decltype(_impl_._has_bits_)*/{}
+  , /*decltype(_impl_._cached_size_)*/{}
+  , /*decltype(_impl_.centroids_)*/{}
+  , /*decltype(_impl_.m_)*/0u
+  , /*decltype(_impl_.nbits_)*/0u} {}
+struct pq_codebookDefaultTypeInternal {
+  PROTOBUF_CONSTEXPR pq_codebookDefaultTypeInternal()
+      : _instance(::_pbi::ConstantInitialized{}) {}
+  ~pq_codebookDefaultTypeInternal() {}
+  union {
+    pq_codebook _instance;
+  };
+};
+PROTOBUF_ATTRIBUTE_NO_DESTROY PROTOBUF_CONSTINIT PROTOBUF_ATTRIBUTE_INIT_PRIORITY1 pq_codebookDefaultTypeInternal _pq_codebook_default_instance_;
+static ::_pb::Metadata file_level_metadata_protobuf_2fannoy_2eproto[4];
+static constexpr ::_pb::EnumDescriptor const** file_level_enum_descriptors_protobuf_2fannoy_2eproto = nullptr;
+static constexpr ::_pb::ServiceDescriptor const** file_level_service_descriptors_protobuf_2fannoy_2eproto = nullptr;
+
+const uint32_t TableStruct_protobuf_2fannoy_2eproto::offsets[] PROTOBUF_SECTION_VARIABLE(protodesc_cold) = {
+  PROTOBUF_FIELD_OFFSET(::data_info, _impl_._has_bits_),
+  PROTOBUF_FIELD_OFFSET(::data_info, _internal_metadata_),
+  ~0u,  // no _extensions_
+  ~0u,  // no _oneof_case_
+  ~0u,  // no _weak_field_map_
+  ~0u,  // no _inlined_string_donated_
+  PROTOBUF_FIELD_OFFSET(::data_info, _impl_.data_),
+  PROTOBUF_FIELD_OFFSET(::data_info, _impl_.id_),
+  PROTOBUF_FIELD_OFFSET(::data_info, _impl_.hdata_),
+  ~0u,
+  1,
+  0,
+  PROTOBUF_FIELD_OFFSET(::tree_node, _impl_._has_bits_),
+  PROTOBUF_FIELD_OFFSET(::tree_node, _internal_metadata_),
+  ~0u,  // no _extensions_
+  ~0u,  // no _oneof_case_
+  ~0u,  // no _weak_field_map_
+  ~0u,  // no _inlined_string_donated_
+  PROTOBUF_FIELD_OFFSET(::tree_node, _impl_.index_),
+  PROTOBUF_FIELD_OFFSET(::tree_node, _impl_.leaf_),
+  PROTOBUF_FIELD_OFFSET(::tree_node, _impl_.left_),
+  PROTOBUF_FIELD_OFFSET(::tree_node, _impl_.right_),
+  PROTOBUF_FIELD_OFFSET(::tree_node, _impl_.items_),
+  PROTOBUF_FIELD_OFFSET(::tree_node, _impl_.v_),
+  PROTOBUF_FIELD_OFFSET(::tree_node, _impl_.hv_),
+  PROTOBUF_FIELD_OFFSET(::tree_node, _impl_.leaf_data_),
+  2,
+  3,
+  4,
+  5,
+  ~0u,
+  ~0u,
+  0,
+  1,
+  PROTOBUF_FIELD_OFFSET(::index_meta, _impl_._has_bits_),
+  PROTOBUF_FIELD_OFFSET(::index_meta, _internal_metadata_),
+  ~0u,  // no _extensions_
+  ~0u,  // no _oneof_case_
+  ~0u,  // no _weak_field_map_
+  ~0u,  // no _inlined_string_donated_
+  PROTOBUF_FIELD_OFFSET(::index_meta, _impl_.codec_),
+  PROTOBUF_FIELD_OFFSET(::index_meta, _impl_.vector_type_),
+  PROTOBUF_FIELD_OFFSET(::index_meta, _impl_.leaf_embed_trees_),
+  PROTOBUF_FIELD_OFFSET(::index_meta, _impl_.leaf_page_size_),
+  PROTOBUF_FIELD_OFFSET(::index_meta, _impl_.leaf_capacity_),
+  PROTOBUF_FIELD_OFFSET(::index_meta, _impl_.tree_dbs_),
+  PROTOBUF_FIELD_OFFSET(::index_meta, _impl_.seed_),
+  0,
+  1,
+  2,
+  3,
+  4,
+  5,
+  6,
+  PROTOBUF_FIELD_OFFSET(::pq_codebook, _impl_._has_bits_),
+  PROTOBUF_FIELD_OFFSET(::pq_codebook, _internal_metadata_),
+  ~0u,  // no _extensions_
+  ~0u,  // no _oneof_case_
+  ~0u,  // no _weak_field_map_
+  ~0u,  // no _inlined_string_donated_
+  PROTOBUF_FIELD_OFFSET(::pq_codebook, _impl_.m_),
+  PROTOBUF_FIELD_OFFSET(::pq_codebook, _impl_.nbits_),
+  PROTOBUF_FIELD_OFFSET(::pq_codebook, _impl_.centroids_),
+  0,
+  1,
+  ~0u,
+};
+static const ::_pbi::MigrationSchema schemas[] PROTOBUF_SECTION_VARIABLE(protodesc_cold) = {
+  { 0, 9, -1, sizeof(::data_info)},
+  { 12, 26, -1, sizeof(::tree_node)},
+  { 34, 47, -1, sizeof(::index_meta)},
+  { 54, 63, -1, sizeof(::pq_codebook)},
+};
+
+static const ::_pb::Message* const file_default_instances[] = {
+  &::_data_info_default_instance_._instance,
+  &::_tree_node_default_instance_._instance,
+  &::_index_meta_default_instance_._instance,
+  &::_pq_codebook_default_instance_._instance,
+};
+
+const char descriptor_table_protodef_protobuf_2fannoy_2eproto[] PROTOBUF_SECTION_VARIABLE(protodesc_cold) =
+  "\n\024protobuf/annoy.proto\"8\n\tdata_info\022\020\n\004d"
+  "ata\030\001 \003(\002B\002\020\001\022\n\n\002id\030\002 \001(\r\022\r\n\005hdata\030\003 \001(\014"
+  "\"\202\001\n\ttree_node\022\r\n\005index\030\001 \002(\r\022\014\n\004leaf\030\002 "
+  "\002(\010\022\014\n\004left\030\003 \001(\r\022\r\n\005right\030\004 \001(\r\022\r\n\005item"
+  "s\030\005 \003(\r\022\r\n\001v\030\006 \003(\002B\002\020\001\022\n\n\002hv\030\007 \001(\014\022\021\n\tle"
+  "af_data\030\010 \001(\014\"\231\001\n\nindex_meta\022\r\n\005codec\030\001 "
+  "\001(\r\022\023\n\013vector_type\030\002 \001(\r\022\030\n\020leaf_embed_t"
+  "rees\030\003 \001(\r\022\026\n\016leaf_page_size\030\004 \001(\r\022\025\n\rle"
+  "af_capacity\030\005 \001(\r\022\020\n\010tree_dbs\030\006 \001(\010\022\014\n\004s"
+  "eed\030\007 \001(\004\">\n\013pq_codebook\022\t\n\001m\030\001 \001(\r\022\r\n\005n"
+  "bits\030\002 \001(\r\022\025\n\tcentroids\030\003 \003(\002B\002\020\001"
+  ;
+static ::_pbi::once_flag descriptor_table_protobuf_2fannoy_2eproto_once;
+const ::_pbi::DescriptorTable descriptor_table_protobuf_2fannoy_2eproto = {
+    false, false, 433, descriptor_table_protodef_protobuf_2fannoy_2eproto,
+    "protobuf/annoy.proto",
+    &descriptor_table_protobuf_2fannoy_2eproto_once, nullptr, 0, 4,
+    schemas, file_default_instances, TableStruct_protobuf_2fannoy_2eproto::offsets,
+    file_level_metadata_protobuf_2fannoy_2eproto, file_level_enum_descriptors_protobuf_2fannoy_2eproto,
+    file_level_service_descriptors_protobuf_2fannoy_2eproto,
+};
+PROTOBUF_ATTRIBUTE_WEAK const ::_pbi::DescriptorTable* descriptor_table_protobuf_2fannoy_2eproto_getter() {
+  return &descriptor_table_protobuf_2fannoy_2eproto;
+}
+
+// Force running AddDescriptors() at dynamic initialization time.
+PROTOBUF_ATTRIBUTE_INIT_PRIORITY2 static ::_pbi::AddDescriptorsRunner dynamic_init_dummy_protobuf_2fannoy_2eproto(&descriptor_table_protobuf_2fannoy_2eproto);
 
 // ===================================================================
 
-#if !defined(_MSC_VER) || _MSC_VER >= 1900
-const int data_info::kDataFieldNumber;
-const int data_info::kIdFieldNumber;
-#endif  // !defined(_MSC_VER) || _MSC_VER >= 1900
-
-data_info::data_info()
-  : ::google::protobuf::Message(), _internal_metadata_(NULL) {
-  SharedCtor();
-  // @@protoc_insertion_point(constructor:data_info)
-}
+class data_info::_Internal {
+ public:
+  using HasBits = decltype(std::declval<data_info>()._impl_._has_bits_);
+  static void set_has_id(HasBits* has_bits) {
+    (*has_bits)[0] |= 2u;
+  }
+  static void set_has_hdata(HasBits* has_bits) {
+    (*has_bits)[0] |= 1u;
+  }
+};
 
-void data_info::InitAsDefaultInstance() {
+data_info::data_info(::PROTOBUF_NAMESPACE_ID::Arena* arena,
+                         bool is_message_owned)
+  : ::PROTOBUF_NAMESPACE_ID::Message(arena, is_message_owned) {
+  SharedCtor(arena, is_message_owned);
+  // @@protoc_insertion_point(arena_constructor:data_info)
 }
-
 data_info::data_info(const data_info& from)
-  : ::google::protobuf::Message(),
-    _internal_metadata_(NULL) {
-  SharedCtor();
-  MergeFrom(from);
+  : ::PROTOBUF_NAMESPACE_ID::Message() {
+  data_info* const _this = this; (void)_this;
+  new (&_impl_) Impl_{
+      decltype(_impl_._has_bits_){from._impl_._has_bits_}
+    , /*decltype(_impl_._cached_size_)*/{}
+    , decltype(_impl_.data_){from._impl_.data_}
+    , decltype(_impl_.hdata_){}
+    , decltype(_impl_.id_){}};
+
+  _internal_metadata_.MergeFrom<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(from._internal_metadata_);
+  _impl_.hdata_.InitDefault();
+  #ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+    _impl_.hdata_.Set("", GetArenaForAllocation());
+  #endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  if (from._internal_has_hdata()) {
+    _this->_impl_.hdata_.Set(from._internal_hdata(), 
+      _this->GetArenaForAllocation());
+  }
+  _this->_impl_.id_ = from._impl_.id_;
   // @@protoc_insertion_point(copy_constructor:data_info)
 }
 
-void data_info::SharedCtor() {
-  _cached_size_ = 0;
-  id_ = 0u;
-  ::memset(_has_bits_, 0, sizeof(_has_bits_));
+inline void data_info::SharedCtor(
+    ::_pb::Arena* arena, bool is_message_owned) {
+  (void)arena;
+  (void)is_message_owned;
+  new (&_impl_) Impl_{
+      decltype(_impl_._has_bits_){}
+    , /*decltype(_impl_._cached_size_)*/{}
+    , decltype(_impl_.data_){arena}
+    , decltype(_impl_.hdata_){}
+    , decltype(_impl_.id_){0u}
+  };
+  _impl_.hdata_.InitDefault();
+  #ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+    _impl_.hdata_.Set("", GetArenaForAllocation());
+  #endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
 }
 
 data_info::~data_info() {
   // @@protoc_insertion_point(destructor:data_info)
+  if (auto *arena = _internal_metadata_.DeleteReturnArena<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>()) {
+  (void)arena;
+    return;
+  }
   SharedDtor();
 }
 
-void data_info::SharedDtor() {
-  if (this != default_instance_) {
-  }
+inline void data_info::SharedDtor() {
+  GOOGLE_DCHECK(GetArenaForAllocation() == nullptr);
+  _impl_.data_.~RepeatedField();
+  _impl_.hdata_.Destroy();
 }
 
 void data_info::SetCachedSize(int size) const {
-  GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
-  _cached_size_ = size;
-  GOOGLE_SAFE_CONCURRENT_WRITES_END();
-}
-const ::google::protobuf::Descriptor* data_info::descriptor() {
-  protobuf_AssignDescriptorsOnce();
-  return data_info_descriptor_;
-}
-
-const data_info& data_info::default_instance() {
-  if (default_instance_ == NULL) protobuf_AddDesc_protobuf_2fannoy_2eproto();
-  return *default_instance_;
-}
-
-data_info* data_info::default_instance_ = NULL;
-
-data_info* data_info::New(::google::protobuf::Arena* arena) const {
-  data_info* n = new data_info;
-  if (arena != NULL) {
-    arena->Own(n);
-  }
-  return n;
+  _impl_._cached_size_.Set(size);
 }
 
 void data_info::Clear() {
-  id_ = 0u;
-  data_.Clear();
-  ::memset(_has_bits_, 0, sizeof(_has_bits_));
-  if (_internal_metadata_.have_unknown_fields()) {
-    mutable_unknown_fields()->Clear();
-  }
-}
-
-bool data_info::MergePartialFromCodedStream(
-    ::google::protobuf::io::CodedInputStream* input) {
-#define DO_(EXPRESSION) if (!(EXPRESSION)) goto failure
-  ::google::protobuf::uint32 tag;
-  // @@protoc_insertion_point(parse_start:data_info)
-  for (;;) {
-    ::std::pair< ::google::protobuf::uint32, bool> p = input->ReadTagWithCutoff(127);
-    tag = p.first;
-    if (!p.second) goto handle_unusual;
-    switch (::google::protobuf::internal::WireFormatLite::GetTagFieldNumber(tag)) {
+// @@protoc_insertion_point(message_clear_start:data_info)
+  uint32_t cached_has_bits = 0;
+  // Prevent compiler warnings about cached_has_bits being unused
+  (void) cached_has_bits;
+
+  _impl_.data_.Clear();
+  cached_has_bits = _impl_._has_bits_[0];
+  if (cached_has_bits & 0x00000001u) {
+    _impl_.hdata_.ClearNonDefaultToEmpty();
+  }
+  _impl_.id_ = 0u;
+  _impl_._has_bits_.Clear();
+  _internal_metadata_.Clear<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>();
+}
+
+const char* data_info::_InternalParse(const char* ptr, ::_pbi::ParseContext* ctx) {
+#define CHK_(x) if (PROTOBUF_PREDICT_FALSE(!(x))) goto failure
+  _Internal::HasBits has_bits{};
+  while (!ctx->Done(&ptr)) {
+    uint32_t tag;
+    ptr = ::_pbi::ReadTag(ptr, &tag);
+    switch (tag >> 3) {
       // repeated float data = 1 [packed = true];
-      case 1: {
-        if (tag == 10) {
-          DO_((::google::protobuf::internal::WireFormatLite::ReadPackedPrimitive<
-                   float, ::google::protobuf::internal::WireFormatLite::TYPE_FLOAT>(
-                 input, this->mutable_data())));
-        } else if (tag == 13) {
-          DO_((::google::protobuf::internal::WireFormatLite::ReadRepeatedPrimitiveNoInline<
-                   float, ::google::protobuf::internal::WireFormatLite::TYPE_FLOAT>(
-                 1, 10, input, this->mutable_data())));
-        } else {
+      case 1:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 10)) {
+          ptr = ::PROTOBUF_NAMESPACE_ID::internal::PackedFloatParser(_internal_mutable_data(), ptr, ctx);
+          CHK_(ptr);
+        } else if (static_cast<uint8_t>(tag) == 13) {
+          _internal_add_data(::PROTOBUF_NAMESPACE_ID::internal::UnalignedLoad<float>(ptr));
+          ptr += sizeof(float);
+        } else
           goto handle_unusual;
-        }
-        if (input->ExpectTag(16)) goto parse_id;
-        break;
-      }
-
+        continue;
       // optional uint32 id = 2;
-      case 2: {
-        if (tag == 16) {
-         parse_id:
-          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
-                   ::google::protobuf::uint32, ::google::protobuf::internal::WireFormatLite::TYPE_UINT32>(
-                 input, &id_)));
-          set_has_id();
-        } else {
+      case 2:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 16)) {
+          _Internal::set_has_id(&has_bits);
+          _impl_.id_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      // optional bytes hdata = 3;
+      case 3:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 26)) {
+          auto str = _internal_mutable_hdata();
+          ptr = ::_pbi::InlineGreedyStringParser(str, ptr, ctx);
+          CHK_(ptr);
+        } else
           goto handle_unusual;
-        }
-        if (input->ExpectAtEnd()) goto success;
-        break;
-      }
-
-      default: {
-      handle_unusual:
-        if (tag == 0 ||
-            ::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
-            ::google::protobuf::internal::WireFormatLite::WIRETYPE_END_GROUP) {
-          goto success;
-        }
-        DO_(::google::protobuf::internal::WireFormat::SkipField(
-              input, tag, mutable_unknown_fields()));
-        break;
-      }
+        continue;
+      default:
+        goto handle_unusual;
+    }  // switch
+  handle_unusual:
+    if ((tag == 0) || ((tag & 7) == 4)) {
+      CHK_(ptr);
+      ctx->SetLastTag(tag);
+      goto message_done;
     }
-  }
-success:
-  // @@protoc_insertion_point(parse_success:data_info)
-  return true;
+    ptr = UnknownFieldParse(
+        tag,
+        _internal_metadata_.mutable_unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(),
+        ptr, ctx);
+    CHK_(ptr != nullptr);
+  }  // while
+message_done:
+  _impl_._has_bits_.Or(has_bits);
+  return ptr;
 failure:
-  // @@protoc_insertion_point(parse_failure:data_info)
-  return false;
-#undef DO_
+  ptr = nullptr;
+  goto message_done;
+#undef CHK_
 }
 
-void data_info::SerializeWithCachedSizes(
-    ::google::protobuf::io::CodedOutputStream* output) const {
-  // @@protoc_insertion_point(serialize_start:data_info)
+uint8_t* data_info::_InternalSerialize(
+    uint8_t* target, ::PROTOBUF_NAMESPACE_ID::io::EpsCopyOutputStream* stream) const {
+  // @@protoc_insertion_point(serialize_to_array_start:data_info)
+  uint32_t cached_has_bits = 0;
+  (void) cached_has_bits;
+
   // repeated float data = 1 [packed = true];
-  if (this->data_size() > 0) {
-    ::google::protobuf::internal::WireFormatLite::WriteTag(1, ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED, output);
-    output->WriteVarint32(_data_cached_byte_size_);
-  }
-  for (int i = 0; i < this->data_size(); i++) {
-    ::google::protobuf::internal::WireFormatLite::WriteFloatNoTag(
-      this->data(i), output);
+  if (this->_internal_data_size() > 0) {
+    target = stream->WriteFixedPacked(1, _internal_data(), target);
   }
 
+  cached_has_bits = _impl_._has_bits_[0];
   // optional uint32 id = 2;
-  if (has_id()) {
-    ::google::protobuf::internal::WireFormatLite::WriteUInt32(2, this->id(), output);
-  }
-
-  if (_internal_metadata_.have_unknown_fields()) {
-    ::google::protobuf::internal::WireFormat::SerializeUnknownFields(
-        unknown_fields(), output);
-  }
-  // @@protoc_insertion_point(serialize_end:data_info)
-}
-
-::google::protobuf::uint8* data_info::SerializeWithCachedSizesToArray(
-    ::google::protobuf::uint8* target) const {
-  // @@protoc_insertion_point(serialize_to_array_start:data_info)
-  // repeated float data = 1 [packed = true];
-  if (this->data_size() > 0) {
-    target = ::google::protobuf::internal::WireFormatLite::WriteTagToArray(
-      1,
-      ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED,
-      target);
-    target = ::google::protobuf::io::CodedOutputStream::WriteVarint32ToArray(
-      _data_cached_byte_size_, target);
-  }
-  for (int i = 0; i < this->data_size(); i++) {
-    target = ::google::protobuf::internal::WireFormatLite::
-      WriteFloatNoTagToArray(this->data(i), target);
+  if (cached_has_bits & 0x00000002u) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteUInt32ToArray(2, this->_internal_id(), target);
   }
 
-  // optional uint32 id = 2;
-  if (has_id()) {
-    target = ::google::protobuf::internal::WireFormatLite::WriteUInt32ToArray(2, this->id(), target);
+  // optional bytes hdata = 3;
+  if (cached_has_bits & 0x00000001u) {
+    target = stream->WriteBytesMaybeAliased(
+        3, this->_internal_hdata(), target);
   }
 
-  if (_internal_metadata_.have_unknown_fields()) {
-    target = ::google::protobuf::internal::WireFormat::SerializeUnknownFieldsToArray(
-        unknown_fields(), target);
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    target = ::_pbi::WireFormat::InternalSerializeUnknownFieldsToArray(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), target, stream);
   }
   // @@protoc_insertion_point(serialize_to_array_end:data_info)
   return target;
 }
 
-int data_info::ByteSize() const {
-  int total_size = 0;
+size_t data_info::ByteSizeLong() const {
+// @@protoc_insertion_point(message_byte_size_start:data_info)
+  size_t total_size = 0;
 
-  // optional uint32 id = 2;
-  if (has_id()) {
-    total_size += 1 +
-      ::google::protobuf::internal::WireFormatLite::UInt32Size(
-        this->id());
-  }
+  uint32_t cached_has_bits = 0;
+  // Prevent compiler warnings about cached_has_bits being unused
+  (void) cached_has_bits;
 
   // repeated float data = 1 [packed = true];
   {
-    int data_size = 0;
-    data_size = 4 * this->data_size();
+    unsigned int count = static_cast<unsigned int>(this->_internal_data_size());
+    size_t data_size = 4UL * count;
     if (data_size > 0) {
       total_size += 1 +
-        ::google::protobuf::internal::WireFormatLite::Int32Size(data_size);
+        ::_pbi::WireFormatLite::Int32Size(static_cast<int32_t>(data_size));
     }
-    GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
-    _data_cached_byte_size_ = data_size;
-    GOOGLE_SAFE_CONCURRENT_WRITES_END();
     total_size += data_size;
   }
 
-  if (_internal_metadata_.have_unknown_fields()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormat::ComputeUnknownFieldsSize(
-        unknown_fields());
-  }
-  GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
-  _cached_size_ = total_size;
-  GOOGLE_SAFE_CONCURRENT_WRITES_END();
-  return total_size;
-}
+  cached_has_bits = _impl_._has_bits_[0];
+  if (cached_has_bits & 0x00000003u) {
+    // optional bytes hdata = 3;
+    if (cached_has_bits & 0x00000001u) {
+      total_size += 1 +
+        ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::BytesSize(
+          this->_internal_hdata());
+    }
+
+    // optional uint32 id = 2;
+    if (cached_has_bits & 0x00000002u) {
+      total_size += ::_pbi::WireFormatLite::UInt32SizePlusOne(this->_internal_id());
+    }
 
-void data_info::MergeFrom(const ::google::protobuf::Message& from) {
-  if (GOOGLE_PREDICT_FALSE(&from == this)) MergeFromFail(__LINE__);
-  const data_info* source = 
-      ::google::protobuf::internal::DynamicCastToGenerated<const data_info>(
-          &from);
-  if (source == NULL) {
-    ::google::protobuf::internal::ReflectionOps::Merge(from, this);
-  } else {
-    MergeFrom(*source);
   }
+  return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
-void data_info::MergeFrom(const data_info& from) {
-  if (GOOGLE_PREDICT_FALSE(&from == this)) MergeFromFail(__LINE__);
-  data_.MergeFrom(from.data_);
-  if (from._has_bits_[1 / 32] & (0xffu << (1 % 32))) {
-    if (from.has_id()) {
-      set_id(from.id());
+const ::PROTOBUF_NAMESPACE_ID::Message::ClassData data_info::_class_data_ = {
+    ::PROTOBUF_NAMESPACE_ID::Message::CopyWithSourceCheck,
+    data_info::MergeImpl
+};
+const ::PROTOBUF_NAMESPACE_ID::Message::ClassData*data_info::GetClassData() const { return &_class_data_; }
+
+
+void data_info::MergeImpl(::PROTOBUF_NAMESPACE_ID::Message& to_msg, const ::PROTOBUF_NAMESPACE_ID::Message& from_msg) {
+  auto* const _this = static_cast<data_info*>(&to_msg);
+  auto& from = static_cast<const data_info&>(from_msg);
+  // @@protoc_insertion_point(class_specific_merge_from_start:data_info)
+  GOOGLE_DCHECK_NE(&from, _this);
+  uint32_t cached_has_bits = 0;
+  (void) cached_has_bits;
+
+  _this->_impl_.data_.MergeFrom(from._impl_.data_);
+  cached_has_bits = from._impl_._has_bits_[0];
+  if (cached_has_bits & 0x00000003u) {
+    if (cached_has_bits & 0x00000001u) {
+      _this->_internal_set_hdata(from._internal_hdata());
     }
+    if (cached_has_bits & 0x00000002u) {
+      _this->_impl_.id_ = from._impl_.id_;
+    }
+    _this->_impl_._has_bits_[0] |= cached_has_bits;
   }
-  if (from._internal_metadata_.have_unknown_fields()) {
-    mutable_unknown_fields()->MergeFrom(from.unknown_fields());
-  }
-}
-
-void data_info::CopyFrom(const ::google::protobuf::Message& from) {
-  if (&from == this) return;
-  Clear();
-  MergeFrom(from);
+  _this->_internal_metadata_.MergeFrom<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(from._internal_metadata_);
 }
 
 void data_info::CopyFrom(const data_info& from) {
+// @@protoc_insertion_point(class_specific_copy_from_start:data_info)
   if (&from == this) return;
   Clear();
   MergeFrom(from);
 }
 
 bool data_info::IsInitialized() const {
-
   return true;
 }
 
-void data_info::Swap(data_info* other) {
-  if (other == this) return;
-  InternalSwap(other);
-}
 void data_info::InternalSwap(data_info* other) {
-  data_.UnsafeArenaSwap(&other->data_);
-  std::swap(id_, other->id_);
-  std::swap(_has_bits_[0], other->_has_bits_[0]);
-  _internal_metadata_.Swap(&other->_internal_metadata_);
-  std::swap(_cached_size_, other->_cached_size_);
-}
-
-::google::protobuf::Metadata data_info::GetMetadata() const {
-  protobuf_AssignDescriptorsOnce();
-  ::google::protobuf::Metadata metadata;
-  metadata.descriptor = data_info_descriptor_;
-  metadata.reflection = data_info_reflection_;
-  return metadata;
-}
-
-#if PROTOBUF_INLINE_NOT_IN_HEADERS
-// data_info
-
-// repeated float data = 1 [packed = true];
-int data_info::data_size() const {
-  return data_.size();
-}
-void data_info::clear_data() {
-  data_.Clear();
-}
- float data_info::data(int index) const {
-  // @@protoc_insertion_point(field_get:data_info.data)
-  return data_.Get(index);
-}
- void data_info::set_data(int index, float value) {
-  data_.Set(index, value);
-  // @@protoc_insertion_point(field_set:data_info.data)
-}
- void data_info::add_data(float value) {
-  data_.Add(value);
-  // @@protoc_insertion_point(field_add:data_info.data)
-}
- const ::google::protobuf::RepeatedField< float >&
-data_info::data() const {
-  // @@protoc_insertion_point(field_list:data_info.data)
-  return data_;
-}
- ::google::protobuf::RepeatedField< float >*
-data_info::mutable_data() {
-  // @@protoc_insertion_point(field_mutable_list:data_info.data)
-  return &data_;
+  using std::swap;
+  auto* lhs_arena = GetArenaForAllocation();
+  auto* rhs_arena = other->GetArenaForAllocation();
+  _internal_metadata_.InternalSwap(&other->_internal_metadata_);
+  swap(_impl_._has_bits_[0], other->_impl_._has_bits_[0]);
+  _impl_.data_.InternalSwap(&other->_impl_.data_);
+  ::PROTOBUF_NAMESPACE_ID::internal::ArenaStringPtr::InternalSwap(
+      &_impl_.hdata_, lhs_arena,
+      &other->_impl_.hdata_, rhs_arena
+  );
+  swap(_impl_.id_, other->_impl_.id_);
 }
 
-// optional uint32 id = 2;
-bool data_info::has_id() const {
-  return (_has_bits_[0] & 0x00000002u) != 0;
-}
-void data_info::set_has_id() {
-  _has_bits_[0] |= 0x00000002u;
-}
-void data_info::clear_has_id() {
-  _has_bits_[0] &= ~0x00000002u;
-}
-void data_info::clear_id() {
-  id_ = 0u;
-  clear_has_id();
-}
- ::google::protobuf::uint32 data_info::id() const {
-  // @@protoc_insertion_point(field_get:data_info.id)
-  return id_;
-}
- void data_info::set_id(::google::protobuf::uint32 value) {
-  set_has_id();
-  id_ = value;
-  // @@protoc_insertion_point(field_set:data_info.id)
+::PROTOBUF_NAMESPACE_ID::Metadata data_info::GetMetadata() const {
+  return ::_pbi::AssignDescriptors(
+      &descriptor_table_protobuf_2fannoy_2eproto_getter, &descriptor_table_protobuf_2fannoy_2eproto_once,
+      file_level_metadata_protobuf_2fannoy_2eproto[0]);
 }
 
-#endif  // PROTOBUF_INLINE_NOT_IN_HEADERS
-
 // ===================================================================
 
-#if !defined(_MSC_VER) || _MSC_VER >= 1900
-const int tree_node::kIndexFieldNumber;
-const int tree_node::kLeafFieldNumber;
-const int tree_node::kLeftFieldNumber;
-const int tree_node::kRightFieldNumber;
-const int tree_node::kItemsFieldNumber;
-const int tree_node::kVFieldNumber;
-#endif  // !defined(_MSC_VER) || _MSC_VER >= 1900
-
-tree_node::tree_node()
-  : ::google::protobuf::Message(), _internal_metadata_(NULL) {
-  SharedCtor();
-  // @@protoc_insertion_point(constructor:tree_node)
-}
+class tree_node::_Internal {
+ public:
+  using HasBits = decltype(std::declval<tree_node>()._impl_._has_bits_);
+  static void set_has_index(HasBits* has_bits) {
+    (*has_bits)[0] |= 4u;
+  }
+  static void set_has_leaf(HasBits* has_bits) {
+    (*has_bits)[0] |= 8u;
+  }
+  static void set_has_left(HasBits* has_bits) {
+    (*has_bits)[0] |= 16u;
+  }
+  static void set_has_right(HasBits* has_bits) {
+    (*has_bits)[0] |= 32u;
+  }
+  static void set_has_hv(HasBits* has_bits) {
+    (*has_bits)[0] |= 1u;
+  }
+  static void set_has_leaf_data(HasBits* has_bits) {
+    (*has_bits)[0] |= 2u;
+  }
+  static bool MissingRequiredFields(const HasBits& has_bits) {
+    return ((has_bits[0] & 0x0000000c) ^ 0x0000000c) != 0;
+  }
+};
 
-void tree_node::InitAsDefaultInstance() {
+tree_node::tree_node(::PROTOBUF_NAMESPACE_ID::Arena* arena,
+                         bool is_message_owned)
+  : ::PROTOBUF_NAMESPACE_ID::Message(arena, is_message_owned) {
+  SharedCtor(arena, is_message_owned);
+  // @@protoc_insertion_point(arena_constructor:tree_node)
 }
-
 tree_node::tree_node(const tree_node& from)
-  : ::google::protobuf::Message(),
-    _internal_metadata_(NULL) {
-  SharedCtor();
-  MergeFrom(from);
+  : ::PROTOBUF_NAMESPACE_ID::Message() {
+  tree_node* const _this = this; (void)_this;
+  new (&_impl_) Impl_{
+      decltype(_impl_._has_bits_){from._impl_._has_bits_}
+    , /*decltype(_impl_._cached_size_)*/{}
+    , decltype(_impl_.items_){from._impl_.items_}
+    , decltype(_impl_.v_){from._impl_.v_}
+    , decltype(_impl_.hv_){}
+    , decltype(_impl_.leaf_data_){}
+    , decltype(_impl_.index_){}
+    , decltype(_impl_.leaf_){}
+    , decltype(_impl_.left_){}
+    , decltype(_impl_.right_){}};
+
+  _internal_metadata_.MergeFrom<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(from._internal_metadata_);
+  _impl_.hv_.InitDefault();
+  #ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+    _impl_.hv_.Set("", GetArenaForAllocation());
+  #endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  if (from._internal_has_hv()) {
+    _this->_impl_.hv_.Set(from._internal_hv(), 
+      _this->GetArenaForAllocation());
+  }
+  _impl_.leaf_data_.InitDefault();
+  #ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+    _impl_.leaf_data_.Set("", GetArenaForAllocation());
+  #endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  if (from._internal_has_leaf_data()) {
+    _this->_impl_.leaf_data_.Set(from._internal_leaf_data(), 
+      _this->GetArenaForAllocation());
+  }
+  ::memcpy(&_impl_.index_, &from._impl_.index_,
+    static_cast<size_t>(reinterpret_cast<char*>(&_impl_.right_) -
+    reinterpret_cast<char*>(&_impl_.index_)) + sizeof(_impl_.right_));
   // @@protoc_insertion_point(copy_constructor:tree_node)
 }
 
-void tree_node::SharedCtor() {
-  _cached_size_ = 0;
-  index_ = 0u;
-  leaf_ = false;
-  left_ = 0u;
-  right_ = 0u;
-  ::memset(_has_bits_, 0, sizeof(_has_bits_));
+inline void tree_node::SharedCtor(
+    ::_pb::Arena* arena, bool is_message_owned) {
+  (void)arena;
+  (void)is_message_owned;
+  new (&_impl_) Impl_{
+      decltype(_impl_._has_bits_){}
+    , /*decltype(_impl_._cached_size_)*/{}
+    , decltype(_impl_.items_){arena}
+    , decltype(_impl_.v_){arena}
+    , decltype(_impl_.hv_){}
+    , decltype(_impl_.leaf_data_){}
+    , decltype(_impl_.index_){0u}
+    , decltype(_impl_.leaf_){false}
+    , decltype(_impl_.left_){0u}
+    , decltype(_impl_.right_){0u}
+  };
+  _impl_.hv_.InitDefault();
+  #ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+    _impl_.hv_.Set("", GetArenaForAllocation());
+  #endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  _impl_.leaf_data_.InitDefault();
+  #ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+    _impl_.leaf_data_.Set("", GetArenaForAllocation());
+  #endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
 }
 
 tree_node::~tree_node() {
   // @@protoc_insertion_point(destructor:tree_node)
+  if (auto *arena = _internal_metadata_.DeleteReturnArena<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>()) {
+  (void)arena;
+    return;
+  }
   SharedDtor();
 }
 
-void tree_node::SharedDtor() {
-  if (this != default_instance_) {
-  }
+inline void tree_node::SharedDtor() {
+  GOOGLE_DCHECK(GetArenaForAllocation() == nullptr);
+  _impl_.items_.~RepeatedField();
+  _impl_.v_.~RepeatedField();
+  _impl_.hv_.Destroy();
+  _impl_.leaf_data_.Destroy();
 }
 
 void tree_node::SetCachedSize(int size) const {
-  GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
-  _cached_size_ = size;
-  GOOGLE_SAFE_CONCURRENT_WRITES_END();
-}
-const ::google::protobuf::Descriptor* tree_node::descriptor() {
-  protobuf_AssignDescriptorsOnce();
-  return tree_node_descriptor_;
-}
-
-const tree_node& tree_node::default_instance() {
-  if (default_instance_ == NULL) protobuf_AddDesc_protobuf_2fannoy_2eproto();
-  return *default_instance_;
-}
-
-tree_node* tree_node::default_instance_ = NULL;
-
-tree_node* tree_node::New(::google::protobuf::Arena* arena) const {
-  tree_node* n = new tree_node;
-  if (arena != NULL) {
-    arena->Own(n);
-  }
-  return n;
+  _impl_._cached_size_.Set(size);
 }
 
 void tree_node::Clear() {
-#define ZR_HELPER_(f) reinterpret_cast<char*>(\
-  &reinterpret_cast<tree_node*>(16)->f)
-
-#define ZR_(first, last) do {\
-  ::memset(&first, 0,\
-           ZR_HELPER_(last) - ZR_HELPER_(first) + sizeof(last));\
-} while (0)
-
-  ZR_(index_, right_);
-
-#undef ZR_HELPER_
-#undef ZR_
-
-  items_.Clear();
-  v_.Clear();
-  ::memset(_has_bits_, 0, sizeof(_has_bits_));
-  if (_internal_metadata_.have_unknown_fields()) {
-    mutable_unknown_fields()->Clear();
+// @@protoc_insertion_point(message_clear_start:tree_node)
+  uint32_t cached_has_bits = 0;
+  // Prevent compiler warnings about cached_has_bits being unused
+  (void) cached_has_bits;
+
+  _impl_.items_.Clear();
+  _impl_.v_.Clear();
+  cached_has_bits = _impl_._has_bits_[0];
+  if (cached_has_bits & 0x00000003u) {
+    if (cached_has_bits & 0x00000001u) {
+      _impl_.hv_.ClearNonDefaultToEmpty();
+    }
+    if (cached_has_bits & 0x00000002u) {
+      _impl_.leaf_data_.ClearNonDefaultToEmpty();
+    }
+  }
+  if (cached_has_bits & 0x0000003cu) {
+    ::memset(&_impl_.index_, 0, static_cast<size_t>(
+        reinterpret_cast<char*>(&_impl_.right_) -
+        reinterpret_cast<char*>(&_impl_.index_)) + sizeof(_impl_.right_));
   }
+  _impl_._has_bits_.Clear();
+  _internal_metadata_.Clear<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>();
 }
 
-bool tree_node::MergePartialFromCodedStream(
-    ::google::protobuf::io::CodedInputStream* input) {
-#define DO_(EXPRESSION) if (!(EXPRESSION)) goto failure
-  ::google::protobuf::uint32 tag;
-  // @@protoc_insertion_point(parse_start:tree_node)
-  for (;;) {
-    ::std::pair< ::google::protobuf::uint32, bool> p = input->ReadTagWithCutoff(127);
-    tag = p.first;
-    if (!p.second) goto handle_unusual;
-    switch (::google::protobuf::internal::WireFormatLite::GetTagFieldNumber(tag)) {
+const char* tree_node::_InternalParse(const char* ptr, ::_pbi::ParseContext* ctx) {
+#define CHK_(x) if (PROTOBUF_PREDICT_FALSE(!(x))) goto failure
+  _Internal::HasBits has_bits{};
+  while (!ctx->Done(&ptr)) {
+    uint32_t tag;
+    ptr = ::_pbi::ReadTag(ptr, &tag);
+    switch (tag >> 3) {
       // required uint32 index = 1;
-      case 1: {
-        if (tag == 8) {
-          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
-                   ::google::protobuf::uint32, ::google::protobuf::internal::WireFormatLite::TYPE_UINT32>(
-                 input, &index_)));
-          set_has_index();
-        } else {
+      case 1:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 8)) {
+          _Internal::set_has_index(&has_bits);
+          _impl_.index_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
           goto handle_unusual;
-        }
-        if (input->ExpectTag(16)) goto parse_leaf;
-        break;
-      }
-
+        continue;
       // required bool leaf = 2;
-      case 2: {
-        if (tag == 16) {
-         parse_leaf:
-          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
-                   bool, ::google::protobuf::internal::WireFormatLite::TYPE_BOOL>(
-                 input, &leaf_)));
-          set_has_leaf();
-        } else {
+      case 2:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 16)) {
+          _Internal::set_has_leaf(&has_bits);
+          _impl_.leaf_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint64(&ptr);
+          CHK_(ptr);
+        } else
           goto handle_unusual;
-        }
-        if (input->ExpectTag(24)) goto parse_left;
-        break;
-      }
-
+        continue;
       // optional uint32 left = 3;
-      case 3: {
-        if (tag == 24) {
-         parse_left:
-          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
-                   ::google::protobuf::uint32, ::google::protobuf::internal::WireFormatLite::TYPE_UINT32>(
-                 input, &left_)));
-          set_has_left();
-        } else {
+      case 3:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 24)) {
+          _Internal::set_has_left(&has_bits);
+          _impl_.left_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
           goto handle_unusual;
-        }
-        if (input->ExpectTag(32)) goto parse_right;
-        break;
-      }
-
+        continue;
       // optional uint32 right = 4;
-      case 4: {
-        if (tag == 32) {
-         parse_right:
-          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
-                   ::google::protobuf::uint32, ::google::protobuf::internal::WireFormatLite::TYPE_UINT32>(
-                 input, &right_)));
-          set_has_right();
-        } else {
+      case 4:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 32)) {
+          _Internal::set_has_right(&has_bits);
+          _impl_.right_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
           goto handle_unusual;
-        }
-        if (input->ExpectTag(40)) goto parse_items;
-        break;
-      }
-
+        continue;
       // repeated uint32 items = 5;
-      case 5: {
-        if (tag == 40) {
-         parse_items:
-          DO_((::google::protobuf::internal::WireFormatLite::ReadRepeatedPrimitive<
-                   ::google::protobuf::uint32, ::google::protobuf::internal::WireFormatLite::TYPE_UINT32>(
-                 1, 40, input, this->mutable_items())));
-        } else if (tag == 42) {
-          DO_((::google::protobuf::internal::WireFormatLite::ReadPackedPrimitiveNoInline<
-                   ::google::protobuf::uint32, ::google::protobuf::internal::WireFormatLite::TYPE_UINT32>(
-                 input, this->mutable_items())));
-        } else {
+      case 5:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 40)) {
+          ptr -= 1;
+          do {
+            ptr += 1;
+            _internal_add_items(::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr));
+            CHK_(ptr);
+            if (!ctx->DataAvailable(ptr)) break;
+          } while (::PROTOBUF_NAMESPACE_ID::internal::ExpectTag<40>(ptr));
+        } else if (static_cast<uint8_t>(tag) == 42) {
+          ptr = ::PROTOBUF_NAMESPACE_ID::internal::PackedUInt32Parser(_internal_mutable_items(), ptr, ctx);
+          CHK_(ptr);
+        } else
           goto handle_unusual;
-        }
-        if (input->ExpectTag(40)) goto parse_items;
-        if (input->ExpectTag(50)) goto parse_v;
-        break;
-      }
-
+        continue;
       // repeated float v = 6 [packed = true];
-      case 6: {
-        if (tag == 50) {
-         parse_v:
-          DO_((::google::protobuf::internal::WireFormatLite::ReadPackedPrimitive<
-                   float, ::google::protobuf::internal::WireFormatLite::TYPE_FLOAT>(
-                 input, this->mutable_v())));
-        } else if (tag == 53) {
-          DO_((::google::protobuf::internal::WireFormatLite::ReadRepeatedPrimitiveNoInline<
-                   float, ::google::protobuf::internal::WireFormatLite::TYPE_FLOAT>(
-                 1, 50, input, this->mutable_v())));
-        } else {
+      case 6:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 50)) {
+          ptr = ::PROTOBUF_NAMESPACE_ID::internal::PackedFloatParser(_internal_mutable_v(), ptr, ctx);
+          CHK_(ptr);
+        } else if (static_cast<uint8_t>(tag) == 53) {
+          _internal_add_v(::PROTOBUF_NAMESPACE_ID::internal::UnalignedLoad<float>(ptr));
+          ptr += sizeof(float);
+        } else
           goto handle_unusual;
-        }
-        if (input->ExpectAtEnd()) goto success;
-        break;
-      }
-
-      default: {
-      handle_unusual:
-        if (tag == 0 ||
-            ::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
-            ::google::protobuf::internal::WireFormatLite::WIRETYPE_END_GROUP) {
-          goto success;
-        }
-        DO_(::google::protobuf::internal::WireFormat::SkipField(
-              input, tag, mutable_unknown_fields()));
-        break;
-      }
+        continue;
+      // optional bytes hv = 7;
+      case 7:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 58)) {
+          auto str = _internal_mutable_hv();
+          ptr = ::_pbi::InlineGreedyStringParser(str, ptr, ctx);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      // optional bytes leaf_data = 8;
+      case 8:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 66)) {
+          auto str = _internal_mutable_leaf_data();
+          ptr = ::_pbi::InlineGreedyStringParser(str, ptr, ctx);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      default:
+        goto handle_unusual;
+    }  // switch
+  handle_unusual:
+    if ((tag == 0) || ((tag & 7) == 4)) {
+      CHK_(ptr);
+      ctx->SetLastTag(tag);
+      goto message_done;
     }
-  }
-success:
-  // @@protoc_insertion_point(parse_success:tree_node)
-  return true;
+    ptr = UnknownFieldParse(
+        tag,
+        _internal_metadata_.mutable_unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(),
+        ptr, ctx);
+    CHK_(ptr != nullptr);
+  }  // while
+message_done:
+  _impl_._has_bits_.Or(has_bits);
+  return ptr;
 failure:
-  // @@protoc_insertion_point(parse_failure:tree_node)
-  return false;
-#undef DO_
+  ptr = nullptr;
+  goto message_done;
+#undef CHK_
 }
 
-void tree_node::SerializeWithCachedSizes(
-    ::google::protobuf::io::CodedOutputStream* output) const {
-  // @@protoc_insertion_point(serialize_start:tree_node)
+uint8_t* tree_node::_InternalSerialize(
+    uint8_t* target, ::PROTOBUF_NAMESPACE_ID::io::EpsCopyOutputStream* stream) const {
+  // @@protoc_insertion_point(serialize_to_array_start:tree_node)
+  uint32_t cached_has_bits = 0;
+  (void) cached_has_bits;
+
+  cached_has_bits = _impl_._has_bits_[0];
   // required uint32 index = 1;
-  if (has_index()) {
-    ::google::protobuf::internal::WireFormatLite::WriteUInt32(1, this->index(), output);
+  if (cached_has_bits & 0x00000004u) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteUInt32ToArray(1, this->_internal_index(), target);
   }
 
   // required bool leaf = 2;
-  if (has_leaf()) {
-    ::google::protobuf::internal::WireFormatLite::WriteBool(2, this->leaf(), output);
+  if (cached_has_bits & 0x00000008u) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteBoolToArray(2, this->_internal_leaf(), target);
   }
 
   // optional uint32 left = 3;
-  if (has_left()) {
-    ::google::protobuf::internal::WireFormatLite::WriteUInt32(3, this->left(), output);
+  if (cached_has_bits & 0x00000010u) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteUInt32ToArray(3, this->_internal_left(), target);
   }
 
   // optional uint32 right = 4;
-  if (has_right()) {
-    ::google::protobuf::internal::WireFormatLite::WriteUInt32(4, this->right(), output);
+  if (cached_has_bits & 0x00000020u) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteUInt32ToArray(4, this->_internal_right(), target);
   }
 
   // repeated uint32 items = 5;
-  for (int i = 0; i < this->items_size(); i++) {
-    ::google::protobuf::internal::WireFormatLite::WriteUInt32(
-      5, this->items(i), output);
+  for (int i = 0, n = this->_internal_items_size(); i < n; i++) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteUInt32ToArray(5, this->_internal_items(i), target);
   }
 
   // repeated float v = 6 [packed = true];
-  if (this->v_size() > 0) {
-    ::google::protobuf::internal::WireFormatLite::WriteTag(6, ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED, output);
-    output->WriteVarint32(_v_cached_byte_size_);
-  }
-  for (int i = 0; i < this->v_size(); i++) {
-    ::google::protobuf::internal::WireFormatLite::WriteFloatNoTag(
-      this->v(i), output);
-  }
-
-  if (_internal_metadata_.have_unknown_fields()) {
-    ::google::protobuf::internal::WireFormat::SerializeUnknownFields(
-        unknown_fields(), output);
+  if (this->_internal_v_size() > 0) {
+    target = stream->WriteFixedPacked(6, _internal_v(), target);
   }
-  // @@protoc_insertion_point(serialize_end:tree_node)
-}
 
-::google::protobuf::uint8* tree_node::SerializeWithCachedSizesToArray(
-    ::google::protobuf::uint8* target) const {
-  // @@protoc_insertion_point(serialize_to_array_start:tree_node)
-  // required uint32 index = 1;
-  if (has_index()) {
-    target = ::google::protobuf::internal::WireFormatLite::WriteUInt32ToArray(1, this->index(), target);
+  // optional bytes hv = 7;
+  if (cached_has_bits & 0x00000001u) {
+    target = stream->WriteBytesMaybeAliased(
+        7, this->_internal_hv(), target);
   }
 
-  // required bool leaf = 2;
-  if (has_leaf()) {
-    target = ::google::protobuf::internal::WireFormatLite::WriteBoolToArray(2, this->leaf(), target);
+  // optional bytes leaf_data = 8;
+  if (cached_has_bits & 0x00000002u) {
+    target = stream->WriteBytesMaybeAliased(
+        8, this->_internal_leaf_data(), target);
   }
 
-  // optional uint32 left = 3;
-  if (has_left()) {
-    target = ::google::protobuf::internal::WireFormatLite::WriteUInt32ToArray(3, this->left(), target);
-  }
-
-  // optional uint32 right = 4;
-  if (has_right()) {
-    target = ::google::protobuf::internal::WireFormatLite::WriteUInt32ToArray(4, this->right(), target);
-  }
-
-  // repeated uint32 items = 5;
-  for (int i = 0; i < this->items_size(); i++) {
-    target = ::google::protobuf::internal::WireFormatLite::
-      WriteUInt32ToArray(5, this->items(i), target);
-  }
-
-  // repeated float v = 6 [packed = true];
-  if (this->v_size() > 0) {
-    target = ::google::protobuf::internal::WireFormatLite::WriteTagToArray(
-      6,
-      ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED,
-      target);
-    target = ::google::protobuf::io::CodedOutputStream::WriteVarint32ToArray(
-      _v_cached_byte_size_, target);
-  }
-  for (int i = 0; i < this->v_size(); i++) {
-    target = ::google::protobuf::internal::WireFormatLite::
-      WriteFloatNoTagToArray(this->v(i), target);
-  }
-
-  if (_internal_metadata_.have_unknown_fields()) {
-    target = ::google::protobuf::internal::WireFormat::SerializeUnknownFieldsToArray(
-        unknown_fields(), target);
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    target = ::_pbi::WireFormat::InternalSerializeUnknownFieldsToArray(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), target, stream);
   }
   // @@protoc_insertion_point(serialize_to_array_end:tree_node)
   return target;
 }
 
-int tree_node::RequiredFieldsByteSizeFallback() const {
-  int total_size = 0;
+size_t tree_node::RequiredFieldsByteSizeFallback() const {
+// @@protoc_insertion_point(required_fields_byte_size_fallback_start:tree_node)
+  size_t total_size = 0;
 
-  if (has_index()) {
+  if (_internal_has_index()) {
     // required uint32 index = 1;
-    total_size += 1 +
-      ::google::protobuf::internal::WireFormatLite::UInt32Size(
-        this->index());
+    total_size += ::_pbi::WireFormatLite::UInt32SizePlusOne(this->_internal_index());
   }
 
-  if (has_leaf()) {
+  if (_internal_has_leaf()) {
     // required bool leaf = 2;
     total_size += 1 + 1;
   }
 
   return total_size;
 }
-int tree_node::ByteSize() const {
-  int total_size = 0;
+size_t tree_node::ByteSizeLong() const {
+// @@protoc_insertion_point(message_byte_size_start:tree_node)
+  size_t total_size = 0;
 
-  if (((_has_bits_[0] & 0x00000003) ^ 0x00000003) == 0) {  // All required fields are present.
+  if (((_impl_._has_bits_[0] & 0x0000000c) ^ 0x0000000c) == 0) {  // All required fields are present.
     // required uint32 index = 1;
-    total_size += 1 +
-      ::google::protobuf::internal::WireFormatLite::UInt32Size(
-        this->index());
+    total_size += ::_pbi::WireFormatLite::UInt32SizePlusOne(this->_internal_index());
 
     // required bool leaf = 2;
     total_size += 1 + 1;
@@ -835,295 +840,812 @@ int tree_node::ByteSize() const {
   } else {
     total_size += RequiredFieldsByteSizeFallback();
   }
-  if (_has_bits_[2 / 32] & 12u) {
-    // optional uint32 left = 3;
-    if (has_left()) {
-      total_size += 1 +
-        ::google::protobuf::internal::WireFormatLite::UInt32Size(
-          this->left());
-    }
+  uint32_t cached_has_bits = 0;
+  // Prevent compiler warnings about cached_has_bits being unused
+  (void) cached_has_bits;
 
-    // optional uint32 right = 4;
-    if (has_right()) {
-      total_size += 1 +
-        ::google::protobuf::internal::WireFormatLite::UInt32Size(
-          this->right());
-    }
-
-  }
   // repeated uint32 items = 5;
   {
-    int data_size = 0;
-    for (int i = 0; i < this->items_size(); i++) {
-      data_size += ::google::protobuf::internal::WireFormatLite::
-        UInt32Size(this->items(i));
-    }
-    total_size += 1 * this->items_size() + data_size;
+    size_t data_size = ::_pbi::WireFormatLite::
+      UInt32Size(this->_impl_.items_);
+    total_size += 1 *
+                  ::_pbi::FromIntSize(this->_internal_items_size());
+    total_size += data_size;
   }
 
   // repeated float v = 6 [packed = true];
   {
-    int data_size = 0;
-    data_size = 4 * this->v_size();
+    unsigned int count = static_cast<unsigned int>(this->_internal_v_size());
+    size_t data_size = 4UL * count;
     if (data_size > 0) {
       total_size += 1 +
-        ::google::protobuf::internal::WireFormatLite::Int32Size(data_size);
+        ::_pbi::WireFormatLite::Int32Size(static_cast<int32_t>(data_size));
     }
-    GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
-    _v_cached_byte_size_ = data_size;
-    GOOGLE_SAFE_CONCURRENT_WRITES_END();
     total_size += data_size;
   }
 
-  if (_internal_metadata_.have_unknown_fields()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormat::ComputeUnknownFieldsSize(
-        unknown_fields());
-  }
-  GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
-  _cached_size_ = total_size;
-  GOOGLE_SAFE_CONCURRENT_WRITES_END();
-  return total_size;
-}
+  cached_has_bits = _impl_._has_bits_[0];
+  if (cached_has_bits & 0x00000003u) {
+    // optional bytes hv = 7;
+    if (cached_has_bits & 0x00000001u) {
+      total_size += 1 +
+        ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::BytesSize(
+          this->_internal_hv());
+    }
+
+    // optional bytes leaf_data = 8;
+    if (cached_has_bits & 0x00000002u) {
+      total_size += 1 +
+        ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::BytesSize(
+          this->_internal_leaf_data());
+    }
 
-void tree_node::MergeFrom(const ::google::protobuf::Message& from) {
-  if (GOOGLE_PREDICT_FALSE(&from == this)) MergeFromFail(__LINE__);
-  const tree_node* source = 
-      ::google::protobuf::internal::DynamicCastToGenerated<const tree_node>(
-          &from);
-  if (source == NULL) {
-    ::google::protobuf::internal::ReflectionOps::Merge(from, this);
-  } else {
-    MergeFrom(*source);
   }
-}
+  if (cached_has_bits & 0x00000030u) {
+    // optional uint32 left = 3;
+    if (cached_has_bits & 0x00000010u) {
+      total_size += ::_pbi::WireFormatLite::UInt32SizePlusOne(this->_internal_left());
+    }
+
+    // optional uint32 right = 4;
+    if (cached_has_bits & 0x00000020u) {
+      total_size += ::_pbi::WireFormatLite::UInt32SizePlusOne(this->_internal_right());
+    }
 
-void tree_node::MergeFrom(const tree_node& from) {
-  if (GOOGLE_PREDICT_FALSE(&from == this)) MergeFromFail(__LINE__);
-  items_.MergeFrom(from.items_);
-  v_.MergeFrom(from.v_);
-  if (from._has_bits_[0 / 32] & (0xffu << (0 % 32))) {
-    if (from.has_index()) {
-      set_index(from.index());
+  }
+  return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
+}
+
+const ::PROTOBUF_NAMESPACE_ID::Message::ClassData tree_node::_class_data_ = {
+    ::PROTOBUF_NAMESPACE_ID::Message::CopyWithSourceCheck,
+    tree_node::MergeImpl
+};
+const ::PROTOBUF_NAMESPACE_ID::Message::ClassData*tree_node::GetClassData() const { return &_class_data_; }
+
+
+void tree_node::MergeImpl(::PROTOBUF_NAMESPACE_ID::Message& to_msg, const ::PROTOBUF_NAMESPACE_ID::Message& from_msg) {
+  auto* const _this = static_cast<tree_node*>(&to_msg);
+  auto& from = static_cast<const tree_node&>(from_msg);
+  // @@protoc_insertion_point(class_specific_merge_from_start:tree_node)
+  GOOGLE_DCHECK_NE(&from, _this);
+  uint32_t cached_has_bits = 0;
+  (void) cached_has_bits;
+
+  _this->_impl_.items_.MergeFrom(from._impl_.items_);
+  _this->_impl_.v_.MergeFrom(from._impl_.v_);
+  cached_has_bits = from._impl_._has_bits_[0];
+  if (cached_has_bits & 0x0000003fu) {
+    if (cached_has_bits & 0x00000001u) {
+      _this->_internal_set_hv(from._internal_hv());
     }
-    if (from.has_leaf()) {
-      set_leaf(from.leaf());
+    if (cached_has_bits & 0x00000002u) {
+      _this->_internal_set_leaf_data(from._internal_leaf_data());
     }
-    if (from.has_left()) {
-      set_left(from.left());
+    if (cached_has_bits & 0x00000004u) {
+      _this->_impl_.index_ = from._impl_.index_;
     }
-    if (from.has_right()) {
-      set_right(from.right());
+    if (cached_has_bits & 0x00000008u) {
+      _this->_impl_.leaf_ = from._impl_.leaf_;
     }
+    if (cached_has_bits & 0x00000010u) {
+      _this->_impl_.left_ = from._impl_.left_;
+    }
+    if (cached_has_bits & 0x00000020u) {
+      _this->_impl_.right_ = from._impl_.right_;
+    }
+    _this->_impl_._has_bits_[0] |= cached_has_bits;
   }
-  if (from._internal_metadata_.have_unknown_fields()) {
-    mutable_unknown_fields()->MergeFrom(from.unknown_fields());
-  }
-}
-
-void tree_node::CopyFrom(const ::google::protobuf::Message& from) {
-  if (&from == this) return;
-  Clear();
-  MergeFrom(from);
+  _this->_internal_metadata_.MergeFrom<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(from._internal_metadata_);
 }
 
 void tree_node::CopyFrom(const tree_node& from) {
+// @@protoc_insertion_point(class_specific_copy_from_start:tree_node)
   if (&from == this) return;
   Clear();
   MergeFrom(from);
 }
 
 bool tree_node::IsInitialized() const {
-  if ((_has_bits_[0] & 0x00000003) != 0x00000003) return false;
-
+  if (_Internal::MissingRequiredFields(_impl_._has_bits_)) return false;
   return true;
 }
 
-void tree_node::Swap(tree_node* other) {
-  if (other == this) return;
-  InternalSwap(other);
-}
 void tree_node::InternalSwap(tree_node* other) {
-  std::swap(index_, other->index_);
-  std::swap(leaf_, other->leaf_);
-  std::swap(left_, other->left_);
-  std::swap(right_, other->right_);
-  items_.UnsafeArenaSwap(&other->items_);
-  v_.UnsafeArenaSwap(&other->v_);
-  std::swap(_has_bits_[0], other->_has_bits_[0]);
-  _internal_metadata_.Swap(&other->_internal_metadata_);
-  std::swap(_cached_size_, other->_cached_size_);
+  using std::swap;
+  auto* lhs_arena = GetArenaForAllocation();
+  auto* rhs_arena = other->GetArenaForAllocation();
+  _internal_metadata_.InternalSwap(&other->_internal_metadata_);
+  swap(_impl_._has_bits_[0], other->_impl_._has_bits_[0]);
+  _impl_.items_.InternalSwap(&other->_impl_.items_);
+  _impl_.v_.InternalSwap(&other->_impl_.v_);
+  ::PROTOBUF_NAMESPACE_ID::internal::ArenaStringPtr::InternalSwap(
+      &_impl_.hv_, lhs_arena,
+      &other->_impl_.hv_, rhs_arena
+  );
+  ::PROTOBUF_NAMESPACE_ID::internal::ArenaStringPtr::InternalSwap(
+      &_impl_.leaf_data_, lhs_arena,
+      &other->_impl_.leaf_data_, rhs_arena
+  );
+  ::PROTOBUF_NAMESPACE_ID::internal::memswap<
+      PROTOBUF_FIELD_OFFSET(tree_node, _impl_.right_)
+      + sizeof(tree_node::_impl_.right_)
+      - PROTOBUF_FIELD_OFFSET(tree_node, _impl_.index_)>(
+          reinterpret_cast<char*>(&_impl_.index_),
+          reinterpret_cast<char*>(&other->_impl_.index_));
+}
+
+::PROTOBUF_NAMESPACE_ID::Metadata tree_node::GetMetadata() const {
+  return ::_pbi::AssignDescriptors(
+      &descriptor_table_protobuf_2fannoy_2eproto_getter, &descriptor_table_protobuf_2fannoy_2eproto_once,
+      file_level_metadata_protobuf_2fannoy_2eproto[1]);
 }
 
-::google::protobuf::Metadata tree_node::GetMetadata() const {
-  protobuf_AssignDescriptorsOnce();
-  ::google::protobuf::Metadata metadata;
-  metadata.descriptor = tree_node_descriptor_;
-  metadata.reflection = tree_node_reflection_;
-  return metadata;
-}
-
-#if PROTOBUF_INLINE_NOT_IN_HEADERS
-// tree_node
+// ===================================================================
 
-// required uint32 index = 1;
-bool tree_node::has_index() const {
-  return (_has_bits_[0] & 0x00000001u) != 0;
-}
-void tree_node::set_has_index() {
-  _has_bits_[0] |= 0x00000001u;
-}
-void tree_node::clear_has_index() {
-  _has_bits_[0] &= ~0x00000001u;
-}
-void tree_node::clear_index() {
-  index_ = 0u;
-  clear_has_index();
-}
- ::google::protobuf::uint32 tree_node::index() const {
-  // @@protoc_insertion_point(field_get:tree_node.index)
-  return index_;
-}
- void tree_node::set_index(::google::protobuf::uint32 value) {
-  set_has_index();
-  index_ = value;
-  // @@protoc_insertion_point(field_set:tree_node.index)
+class index_meta::_Internal {
+ public:
+  using HasBits = decltype(std::declval<index_meta>()._impl_._has_bits_);
+  static void set_has_codec(HasBits* has_bits) {
+    (*has_bits)[0] |= 1u;
+  }
+  static void set_has_vector_type(HasBits* has_bits) {
+    (*has_bits)[0] |= 2u;
+  }
+  static void set_has_leaf_embed_trees(HasBits* has_bits) {
+    (*has_bits)[0] |= 4u;
+  }
+  static void set_has_leaf_page_size(HasBits* has_bits) {
+    (*has_bits)[0] |= 8u;
+  }
+  static void set_has_leaf_capacity(HasBits* has_bits) {
+    (*has_bits)[0] |= 16u;
+  }
+  static void set_has_tree_dbs(HasBits* has_bits) {
+    (*has_bits)[0] |= 32u;
+  }
+  static void set_has_seed(HasBits* has_bits) {
+    (*has_bits)[0] |= 64u;
+  }
+};
+
+index_meta::index_meta(::PROTOBUF_NAMESPACE_ID::Arena* arena,
+                         bool is_message_owned)
+  : ::PROTOBUF_NAMESPACE_ID::Message(arena, is_message_owned) {
+  SharedCtor(arena, is_message_owned);
+  // @@protoc_insertion_point(arena_constructor:index_meta)
+}
+index_meta::index_meta(const index_meta& from)
+  : ::PROTOBUF_NAMESPACE_ID::Message() {
+  index_meta* const _this = this; (void)_this;
+  new (&_impl_) Impl_{
+      decltype(_impl_._has_bits_){from._impl_._has_bits_}
+    , /*decltype(_impl_._cached_size_)*/{}
+    , decltype(_impl_.codec_){}
+    , decltype(_impl_.vector_type_){}
+    , decltype(_impl_.leaf_embed_trees_){}
+    , decltype(_impl_.leaf_page_size_){}
+    , decltype(_impl_.leaf_capacity_){}
+    , decltype(_impl_.tree_dbs_){}
+    , decltype(_impl_.seed_){}};
+
+  _internal_metadata_.MergeFrom<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(from._internal_metadata_);
+  ::memcpy(&_impl_.codec_, &from._impl_.codec_,
+    static_cast<size_t>(reinterpret_cast<char*>(&_impl_.seed_) -
+    reinterpret_cast<char*>(&_impl_.codec_)) + sizeof(_impl_.seed_));
+  // @@protoc_insertion_point(copy_constructor:index_meta)
+}
+
+inline void index_meta::SharedCtor(
+    ::_pb::Arena* arena, bool is_message_owned) {
+  (void)arena;
+  (void)is_message_owned;
+  new (&_impl_) Impl_{
+      decltype(_impl_._has_bits_){}
+    , /*decltype(_impl_._cached_size_)*/{}
+    , decltype(_impl_.codec_){0u}
+    , decltype(_impl_.vector_type_){0u}
+    , decltype(_impl_.leaf_embed_trees_){0u}
+    , decltype(_impl_.leaf_page_size_){0u}
+    , decltype(_impl_.leaf_capacity_){0u}
+    , decltype(_impl_.tree_dbs_){false}
+    , decltype(_impl_.seed_){uint64_t{0u}}
+  };
 }
 
-// required bool leaf = 2;
-bool tree_node::has_leaf() const {
-  return (_has_bits_[0] & 0x00000002u) != 0;
-}
-void tree_node::set_has_leaf() {
-  _has_bits_[0] |= 0x00000002u;
-}
-void tree_node::clear_has_leaf() {
-  _has_bits_[0] &= ~0x00000002u;
-}
-void tree_node::clear_leaf() {
-  leaf_ = false;
-  clear_has_leaf();
-}
- bool tree_node::leaf() const {
-  // @@protoc_insertion_point(field_get:tree_node.leaf)
-  return leaf_;
-}
- void tree_node::set_leaf(bool value) {
-  set_has_leaf();
-  leaf_ = value;
-  // @@protoc_insertion_point(field_set:tree_node.leaf)
+index_meta::~index_meta() {
+  // @@protoc_insertion_point(destructor:index_meta)
+  if (auto *arena = _internal_metadata_.DeleteReturnArena<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>()) {
+  (void)arena;
+    return;
+  }
+  SharedDtor();
 }
 
-// optional uint32 left = 3;
-bool tree_node::has_left() const {
-  return (_has_bits_[0] & 0x00000004u) != 0;
-}
-void tree_node::set_has_left() {
-  _has_bits_[0] |= 0x00000004u;
-}
-void tree_node::clear_has_left() {
-  _has_bits_[0] &= ~0x00000004u;
+inline void index_meta::SharedDtor() {
+  GOOGLE_DCHECK(GetArenaForAllocation() == nullptr);
 }
-void tree_node::clear_left() {
-  left_ = 0u;
-  clear_has_left();
+
+void index_meta::SetCachedSize(int size) const {
+  _impl_._cached_size_.Set(size);
 }
- ::google::protobuf::uint32 tree_node::left() const {
-  // @@protoc_insertion_point(field_get:tree_node.left)
-  return left_;
+
+void index_meta::Clear() {
+// @@protoc_insertion_point(message_clear_start:index_meta)
+  uint32_t cached_has_bits = 0;
+  // Prevent compiler warnings about cached_has_bits being unused
+  (void) cached_has_bits;
+
+  cached_has_bits = _impl_._has_bits_[0];
+  if (cached_has_bits & 0x0000007fu) {
+    ::memset(&_impl_.codec_, 0, static_cast<size_t>(
+        reinterpret_cast<char*>(&_impl_.seed_) -
+        reinterpret_cast<char*>(&_impl_.codec_)) + sizeof(_impl_.seed_));
+  }
+  _impl_._has_bits_.Clear();
+  _internal_metadata_.Clear<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>();
+}
+
+const char* index_meta::_InternalParse(const char* ptr, ::_pbi::ParseContext* ctx) {
+#define CHK_(x) if (PROTOBUF_PREDICT_FALSE(!(x))) goto failure
+  _Internal::HasBits has_bits{};
+  while (!ctx->Done(&ptr)) {
+    uint32_t tag;
+    ptr = ::_pbi::ReadTag(ptr, &tag);
+    switch (tag >> 3) {
+      // optional uint32 codec = 1;
+      case 1:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 8)) {
+          _Internal::set_has_codec(&has_bits);
+          _impl_.codec_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      // optional uint32 vector_type = 2;
+      case 2:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 16)) {
+          _Internal::set_has_vector_type(&has_bits);
+          _impl_.vector_type_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      // optional uint32 leaf_embed_trees = 3;
+      case 3:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 24)) {
+          _Internal::set_has_leaf_embed_trees(&has_bits);
+          _impl_.leaf_embed_trees_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      // optional uint32 leaf_page_size = 4;
+      case 4:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 32)) {
+          _Internal::set_has_leaf_page_size(&has_bits);
+          _impl_.leaf_page_size_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      // optional uint32 leaf_capacity = 5;
+      case 5:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 40)) {
+          _Internal::set_has_leaf_capacity(&has_bits);
+          _impl_.leaf_capacity_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      // optional bool tree_dbs = 6;
+      case 6:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 48)) {
+          _Internal::set_has_tree_dbs(&has_bits);
+          _impl_.tree_dbs_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint64(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      // optional uint64 seed = 7;
+      case 7:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 56)) {
+          _Internal::set_has_seed(&has_bits);
+          _impl_.seed_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint64(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      default:
+        goto handle_unusual;
+    }  // switch
+  handle_unusual:
+    if ((tag == 0) || ((tag & 7) == 4)) {
+      CHK_(ptr);
+      ctx->SetLastTag(tag);
+      goto message_done;
+    }
+    ptr = UnknownFieldParse(
+        tag,
+        _internal_metadata_.mutable_unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(),
+        ptr, ctx);
+    CHK_(ptr != nullptr);
+  }  // while
+message_done:
+  _impl_._has_bits_.Or(has_bits);
+  return ptr;
+failure:
+  ptr = nullptr;
+  goto message_done;
+#undef CHK_
+}
+
+uint8_t* index_meta::_InternalSerialize(
+    uint8_t* target, ::PROTOBUF_NAMESPACE_ID::io::EpsCopyOutputStream* stream) const {
+  // @@protoc_insertion_point(serialize_to_array_start:index_meta)
+  uint32_t cached_has_bits = 0;
+  (void) cached_has_bits;
+
+  cached_has_bits = _impl_._has_bits_[0];
+  // optional uint32 codec = 1;
+  if (cached_has_bits & 0x00000001u) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteUInt32ToArray(1, this->_internal_codec(), target);
+  }
+
+  // optional uint32 vector_type = 2;
+  if (cached_has_bits & 0x00000002u) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteUInt32ToArray(2, this->_internal_vector_type(), target);
+  }
+
+  // optional uint32 leaf_embed_trees = 3;
+  if (cached_has_bits & 0x00000004u) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteUInt32ToArray(3, this->_internal_leaf_embed_trees(), target);
+  }
+
+  // optional uint32 leaf_page_size = 4;
+  if (cached_has_bits & 0x00000008u) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteUInt32ToArray(4, this->_internal_leaf_page_size(), target);
+  }
+
+  // optional uint32 leaf_capacity = 5;
+  if (cached_has_bits & 0x00000010u) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteUInt32ToArray(5, this->_internal_leaf_capacity(), target);
+  }
+
+  // optional bool tree_dbs = 6;
+  if (cached_has_bits & 0x00000020u) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteBoolToArray(6, this->_internal_tree_dbs(), target);
+  }
+
+  // optional uint64 seed = 7;
+  if (cached_has_bits & 0x00000040u) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteUInt64ToArray(7, this->_internal_seed(), target);
+  }
+
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    target = ::_pbi::WireFormat::InternalSerializeUnknownFieldsToArray(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), target, stream);
+  }
+  // @@protoc_insertion_point(serialize_to_array_end:index_meta)
+  return target;
 }
- void tree_node::set_left(::google::protobuf::uint32 value) {
-  set_has_left();
-  left_ = value;
-  // @@protoc_insertion_point(field_set:tree_node.left)
+
+size_t index_meta::ByteSizeLong() const {
+// @@protoc_insertion_point(message_byte_size_start:index_meta)
+  size_t total_size = 0;
+
+  uint32_t cached_has_bits = 0;
+  // Prevent compiler warnings about cached_has_bits being unused
+  (void) cached_has_bits;
+
+  cached_has_bits = _impl_._has_bits_[0];
+  if (cached_has_bits & 0x0000007fu) {
+    // optional uint32 codec = 1;
+    if (cached_has_bits & 0x00000001u) {
+      total_size += ::_pbi::WireFormatLite::UInt32SizePlusOne(this->_internal_codec());
+    }
+
+    // optional uint32 vector_type = 2;
+    if (cached_has_bits & 0x00000002u) {
+      total_size += ::_pbi::WireFormatLite::UInt32SizePlusOne(this->_internal_vector_type());
+    }
+
+    // optional uint32 leaf_embed_trees = 3;
+    if (cached_has_bits & 0x00000004u) {
+      total_size += ::_pbi::WireFormatLite::UInt32SizePlusOne(this->_internal_leaf_embed_trees());
+    }
+
+    // optional uint32 leaf_page_size = 4;
+    if (cached_has_bits & 0x00000008u) {
+      total_size += ::_pbi::WireFormatLite::UInt32SizePlusOne(this->_internal_leaf_page_size());
+    }
+
+    // optional uint32 leaf_capacity = 5;
+    if (cached_has_bits & 0x00000010u) {
+      total_size += ::_pbi::WireFormatLite::UInt32SizePlusOne(this->_internal_leaf_capacity());
+    }
+
+    // optional bool tree_dbs = 6;
+    if (cached_has_bits & 0x00000020u) {
+      total_size += 1 + 1;
+    }
+
+    // optional uint64 seed = 7;
+    if (cached_has_bits & 0x00000040u) {
+      total_size += ::_pbi::WireFormatLite::UInt64SizePlusOne(this->_internal_seed());
+    }
+
+  }
+  return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
-// optional uint32 right = 4;
-bool tree_node::has_right() const {
-  return (_has_bits_[0] & 0x00000008u) != 0;
+const ::PROTOBUF_NAMESPACE_ID::Message::ClassData index_meta::_class_data_ = {
+    ::PROTOBUF_NAMESPACE_ID::Message::CopyWithSourceCheck,
+    index_meta::MergeImpl
+};
+const ::PROTOBUF_NAMESPACE_ID::Message::ClassData*index_meta::GetClassData() const { return &_class_data_; }
+
+
+void index_meta::MergeImpl(::PROTOBUF_NAMESPACE_ID::Message& to_msg, const ::PROTOBUF_NAMESPACE_ID::Message& from_msg) {
+  auto* const _this = static_cast<index_meta*>(&to_msg);
+  auto& from = static_cast<const index_meta&>(from_msg);
+  // @@protoc_insertion_point(class_specific_merge_from_start:index_meta)
+  GOOGLE_DCHECK_NE(&from, _this);
+  uint32_t cached_has_bits = 0;
+  (void) cached_has_bits;
+
+  cached_has_bits = from._impl_._has_bits_[0];
+  if (cached_has_bits & 0x0000007fu) {
+    if (cached_has_bits & 0x00000001u) {
+      _this->_impl_.codec_ = from._impl_.codec_;
+    }
+    if (cached_has_bits & 0x00000002u) {
+      _this->_impl_.vector_type_ = from._impl_.vector_type_;
+    }
+    if (cached_has_bits & 0x00000004u) {
+      _this->_impl_.leaf_embed_trees_ = from._impl_.leaf_embed_trees_;
+    }
+    if (cached_has_bits & 0x00000008u) {
+      _this->_impl_.leaf_page_size_ = from._impl_.leaf_page_size_;
+    }
+    if (cached_has_bits & 0x00000010u) {
+      _this->_impl_.leaf_capacity_ = from._impl_.leaf_capacity_;
+    }
+    if (cached_has_bits & 0x00000020u) {
+      _this->_impl_.tree_dbs_ = from._impl_.tree_dbs_;
+    }
+    if (cached_has_bits & 0x00000040u) {
+      _this->_impl_.seed_ = from._impl_.seed_;
+    }
+    _this->_impl_._has_bits_[0] |= cached_has_bits;
+  }
+  _this->_internal_metadata_.MergeFrom<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(from._internal_metadata_);
 }
-void tree_node::set_has_right() {
-  _has_bits_[0] |= 0x00000008u;
+
+void index_meta::CopyFrom(const index_meta& from) {
+// @@protoc_insertion_point(class_specific_copy_from_start:index_meta)
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
 }
-void tree_node::clear_has_right() {
-  _has_bits_[0] &= ~0x00000008u;
+
+bool index_meta::IsInitialized() const {
+  return true;
 }
-void tree_node::clear_right() {
-  right_ = 0u;
-  clear_has_right();
+
+void index_meta::InternalSwap(index_meta* other) {
+  using std::swap;
+  _internal_metadata_.InternalSwap(&other->_internal_metadata_);
+  swap(_impl_._has_bits_[0], other->_impl_._has_bits_[0]);
+  ::PROTOBUF_NAMESPACE_ID::internal::memswap<
+      PROTOBUF_FIELD_OFFSET(index_meta, _impl_.seed_)
+      + sizeof(index_meta::_impl_.seed_)
+      - PROTOBUF_FIELD_OFFSET(index_meta, _impl_.codec_)>(
+          reinterpret_cast<char*>(&_impl_.codec_),
+          reinterpret_cast<char*>(&other->_impl_.codec_));
 }
- ::google::protobuf::uint32 tree_node::right() const {
-  // @@protoc_insertion_point(field_get:tree_node.right)
-  return right_;
+
+::PROTOBUF_NAMESPACE_ID::Metadata index_meta::GetMetadata() const {
+  return ::_pbi::AssignDescriptors(
+      &descriptor_table_protobuf_2fannoy_2eproto_getter, &descriptor_table_protobuf_2fannoy_2eproto_once,
+      file_level_metadata_protobuf_2fannoy_2eproto[2]);
 }
- void tree_node::set_right(::google::protobuf::uint32 value) {
-  set_has_right();
-  right_ = value;
-  // @@protoc_insertion_point(field_set:tree_node.right)
+
+// ===================================================================
+
+class pq_codebook::_Internal {
+ public:
+  using HasBits = decltype(std::declval<pq_codebook>()._impl_._has_bits_);
+  static void set_has_m(HasBits* has_bits) {
+    (*has_bits)[0] |= 1u;
+  }
+  static void set_has_nbits(HasBits* has_bits) {
+    (*has_bits)[0] |= 2u;
+  }
+};
+
+pq_codebook::pq_codebook(::PROTOBUF_NAMESPACE_ID::Arena* arena,
+                         bool is_message_owned)
+  : ::PROTOBUF_NAMESPACE_ID::Message(arena, is_message_owned) {
+  SharedCtor(arena, is_message_owned);
+  // @@protoc_insertion_point(arena_constructor:pq_codebook)
+}
+pq_codebook::pq_codebook(const pq_codebook& from)
+  : ::PROTOBUF_NAMESPACE_ID::Message() {
+  pq_codebook* const _this = this; (void)_this;
+  new (&_impl_) Impl_{
+      decltype(_impl_._has_bits_){from._impl_._has_bits_}
+    , /*decltype(_impl_._cached_size_)*/{}
+    , decltype(_impl_.centroids_){from._impl_.centroids_}
+    , decltype(_impl_.m_){}
+    , decltype(_impl_.nbits_){}};
+
+  _internal_metadata_.MergeFrom<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(from._internal_metadata_);
+  ::memcpy(&_impl_.m_, &from._impl_.m_,
+    static_cast<size_t>(reinterpret_cast<char*>(&_impl_.nbits_) -
+    reinterpret_cast<char*>(&_impl_.m_)) + sizeof(_impl_.nbits_));
+  // @@protoc_insertion_point(copy_constructor:pq_codebook)
+}
+
+inline void pq_codebook::SharedCtor(
+    ::_pb::Arena* arena, bool is_message_owned) {
+  (void)arena;
+  (void)is_message_owned;
+  new (&_impl_) Impl_{
+      decltype(_impl_._has_bits_){}
+    , /*decltype(_impl_._cached_size_)*/{}
+    , decltype(_impl_.centroids_){arena}
+    , decltype(_impl_.m_){0u}
+    , decltype(_impl_.nbits_){0u}
+  };
 }
 
-// repeated uint32 items = 5;
-int tree_node::items_size() const {
-  return items_.size();
+pq_codebook::~pq_codebook() {
+  // @@protoc_insertion_point(destructor:pq_codebook)
+  if (auto *arena = _internal_metadata_.DeleteReturnArena<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>()) {
+  (void)arena;
+    return;
+  }
+  SharedDtor();
 }
-void tree_node::clear_items() {
-  items_.Clear();
+
+inline void pq_codebook::SharedDtor() {
+  GOOGLE_DCHECK(GetArenaForAllocation() == nullptr);
+  _impl_.centroids_.~RepeatedField();
 }
- ::google::protobuf::uint32 tree_node::items(int index) const {
-  // @@protoc_insertion_point(field_get:tree_node.items)
-  return items_.Get(index);
+
+void pq_codebook::SetCachedSize(int size) const {
+  _impl_._cached_size_.Set(size);
 }
- void tree_node::set_items(int index, ::google::protobuf::uint32 value) {
-  items_.Set(index, value);
-  // @@protoc_insertion_point(field_set:tree_node.items)
+
+void pq_codebook::Clear() {
+// @@protoc_insertion_point(message_clear_start:pq_codebook)
+  uint32_t cached_has_bits = 0;
+  // Prevent compiler warnings about cached_has_bits being unused
+  (void) cached_has_bits;
+
+  _impl_.centroids_.Clear();
+  cached_has_bits = _impl_._has_bits_[0];
+  if (cached_has_bits & 0x00000003u) {
+    ::memset(&_impl_.m_, 0, static_cast<size_t>(
+        reinterpret_cast<char*>(&_impl_.nbits_) -
+        reinterpret_cast<char*>(&_impl_.m_)) + sizeof(_impl_.nbits_));
+  }
+  _impl_._has_bits_.Clear();
+  _internal_metadata_.Clear<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>();
+}
+
+const char* pq_codebook::_InternalParse(const char* ptr, ::_pbi::ParseContext* ctx) {
+#define CHK_(x) if (PROTOBUF_PREDICT_FALSE(!(x))) goto failure
+  _Internal::HasBits has_bits{};
+  while (!ctx->Done(&ptr)) {
+    uint32_t tag;
+    ptr = ::_pbi::ReadTag(ptr, &tag);
+    switch (tag >> 3) {
+      // optional uint32 m = 1;
+      case 1:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 8)) {
+          _Internal::set_has_m(&has_bits);
+          _impl_.m_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      // optional uint32 nbits = 2;
+      case 2:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 16)) {
+          _Internal::set_has_nbits(&has_bits);
+          _impl_.nbits_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      // repeated float centroids = 3 [packed = true];
+      case 3:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 26)) {
+          ptr = ::PROTOBUF_NAMESPACE_ID::internal::PackedFloatParser(_internal_mutable_centroids(), ptr, ctx);
+          CHK_(ptr);
+        } else if (static_cast<uint8_t>(tag) == 29) {
+          _internal_add_centroids(::PROTOBUF_NAMESPACE_ID::internal::UnalignedLoad<float>(ptr));
+          ptr += sizeof(float);
+        } else
+          goto handle_unusual;
+        continue;
+      default:
+        goto handle_unusual;
+    }  // switch
+  handle_unusual:
+    if ((tag == 0) || ((tag & 7) == 4)) {
+      CHK_(ptr);
+      ctx->SetLastTag(tag);
+      goto message_done;
+    }
+    ptr = UnknownFieldParse(
+        tag,
+        _internal_metadata_.mutable_unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(),
+        ptr, ctx);
+    CHK_(ptr != nullptr);
+  }  // while
+message_done:
+  _impl_._has_bits_.Or(has_bits);
+  return ptr;
+failure:
+  ptr = nullptr;
+  goto message_done;
+#undef CHK_
+}
+
+uint8_t* pq_codebook::_InternalSerialize(
+    uint8_t* target, ::PROTOBUF_NAMESPACE_ID::io::EpsCopyOutputStream* stream) const {
+  // @@protoc_insertion_point(serialize_to_array_start:pq_codebook)
+  uint32_t cached_has_bits = 0;
+  (void) cached_has_bits;
+
+  cached_has_bits = _impl_._has_bits_[0];
+  // optional uint32 m = 1;
+  if (cached_has_bits & 0x00000001u) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteUInt32ToArray(1, this->_internal_m(), target);
+  }
+
+  // optional uint32 nbits = 2;
+  if (cached_has_bits & 0x00000002u) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteUInt32ToArray(2, this->_internal_nbits(), target);
+  }
+
+  // repeated float centroids = 3 [packed = true];
+  if (this->_internal_centroids_size() > 0) {
+    target = stream->WriteFixedPacked(3, _internal_centroids(), target);
+  }
+
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    target = ::_pbi::WireFormat::InternalSerializeUnknownFieldsToArray(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), target, stream);
+  }
+  // @@protoc_insertion_point(serialize_to_array_end:pq_codebook)
+  return target;
 }
- void tree_node::add_items(::google::protobuf::uint32 value) {
-  items_.Add(value);
-  // @@protoc_insertion_point(field_add:tree_node.items)
+
+size_t pq_codebook::ByteSizeLong() const {
+// @@protoc_insertion_point(message_byte_size_start:pq_codebook)
+  size_t total_size = 0;
+
+  uint32_t cached_has_bits = 0;
+  // Prevent compiler warnings about cached_has_bits being unused
+  (void) cached_has_bits;
+
+  // repeated float centroids = 3 [packed = true];
+  {
+    unsigned int count = static_cast<unsigned int>(this->_internal_centroids_size());
+    size_t data_size = 4UL * count;
+    if (data_size > 0) {
+      total_size += 1 +
+        ::_pbi::WireFormatLite::Int32Size(static_cast<int32_t>(data_size));
+    }
+    total_size += data_size;
+  }
+
+  cached_has_bits = _impl_._has_bits_[0];
+  if (cached_has_bits & 0x00000003u) {
+    // optional uint32 m = 1;
+    if (cached_has_bits & 0x00000001u) {
+      total_size += ::_pbi::WireFormatLite::UInt32SizePlusOne(this->_internal_m());
+    }
+
+    // optional uint32 nbits = 2;
+    if (cached_has_bits & 0x00000002u) {
+      total_size += ::_pbi::WireFormatLite::UInt32SizePlusOne(this->_internal_nbits());
+    }
+
+  }
+  return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
- const ::google::protobuf::RepeatedField< ::google::protobuf::uint32 >&
-tree_node::items() const {
-  // @@protoc_insertion_point(field_list:tree_node.items)
-  return items_;
+
+const ::PROTOBUF_NAMESPACE_ID::Message::ClassData pq_codebook::_class_data_ = {
+    ::PROTOBUF_NAMESPACE_ID::Message::CopyWithSourceCheck,
+    pq_codebook::MergeImpl
+};
+const ::PROTOBUF_NAMESPACE_ID::Message::ClassData*pq_codebook::GetClassData() const { return &_class_data_; }
+
+
+void pq_codebook::MergeImpl(::PROTOBUF_NAMESPACE_ID::Message& to_msg, const ::PROTOBUF_NAMESPACE_ID::Message& from_msg) {
+  auto* const _this = static_cast<pq_codebook*>(&to_msg);
+  auto& from = static_cast<const pq_codebook&>(from_msg);
+  // @@protoc_insertion_point(class_specific_merge_from_start:pq_codebook)
+  GOOGLE_DCHECK_NE(&from, _this);
+  uint32_t cached_has_bits = 0;
+  (void) cached_has_bits;
+
+  _this->_impl_.centroids_.MergeFrom(from._impl_.centroids_);
+  cached_has_bits = from._impl_._has_bits_[0];
+  if (cached_has_bits & 0x00000003u) {
+    if (cached_has_bits & 0x00000001u) {
+      _this->_impl_.m_ = from._impl_.m_;
+    }
+    if (cached_has_bits & 0x00000002u) {
+      _this->_impl_.nbits_ = from._impl_.nbits_;
+    }
+    _this->_impl_._has_bits_[0] |= cached_has_bits;
+  }
+  _this->_internal_metadata_.MergeFrom<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(from._internal_metadata_);
 }
- ::google::protobuf::RepeatedField< ::google::protobuf::uint32 >*
-tree_node::mutable_items() {
-  // @@protoc_insertion_point(field_mutable_list:tree_node.items)
-  return &items_;
+
+void pq_codebook::CopyFrom(const pq_codebook& from) {
+// @@protoc_insertion_point(class_specific_copy_from_start:pq_codebook)
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
 }
 
-// repeated float v = 6 [packed = true];
-int tree_node::v_size() const {
-  return v_.size();
+bool pq_codebook::IsInitialized() const {
+  return true;
 }
-void tree_node::clear_v() {
-  v_.Clear();
+
+void pq_codebook::InternalSwap(pq_codebook* other) {
+  using std::swap;
+  _internal_metadata_.InternalSwap(&other->_internal_metadata_);
+  swap(_impl_._has_bits_[0], other->_impl_._has_bits_[0]);
+  _impl_.centroids_.InternalSwap(&other->_impl_.centroids_);
+  ::PROTOBUF_NAMESPACE_ID::internal::memswap<
+      PROTOBUF_FIELD_OFFSET(pq_codebook, _impl_.nbits_)
+      + sizeof(pq_codebook::_impl_.nbits_)
+      - PROTOBUF_FIELD_OFFSET(pq_codebook, _impl_.m_)>(
+          reinterpret_cast<char*>(&_impl_.m_),
+          reinterpret_cast<char*>(&other->_impl_.m_));
 }
- float tree_node::v(int index) const {
-  // @@protoc_insertion_point(field_get:tree_node.v)
-  return v_.Get(index);
+
+::PROTOBUF_NAMESPACE_ID::Metadata pq_codebook::GetMetadata() const {
+  return ::_pbi::AssignDescriptors(
+      &descriptor_table_protobuf_2fannoy_2eproto_getter, &descriptor_table_protobuf_2fannoy_2eproto_once,
+      file_level_metadata_protobuf_2fannoy_2eproto[3]);
 }
- void tree_node::set_v(int index, float value) {
-  v_.Set(index, value);
-  // @@protoc_insertion_point(field_set:tree_node.v)
+
+// @@protoc_insertion_point(namespace_scope)
+PROTOBUF_NAMESPACE_OPEN
+template<> PROTOBUF_NOINLINE ::data_info*
+Arena::CreateMaybeMessage< ::data_info >(Arena* arena) {
+  return Arena::CreateMessageInternal< ::data_info >(arena);
 }
- void tree_node::add_v(float value) {
-  v_.Add(value);
-  // @@protoc_insertion_point(field_add:tree_node.v)
+template<> PROTOBUF_NOINLINE ::tree_node*
+Arena::CreateMaybeMessage< ::tree_node >(Arena* arena) {
+  return Arena::CreateMessageInternal< ::tree_node >(arena);
 }
- const ::google::protobuf::RepeatedField< float >&
-tree_node::v() const {
-  // @@protoc_insertion_point(field_list:tree_node.v)
-  return v_;
+template<> PROTOBUF_NOINLINE ::index_meta*
+Arena::CreateMaybeMessage< ::index_meta >(Arena* arena) {
+  return Arena::CreateMessageInternal< ::index_meta >(arena);
 }
- ::google::protobuf::RepeatedField< float >*
-tree_node::mutable_v() {
-  // @@protoc_insertion_point(field_mutable_list:tree_node.v)
-  return &v_;
+template<> PROTOBUF_NOINLINE ::pq_codebook*
+Arena::CreateMaybeMessage< ::pq_codebook >(Arena* arena) {
+  return Arena::CreateMessageInternal< ::pq_codebook >(arena);
 }
-
-#endif  // PROTOBUF_INLINE_NOT_IN_HEADERS
-
-// @@protoc_insertion_point(namespace_scope)
+PROTOBUF_NAMESPACE_CLOSE
 
 // @@protoc_insertion_point(global_scope)
+#include <google/protobuf/port_undef.inc>
@@ -1,522 +1,1838 @@
 // Generated by the protocol buffer compiler.  DO NOT EDIT!
 // source: protobuf/annoy.proto
 
-#ifndef PROTOBUF_protobuf_2fannoy_2eproto__INCLUDED
-#define PROTOBUF_protobuf_2fannoy_2eproto__INCLUDED
+#ifndef GOOGLE_PROTOBUF_INCLUDED_protobuf_2fannoy_2eproto
+#define GOOGLE_PROTOBUF_INCLUDED_protobuf_2fannoy_2eproto
 
+#include <limits>
 #include <string>
 
-#include <google/protobuf/stubs/common.h>
-
-#if GOOGLE_PROTOBUF_VERSION < 3000000
+#include <google/protobuf/port_def.inc>
+#if PROTOBUF_VERSION < 3021000
 #error This file was generated by a newer version of protoc which is
-#error incompatible with your Protocol Buffer headers.  Please update
+#error incompatible with your Protocol Buffer headers. Please update
 #error your headers.
 #endif
-#if 3000000 < GOOGLE_PROTOBUF_MIN_PROTOC_VERSION
+#if 3021012 < PROTOBUF_MIN_PROTOC_VERSION
 #error This file was generated by an older version of protoc which is
-#error incompatible with your Protocol Buffer headers.  Please
+#error incompatible with your Protocol Buffer headers. Please
 #error regenerate this file with a newer version of protoc.
 #endif
 
+#include <google/protobuf/port_undef.inc>
+#include <google/protobuf/io/coded_stream.h>
 #include <google/protobuf/arena.h>
 #include <google/protobuf/arenastring.h>
 #include <google/protobuf/generated_message_util.h>
-#include <google/protobuf/metadata.h>
+#include <google/protobuf/metadata_lite.h>
+#include <google/protobuf/generated_message_reflection.h>
 #include <google/protobuf/message.h>
-#include <google/protobuf/repeated_field.h>
-#include <google/protobuf/extension_set.h>
+#include <google/protobuf/repeated_field.h>  // IWYU pragma: export
+#include <google/protobuf/extension_set.h>  // IWYU pragma: export
 #include <google/protobuf/unknown_field_set.h>
 // @@protoc_insertion_point(includes)
-
-// Internal implementation detail -- do not call these.
-void protobuf_AddDesc_protobuf_2fannoy_2eproto();
-void protobuf_AssignDesc_protobuf_2fannoy_2eproto();
-void protobuf_ShutdownFile_protobuf_2fannoy_2eproto();
-
+#include <google/protobuf/port_def.inc>
+#define PROTOBUF_INTERNAL_EXPORT_protobuf_2fannoy_2eproto
+PROTOBUF_NAMESPACE_OPEN
+namespace internal {
+class AnyMetadata;
+}  // namespace internal
+PROTOBUF_NAMESPACE_CLOSE
+
+// Internal implementation detail -- do not use these members.
+struct TableStruct_protobuf_2fannoy_2eproto {
+  static const uint32_t offsets[];
+};
+extern const ::PROTOBUF_NAMESPACE_ID::internal::DescriptorTable descriptor_table_protobuf_2fannoy_2eproto;
 class data_info;
+struct data_infoDefaultTypeInternal;
+extern data_infoDefaultTypeInternal _data_info_default_instance_;
+class index_meta;
+struct index_metaDefaultTypeInternal;
+extern index_metaDefaultTypeInternal _index_meta_default_instance_;
+class pq_codebook;
+struct pq_codebookDefaultTypeInternal;
+extern pq_codebookDefaultTypeInternal _pq_codebook_default_instance_;
 class tree_node;
+struct tree_nodeDefaultTypeInternal;
+extern tree_nodeDefaultTypeInternal _tree_node_default_instance_;
+PROTOBUF_NAMESPACE_OPEN
+template<> ::data_info* Arena::CreateMaybeMessage<::data_info>(Arena*);
+template<> ::index_meta* Arena::CreateMaybeMessage<::index_meta>(Arena*);
+template<> ::pq_codebook* Arena::CreateMaybeMessage<::pq_codebook>(Arena*);
+template<> ::tree_node* Arena::CreateMaybeMessage<::tree_node>(Arena*);
+PROTOBUF_NAMESPACE_CLOSE
 
 // ===================================================================
 
-class data_info : public ::google::protobuf::Message {
+class data_info final :
+    public ::PROTOBUF_NAMESPACE_ID::Message /* @@protoc_insertion_point(class_definition:data_info) */ {
  public:
-  data_info();
-  virtual ~data_info();
+  inline data_info() : data_info(nullptr) {}
+  ~data_info() override;
+  explicit PROTOBUF_CONSTEXPR data_info(::PROTOBUF_NAMESPACE_ID::internal::ConstantInitialized);
 
   data_info(const data_info& from);
+  data_info(data_info&& from) noexcept
+    : data_info() {
+    *this = ::std::move(from);
+  }
 
   inline data_info& operator=(const data_info& from) {
     CopyFrom(from);
     return *this;
   }
-
-  inline const ::google::protobuf::UnknownFieldSet& unknown_fields() const {
-    return _internal_metadata_.unknown_fields();
+  inline data_info& operator=(data_info&& from) noexcept {
+    if (this == &from) return *this;
+    if (GetOwningArena() == from.GetOwningArena()
+  #ifdef PROTOBUF_FORCE_COPY_IN_MOVE
+        && GetOwningArena() != nullptr
+  #endif  // !PROTOBUF_FORCE_COPY_IN_MOVE
+    ) {
+      InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+    return *this;
   }
 
-  inline ::google::protobuf::UnknownFieldSet* mutable_unknown_fields() {
-    return _internal_metadata_.mutable_unknown_fields();
+  inline const ::PROTOBUF_NAMESPACE_ID::UnknownFieldSet& unknown_fields() const {
+    return _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance);
+  }
+  inline ::PROTOBUF_NAMESPACE_ID::UnknownFieldSet* mutable_unknown_fields() {
+    return _internal_metadata_.mutable_unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>();
   }
 
-  static const ::google::protobuf::Descriptor* descriptor();
-  static const data_info& default_instance();
+  static const ::PROTOBUF_NAMESPACE_ID::Descriptor* descriptor() {
+    return GetDescriptor();
+  }
+  static const ::PROTOBUF_NAMESPACE_ID::Descriptor* GetDescriptor() {
+    return default_instance().GetMetadata().descriptor;
+  }
+  static const ::PROTOBUF_NAMESPACE_ID::Reflection* GetReflection() {
+    return default_instance().GetMetadata().reflection;
+  }
+  static const data_info& default_instance() {
+    return *internal_default_instance();
+  }
+  static inline const data_info* internal_default_instance() {
+    return reinterpret_cast<const data_info*>(
+               &_data_info_default_instance_);
+  }
+  static constexpr int kIndexInFileMessages =
+    0;
 
-  void Swap(data_info* other);
+  friend void swap(data_info& a, data_info& b) {
+    a.Swap(&b);
+  }
+  inline void Swap(data_info* other) {
+    if (other == this) return;
+  #ifdef PROTOBUF_FORCE_COPY_IN_SWAP
+    if (GetOwningArena() != nullptr &&
+        GetOwningArena() == other->GetOwningArena()) {
+   #else  // PROTOBUF_FORCE_COPY_IN_SWAP
+    if (GetOwningArena() == other->GetOwningArena()) {
+  #endif  // !PROTOBUF_FORCE_COPY_IN_SWAP
+      InternalSwap(other);
+    } else {
+      ::PROTOBUF_NAMESPACE_ID::internal::GenericSwap(this, other);
+    }
+  }
+  void UnsafeArenaSwap(data_info* other) {
+    if (other == this) return;
+    GOOGLE_DCHECK(GetOwningArena() == other->GetOwningArena());
+    InternalSwap(other);
+  }
 
   // implements Message ----------------------------------------------
 
-  inline data_info* New() const { return New(NULL); }
-
-  data_info* New(::google::protobuf::Arena* arena) const;
-  void CopyFrom(const ::google::protobuf::Message& from);
-  void MergeFrom(const ::google::protobuf::Message& from);
+  data_info* New(::PROTOBUF_NAMESPACE_ID::Arena* arena = nullptr) const final {
+    return CreateMaybeMessage<data_info>(arena);
+  }
+  using ::PROTOBUF_NAMESPACE_ID::Message::CopyFrom;
   void CopyFrom(const data_info& from);
-  void MergeFrom(const data_info& from);
-  void Clear();
-  bool IsInitialized() const;
-
-  int ByteSize() const;
-  bool MergePartialFromCodedStream(
-      ::google::protobuf::io::CodedInputStream* input);
-  void SerializeWithCachedSizes(
-      ::google::protobuf::io::CodedOutputStream* output) const;
-  ::google::protobuf::uint8* SerializeWithCachedSizesToArray(::google::protobuf::uint8* output) const;
-  int GetCachedSize() const { return _cached_size_; }
-  private:
-  void SharedCtor();
+  using ::PROTOBUF_NAMESPACE_ID::Message::MergeFrom;
+  void MergeFrom( const data_info& from) {
+    data_info::MergeImpl(*this, from);
+  }
+  private:
+  static void MergeImpl(::PROTOBUF_NAMESPACE_ID::Message& to_msg, const ::PROTOBUF_NAMESPACE_ID::Message& from_msg);
+  public:
+  PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear() final;
+  bool IsInitialized() const final;
+
+  size_t ByteSizeLong() const final;
+  const char* _InternalParse(const char* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ParseContext* ctx) final;
+  uint8_t* _InternalSerialize(
+      uint8_t* target, ::PROTOBUF_NAMESPACE_ID::io::EpsCopyOutputStream* stream) const final;
+  int GetCachedSize() const final { return _impl_._cached_size_.Get(); }
+
+  private:
+  void SharedCtor(::PROTOBUF_NAMESPACE_ID::Arena* arena, bool is_message_owned);
   void SharedDtor();
-  void SetCachedSize(int size) const;
+  void SetCachedSize(int size) const final;
   void InternalSwap(data_info* other);
+
   private:
-  inline ::google::protobuf::Arena* GetArenaNoVirtual() const {
-    return _internal_metadata_.arena();
-  }
-  inline void* MaybeArenaPtr() const {
-    return _internal_metadata_.raw_arena_ptr();
+  friend class ::PROTOBUF_NAMESPACE_ID::internal::AnyMetadata;
+  static ::PROTOBUF_NAMESPACE_ID::StringPiece FullMessageName() {
+    return "data_info";
   }
+  protected:
+  explicit data_info(::PROTOBUF_NAMESPACE_ID::Arena* arena,
+                       bool is_message_owned = false);
   public:
 
-  ::google::protobuf::Metadata GetMetadata() const;
+  static const ClassData _class_data_;
+  const ::PROTOBUF_NAMESPACE_ID::Message::ClassData*GetClassData() const final;
+
+  ::PROTOBUF_NAMESPACE_ID::Metadata GetMetadata() const final;
 
   // nested types ----------------------------------------------------
 
   // accessors -------------------------------------------------------
 
+  enum : int {
+    kDataFieldNumber = 1,
+    kHdataFieldNumber = 3,
+    kIdFieldNumber = 2,
+  };
   // repeated float data = 1 [packed = true];
   int data_size() const;
+  private:
+  int _internal_data_size() const;
+  public:
   void clear_data();
-  static const int kDataFieldNumber = 1;
+  private:
+  float _internal_data(int index) const;
+  const ::PROTOBUF_NAMESPACE_ID::RepeatedField< float >&
+      _internal_data() const;
+  void _internal_add_data(float value);
+  ::PROTOBUF_NAMESPACE_ID::RepeatedField< float >*
+      _internal_mutable_data();
+  public:
   float data(int index) const;
   void set_data(int index, float value);
   void add_data(float value);
-  const ::google::protobuf::RepeatedField< float >&
+  const ::PROTOBUF_NAMESPACE_ID::RepeatedField< float >&
       data() const;
-  ::google::protobuf::RepeatedField< float >*
+  ::PROTOBUF_NAMESPACE_ID::RepeatedField< float >*
       mutable_data();
 
+  // optional bytes hdata = 3;
+  bool has_hdata() const;
+  private:
+  bool _internal_has_hdata() const;
+  public:
+  void clear_hdata();
+  const std::string& hdata() const;
+  template <typename ArgT0 = const std::string&, typename... ArgT>
+  void set_hdata(ArgT0&& arg0, ArgT... args);
+  std::string* mutable_hdata();
+  PROTOBUF_NODISCARD std::string* release_hdata();
+  void set_allocated_hdata(std::string* hdata);
+  private:
+  const std::string& _internal_hdata() const;
+  inline PROTOBUF_ALWAYS_INLINE void _internal_set_hdata(const std::string& value);
+  std::string* _internal_mutable_hdata();
+  public:
+
   // optional uint32 id = 2;
   bool has_id() const;
+  private:
+  bool _internal_has_id() const;
+  public:
   void clear_id();
-  static const int kIdFieldNumber = 2;
-  ::google::protobuf::uint32 id() const;
-  void set_id(::google::protobuf::uint32 value);
+  uint32_t id() const;
+  void set_id(uint32_t value);
+  private:
+  uint32_t _internal_id() const;
+  void _internal_set_id(uint32_t value);
+  public:
 
   // @@protoc_insertion_point(class_scope:data_info)
  private:
-  inline void set_has_id();
-  inline void clear_has_id();
-
-  ::google::protobuf::internal::InternalMetadataWithArena _internal_metadata_;
-  ::google::protobuf::uint32 _has_bits_[1];
-  mutable int _cached_size_;
-  ::google::protobuf::RepeatedField< float > data_;
-  mutable int _data_cached_byte_size_;
-  ::google::protobuf::uint32 id_;
-  friend void  protobuf_AddDesc_protobuf_2fannoy_2eproto();
-  friend void protobuf_AssignDesc_protobuf_2fannoy_2eproto();
-  friend void protobuf_ShutdownFile_protobuf_2fannoy_2eproto();
-
-  void InitAsDefaultInstance();
-  static data_info* default_instance_;
+  class _Internal;
+
+  template <typename T> friend class ::PROTOBUF_NAMESPACE_ID::Arena::InternalHelper;
+  typedef void InternalArenaConstructable_;
+  typedef void DestructorSkippable_;
+  struct Impl_ {
+    ::PROTOBUF_NAMESPACE_ID::internal::HasBits<1> _has_bits_;
+    mutable ::PROTOBUF_NAMESPACE_ID::internal::CachedSize _cached_size_;
+    ::PROTOBUF_NAMESPACE_ID::RepeatedField< float > data_;
+    ::PROTOBUF_NAMESPACE_ID::internal::ArenaStringPtr hdata_;
+    uint32_t id_;
+  };
+  union { Impl_ _impl_; };
+  friend struct ::TableStruct_protobuf_2fannoy_2eproto;
 };
 // -------------------------------------------------------------------
 
-class tree_node : public ::google::protobuf::Message {
+class tree_node final :
+    public ::PROTOBUF_NAMESPACE_ID::Message /* @@protoc_insertion_point(class_definition:tree_node) */ {
  public:
-  tree_node();
-  virtual ~tree_node();
+  inline tree_node() : tree_node(nullptr) {}
+  ~tree_node() override;
+  explicit PROTOBUF_CONSTEXPR tree_node(::PROTOBUF_NAMESPACE_ID::internal::ConstantInitialized);
 
   tree_node(const tree_node& from);
+  tree_node(tree_node&& from) noexcept
+    : tree_node() {
+    *this = ::std::move(from);
+  }
 
   inline tree_node& operator=(const tree_node& from) {
     CopyFrom(from);
     return *this;
   }
-
-  inline const ::google::protobuf::UnknownFieldSet& unknown_fields() const {
-    return _internal_metadata_.unknown_fields();
+  inline tree_node& operator=(tree_node&& from) noexcept {
+    if (this == &from) return *this;
+    if (GetOwningArena() == from.GetOwningArena()
+  #ifdef PROTOBUF_FORCE_COPY_IN_MOVE
+        && GetOwningArena() != nullptr
+  #endif  // !PROTOBUF_FORCE_COPY_IN_MOVE
+    ) {
+      InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+    return *this;
   }
 
-  inline ::google::protobuf::UnknownFieldSet* mutable_unknown_fields() {
-    return _internal_metadata_.mutable_unknown_fields();
+  inline const ::PROTOBUF_NAMESPACE_ID::UnknownFieldSet& unknown_fields() const {
+    return _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance);
+  }
+  inline ::PROTOBUF_NAMESPACE_ID::UnknownFieldSet* mutable_unknown_fields() {
+    return _internal_metadata_.mutable_unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>();
   }
 
-  static const ::google::protobuf::Descriptor* descriptor();
-  static const tree_node& default_instance();
+  static const ::PROTOBUF_NAMESPACE_ID::Descriptor* descriptor() {
+    return GetDescriptor();
+  }
+  static const ::PROTOBUF_NAMESPACE_ID::Descriptor* GetDescriptor() {
+    return default_instance().GetMetadata().descriptor;
+  }
+  static const ::PROTOBUF_NAMESPACE_ID::Reflection* GetReflection() {
+    return default_instance().GetMetadata().reflection;
+  }
+  static const tree_node& default_instance() {
+    return *internal_default_instance();
+  }
+  static inline const tree_node* internal_default_instance() {
+    return reinterpret_cast<const tree_node*>(
+               &_tree_node_default_instance_);
+  }
+  static constexpr int kIndexInFileMessages =
+    1;
 
-  void Swap(tree_node* other);
+  friend void swap(tree_node& a, tree_node& b) {
+    a.Swap(&b);
+  }
+  inline void Swap(tree_node* other) {
+    if (other == this) return;
+  #ifdef PROTOBUF_FORCE_COPY_IN_SWAP
+    if (GetOwningArena() != nullptr &&
+        GetOwningArena() == other->GetOwningArena()) {
+   #else  // PROTOBUF_FORCE_COPY_IN_SWAP
+    if (GetOwningArena() == other->GetOwningArena()) {
+  #endif  // !PROTOBUF_FORCE_COPY_IN_SWAP
+      InternalSwap(other);
+    } else {
+      ::PROTOBUF_NAMESPACE_ID::internal::GenericSwap(this, other);
+    }
+  }
+  void UnsafeArenaSwap(tree_node* other) {
+    if (other == this) return;
+    GOOGLE_DCHECK(GetOwningArena() == other->GetOwningArena());
+    InternalSwap(other);
+  }
 
   // implements Message ----------------------------------------------
 
-  inline tree_node* New() const { return New(NULL); }
-
-  tree_node* New(::google::protobuf::Arena* arena) const;
-  void CopyFrom(const ::google::protobuf::Message& from);
-  void MergeFrom(const ::google::protobuf::Message& from);
+  tree_node* New(::PROTOBUF_NAMESPACE_ID::Arena* arena = nullptr) const final {
+    return CreateMaybeMessage<tree_node>(arena);
+  }
+  using ::PROTOBUF_NAMESPACE_ID::Message::CopyFrom;
   void CopyFrom(const tree_node& from);
-  void MergeFrom(const tree_node& from);
-  void Clear();
-  bool IsInitialized() const;
-
-  int ByteSize() const;
-  bool MergePartialFromCodedStream(
-      ::google::protobuf::io::CodedInputStream* input);
-  void SerializeWithCachedSizes(
-      ::google::protobuf::io::CodedOutputStream* output) const;
-  ::google::protobuf::uint8* SerializeWithCachedSizesToArray(::google::protobuf::uint8* output) const;
-  int GetCachedSize() const { return _cached_size_; }
-  private:
-  void SharedCtor();
+  using ::PROTOBUF_NAMESPACE_ID::Message::MergeFrom;
+  void MergeFrom( const tree_node& from) {
+    tree_node::MergeImpl(*this, from);
+  }
+  private:
+  static void MergeImpl(::PROTOBUF_NAMESPACE_ID::Message& to_msg, const ::PROTOBUF_NAMESPACE_ID::Message& from_msg);
+  public:
+  PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear() final;
+  bool IsInitialized() const final;
+
+  size_t ByteSizeLong() const final;
+  const char* _InternalParse(const char* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ParseContext* ctx) final;
+  uint8_t* _InternalSerialize(
+      uint8_t* target, ::PROTOBUF_NAMESPACE_ID::io::EpsCopyOutputStream* stream) const final;
+  int GetCachedSize() const final { return _impl_._cached_size_.Get(); }
+
+  private:
+  void SharedCtor(::PROTOBUF_NAMESPACE_ID::Arena* arena, bool is_message_owned);
   void SharedDtor();
-  void SetCachedSize(int size) const;
+  void SetCachedSize(int size) const final;
   void InternalSwap(tree_node* other);
+
   private:
-  inline ::google::protobuf::Arena* GetArenaNoVirtual() const {
-    return _internal_metadata_.arena();
-  }
-  inline void* MaybeArenaPtr() const {
-    return _internal_metadata_.raw_arena_ptr();
+  friend class ::PROTOBUF_NAMESPACE_ID::internal::AnyMetadata;
+  static ::PROTOBUF_NAMESPACE_ID::StringPiece FullMessageName() {
+    return "tree_node";
   }
+  protected:
+  explicit tree_node(::PROTOBUF_NAMESPACE_ID::Arena* arena,
+                       bool is_message_owned = false);
   public:
 
-  ::google::protobuf::Metadata GetMetadata() const;
+  static const ClassData _class_data_;
+  const ::PROTOBUF_NAMESPACE_ID::Message::ClassData*GetClassData() const final;
+
+  ::PROTOBUF_NAMESPACE_ID::Metadata GetMetadata() const final;
 
   // nested types ----------------------------------------------------
 
   // accessors -------------------------------------------------------
 
+  enum : int {
+    kItemsFieldNumber = 5,
+    kVFieldNumber = 6,
+    kHvFieldNumber = 7,
+    kLeafDataFieldNumber = 8,
+    kIndexFieldNumber = 1,
+    kLeafFieldNumber = 2,
+    kLeftFieldNumber = 3,
+    kRightFieldNumber = 4,
+  };
+  // repeated uint32 items = 5;
+  int items_size() const;
+  private:
+  int _internal_items_size() const;
+  public:
+  void clear_items();
+  private:
+  uint32_t _internal_items(int index) const;
+  const ::PROTOBUF_NAMESPACE_ID::RepeatedField< uint32_t >&
+      _internal_items() const;
+  void _internal_add_items(uint32_t value);
+  ::PROTOBUF_NAMESPACE_ID::RepeatedField< uint32_t >*
+      _internal_mutable_items();
+  public:
+  uint32_t items(int index) const;
+  void set_items(int index, uint32_t value);
+  void add_items(uint32_t value);
+  const ::PROTOBUF_NAMESPACE_ID::RepeatedField< uint32_t >&
+      items() const;
+  ::PROTOBUF_NAMESPACE_ID::RepeatedField< uint32_t >*
+      mutable_items();
+
+  // repeated float v = 6 [packed = true];
+  int v_size() const;
+  private:
+  int _internal_v_size() const;
+  public:
+  void clear_v();
+  private:
+  float _internal_v(int index) const;
+  const ::PROTOBUF_NAMESPACE_ID::RepeatedField< float >&
+      _internal_v() const;
+  void _internal_add_v(float value);
+  ::PROTOBUF_NAMESPACE_ID::RepeatedField< float >*
+      _internal_mutable_v();
+  public:
+  float v(int index) const;
+  void set_v(int index, float value);
+  void add_v(float value);
+  const ::PROTOBUF_NAMESPACE_ID::RepeatedField< float >&
+      v() const;
+  ::PROTOBUF_NAMESPACE_ID::RepeatedField< float >*
+      mutable_v();
+
+  // optional bytes hv = 7;
+  bool has_hv() const;
+  private:
+  bool _internal_has_hv() const;
+  public:
+  void clear_hv();
+  const std::string& hv() const;
+  template <typename ArgT0 = const std::string&, typename... ArgT>
+  void set_hv(ArgT0&& arg0, ArgT... args);
+  std::string* mutable_hv();
+  PROTOBUF_NODISCARD std::string* release_hv();
+  void set_allocated_hv(std::string* hv);
+  private:
+  const std::string& _internal_hv() const;
+  inline PROTOBUF_ALWAYS_INLINE void _internal_set_hv(const std::string& value);
+  std::string* _internal_mutable_hv();
+  public:
+
+  // optional bytes leaf_data = 8;
+  bool has_leaf_data() const;
+  private:
+  bool _internal_has_leaf_data() const;
+  public:
+  void clear_leaf_data();
+  const std::string& leaf_data() const;
+  template <typename ArgT0 = const std::string&, typename... ArgT>
+  void set_leaf_data(ArgT0&& arg0, ArgT... args);
+  std::string* mutable_leaf_data();
+  PROTOBUF_NODISCARD std::string* release_leaf_data();
+  void set_allocated_leaf_data(std::string* leaf_data);
+  private:
+  const std::string& _internal_leaf_data() const;
+  inline PROTOBUF_ALWAYS_INLINE void _internal_set_leaf_data(const std::string& value);
+  std::string* _internal_mutable_leaf_data();
+  public:
+
   // required uint32 index = 1;
   bool has_index() const;
+  private:
+  bool _internal_has_index() const;
+  public:
   void clear_index();
-  static const int kIndexFieldNumber = 1;
-  ::google::protobuf::uint32 index() const;
-  void set_index(::google::protobuf::uint32 value);
+  uint32_t index() const;
+  void set_index(uint32_t value);
+  private:
+  uint32_t _internal_index() const;
+  void _internal_set_index(uint32_t value);
+  public:
 
   // required bool leaf = 2;
   bool has_leaf() const;
+  private:
+  bool _internal_has_leaf() const;
+  public:
   void clear_leaf();
-  static const int kLeafFieldNumber = 2;
   bool leaf() const;
   void set_leaf(bool value);
+  private:
+  bool _internal_leaf() const;
+  void _internal_set_leaf(bool value);
+  public:
 
   // optional uint32 left = 3;
   bool has_left() const;
+  private:
+  bool _internal_has_left() const;
+  public:
   void clear_left();
-  static const int kLeftFieldNumber = 3;
-  ::google::protobuf::uint32 left() const;
-  void set_left(::google::protobuf::uint32 value);
+  uint32_t left() const;
+  void set_left(uint32_t value);
+  private:
+  uint32_t _internal_left() const;
+  void _internal_set_left(uint32_t value);
+  public:
 
   // optional uint32 right = 4;
   bool has_right() const;
+  private:
+  bool _internal_has_right() const;
+  public:
   void clear_right();
-  static const int kRightFieldNumber = 4;
-  ::google::protobuf::uint32 right() const;
-  void set_right(::google::protobuf::uint32 value);
+  uint32_t right() const;
+  void set_right(uint32_t value);
+  private:
+  uint32_t _internal_right() const;
+  void _internal_set_right(uint32_t value);
+  public:
 
-  // repeated uint32 items = 5;
-  int items_size() const;
-  void clear_items();
-  static const int kItemsFieldNumber = 5;
-  ::google::protobuf::uint32 items(int index) const;
-  void set_items(int index, ::google::protobuf::uint32 value);
-  void add_items(::google::protobuf::uint32 value);
-  const ::google::protobuf::RepeatedField< ::google::protobuf::uint32 >&
-      items() const;
-  ::google::protobuf::RepeatedField< ::google::protobuf::uint32 >*
-      mutable_items();
+  // @@protoc_insertion_point(class_scope:tree_node)
+ private:
+  class _Internal;
+
+  // helper for ByteSizeLong()
+  size_t RequiredFieldsByteSizeFallback() const;
+
+  template <typename T> friend class ::PROTOBUF_NAMESPACE_ID::Arena::InternalHelper;
+  typedef void InternalArenaConstructable_;
+  typedef void DestructorSkippable_;
+  struct Impl_ {
+    ::PROTOBUF_NAMESPACE_ID::internal::HasBits<1> _has_bits_;
+    mutable ::PROTOBUF_NAMESPACE_ID::internal::CachedSize _cached_size_;
+    ::PROTOBUF_NAMESPACE_ID::RepeatedField< uint32_t > items_;
+    ::PROTOBUF_NAMESPACE_ID::RepeatedField< float > v_;
+    ::PROTOBUF_NAMESPACE_ID::internal::ArenaStringPtr hv_;
+    ::PROTOBUF_NAMESPACE_ID::internal::ArenaStringPtr leaf_data_;
+    uint32_t index_;
+    bool leaf_;
+    uint32_t left_;
+    uint32_t right_;
+  };
+  union { Impl_ _impl_; };
+  friend struct ::TableStruct_protobuf_2fannoy_2eproto;
+};
+// -------------------------------------------------------------------
 
-  // repeated float v = 6 [packed = true];
-  int v_size() const;
-  void clear_v();
-  static const int kVFieldNumber = 6;
-  float v(int index) const;
-  void set_v(int index, float value);
-  void add_v(float value);
-  const ::google::protobuf::RepeatedField< float >&
-      v() const;
-  ::google::protobuf::RepeatedField< float >*
-      mutable_v();
+class index_meta final :
+    public ::PROTOBUF_NAMESPACE_ID::Message /* @@protoc_insertion_point(class_definition:index_meta) */ {
+ public:
+  inline index_meta() : index_meta(nullptr) {}
+  ~index_meta() override;
+  explicit PROTOBUF_CONSTEXPR index_meta(::PROTOBUF_NAMESPACE_ID::internal::ConstantInitialized);
+
+  index_meta(const index_meta& from);
+  index_meta(index_meta&& from) noexcept
+    : index_meta() {
+    *this = ::std::move(from);
+  }
 
-  // @@protoc_insertion_point(class_scope:tree_node)
+  inline index_meta& operator=(const index_meta& from) {
+    CopyFrom(from);
+    return *this;
+  }
+  inline index_meta& operator=(index_meta&& from) noexcept {
+    if (this == &from) return *this;
+    if (GetOwningArena() == from.GetOwningArena()
+  #ifdef PROTOBUF_FORCE_COPY_IN_MOVE
+        && GetOwningArena() != nullptr
+  #endif  // !PROTOBUF_FORCE_COPY_IN_MOVE
+    ) {
+      InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+    return *this;
+  }
+
+  inline const ::PROTOBUF_NAMESPACE_ID::UnknownFieldSet& unknown_fields() const {
+    return _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance);
+  }
+  inline ::PROTOBUF_NAMESPACE_ID::UnknownFieldSet* mutable_unknown_fields() {
+    return _internal_metadata_.mutable_unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>();
+  }
+
+  static const ::PROTOBUF_NAMESPACE_ID::Descriptor* descriptor() {
+    return GetDescriptor();
+  }
+  static const ::PROTOBUF_NAMESPACE_ID::Descriptor* GetDescriptor() {
+    return default_instance().GetMetadata().descriptor;
+  }
+  static const ::PROTOBUF_NAMESPACE_ID::Reflection* GetReflection() {
+    return default_instance().GetMetadata().reflection;
+  }
+  static const index_meta& default_instance() {
+    return *internal_default_instance();
+  }
+  static inline const index_meta* internal_default_instance() {
+    return reinterpret_cast<const index_meta*>(
+               &_index_meta_default_instance_);
+  }
+  static constexpr int kIndexInFileMessages =
+    2;
+
+  friend void swap(index_meta& a, index_meta& b) {
+    a.Swap(&b);
+  }
+  inline void Swap(index_meta* other) {
+    if (other == this) return;
+  #ifdef PROTOBUF_FORCE_COPY_IN_SWAP
+    if (GetOwningArena() != nullptr &&
+        GetOwningArena() == other->GetOwningArena()) {
+   #else  // PROTOBUF_FORCE_COPY_IN_SWAP
+    if (GetOwningArena() == other->GetOwningArena()) {
+  #endif  // !PROTOBUF_FORCE_COPY_IN_SWAP
+      InternalSwap(other);
+    } else {
+      ::PROTOBUF_NAMESPACE_ID::internal::GenericSwap(this, other);
+    }
+  }
+  void UnsafeArenaSwap(index_meta* other) {
+    if (other == this) return;
+    GOOGLE_DCHECK(GetOwningArena() == other->GetOwningArena());
+    InternalSwap(other);
+  }
+
+  // implements Message ----------------------------------------------
+
+  index_meta* New(::PROTOBUF_NAMESPACE_ID::Arena* arena = nullptr) const final {
+    return CreateMaybeMessage<index_meta>(arena);
+  }
+  using ::PROTOBUF_NAMESPACE_ID::Message::CopyFrom;
+  void CopyFrom(const index_meta& from);
+  using ::PROTOBUF_NAMESPACE_ID::Message::MergeFrom;
+  void MergeFrom( const index_meta& from) {
+    index_meta::MergeImpl(*this, from);
+  }
+  private:
+  static void MergeImpl(::PROTOBUF_NAMESPACE_ID::Message& to_msg, const ::PROTOBUF_NAMESPACE_ID::Message& from_msg);
+  public:
+  PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear() final;
+  bool IsInitialized() const final;
+
+  size_t ByteSizeLong() const final;
+  const char* _InternalParse(const char* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ParseContext* ctx) final;
+  uint8_t* _InternalSerialize(
+      uint8_t* target, ::PROTOBUF_NAMESPACE_ID::io::EpsCopyOutputStream* stream) const final;
+  int GetCachedSize() const final { return _impl_._cached_size_.Get(); }
+
+  private:
+  void SharedCtor(::PROTOBUF_NAMESPACE_ID::Arena* arena, bool is_message_owned);
+  void SharedDtor();
+  void SetCachedSize(int size) const final;
+  void InternalSwap(index_meta* other);
+
+  private:
+  friend class ::PROTOBUF_NAMESPACE_ID::internal::AnyMetadata;
+  static ::PROTOBUF_NAMESPACE_ID::StringPiece FullMessageName() {
+    return "index_meta";
+  }
+  protected:
+  explicit index_meta(::PROTOBUF_NAMESPACE_ID::Arena* arena,
+                       bool is_message_owned = false);
+  public:
+
+  static const ClassData _class_data_;
+  const ::PROTOBUF_NAMESPACE_ID::Message::ClassData*GetClassData() const final;
+
+  ::PROTOBUF_NAMESPACE_ID::Metadata GetMetadata() const final;
+
+  // nested types ----------------------------------------------------
+
+  // accessors -------------------------------------------------------
+
+  enum : int {
+    kCodecFieldNumber = 1,
+    kVectorTypeFieldNumber = 2,
+    kLeafEmbedTreesFieldNumber = 3,
+    kLeafPageSizeFieldNumber = 4,
+    kLeafCapacityFieldNumber = 5,
+    kTreeDbsFieldNumber = 6,
+    kSeedFieldNumber = 7,
+  };
+  // optional uint32 codec = 1;
+  bool has_codec() const;
+  private:
+  bool _internal_has_codec() const;
+  public:
+  void clear_codec();
+  uint32_t codec() const;
+  void set_codec(uint32_t value);
+  private:
+  uint32_t _internal_codec() const;
+  void _internal_set_codec(uint32_t value);
+  public:
+
+  // optional uint32 vector_type = 2;
+  bool has_vector_type() const;
+  private:
+  bool _internal_has_vector_type() const;
+  public:
+  void clear_vector_type();
+  uint32_t vector_type() const;
+  void set_vector_type(uint32_t value);
+  private:
+  uint32_t _internal_vector_type() const;
+  void _internal_set_vector_type(uint32_t value);
+  public:
+
+  // optional uint32 leaf_embed_trees = 3;
+  bool has_leaf_embed_trees() const;
+  private:
+  bool _internal_has_leaf_embed_trees() const;
+  public:
+  void clear_leaf_embed_trees();
+  uint32_t leaf_embed_trees() const;
+  void set_leaf_embed_trees(uint32_t value);
+  private:
+  uint32_t _internal_leaf_embed_trees() const;
+  void _internal_set_leaf_embed_trees(uint32_t value);
+  public:
+
+  // optional uint32 leaf_page_size = 4;
+  bool has_leaf_page_size() const;
+  private:
+  bool _internal_has_leaf_page_size() const;
+  public:
+  void clear_leaf_page_size();
+  uint32_t leaf_page_size() const;
+  void set_leaf_page_size(uint32_t value);
+  private:
+  uint32_t _internal_leaf_page_size() const;
+  void _internal_set_leaf_page_size(uint32_t value);
+  public:
+
+  // optional uint32 leaf_capacity = 5;
+  bool has_leaf_capacity() const;
+  private:
+  bool _internal_has_leaf_capacity() const;
+  public:
+  void clear_leaf_capacity();
+  uint32_t leaf_capacity() const;
+  void set_leaf_capacity(uint32_t value);
+  private:
+  uint32_t _internal_leaf_capacity() const;
+  void _internal_set_leaf_capacity(uint32_t value);
+  public:
+
+  // optional bool tree_dbs = 6;
+  bool has_tree_dbs() const;
+  private:
+  bool _internal_has_tree_dbs() const;
+  public:
+  void clear_tree_dbs();
+  bool tree_dbs() const;
+  void set_tree_dbs(bool value);
+  private:
+  bool _internal_tree_dbs() const;
+  void _internal_set_tree_dbs(bool value);
+  public:
+
+  // optional uint64 seed = 7;
+  bool has_seed() const;
+  private:
+  bool _internal_has_seed() const;
+  public:
+  void clear_seed();
+  uint64_t seed() const;
+  void set_seed(uint64_t value);
+  private:
+  uint64_t _internal_seed() const;
+  void _internal_set_seed(uint64_t value);
+  public:
+
+  // @@protoc_insertion_point(class_scope:index_meta)
+ private:
+  class _Internal;
+
+  template <typename T> friend class ::PROTOBUF_NAMESPACE_ID::Arena::InternalHelper;
+  typedef void InternalArenaConstructable_;
+  typedef void DestructorSkippable_;
+  struct Impl_ {
+    ::PROTOBUF_NAMESPACE_ID::internal::HasBits<1> _has_bits_;
+    mutable ::PROTOBUF_NAMESPACE_ID::internal::CachedSize _cached_size_;
+    uint32_t codec_;
+    uint32_t vector_type_;
+    uint32_t leaf_embed_trees_;
+    uint32_t leaf_page_size_;
+    uint32_t leaf_capacity_;
+    bool tree_dbs_;
+    uint64_t seed_;
+  };
+  union { Impl_ _impl_; };
+  friend struct ::TableStruct_protobuf_2fannoy_2eproto;
+};
+// -------------------------------------------------------------------
+
+class pq_codebook final :
+    public ::PROTOBUF_NAMESPACE_ID::Message /* @@protoc_insertion_point(class_definition:pq_codebook) */ {
+ public:
+  inline pq_codebook() : pq_codebook(nullptr) {}
+  ~pq_codebook() override;
+  explicit PROTOBUF_CONSTEXPR pq_codebook(::PROTOBUF_NAMESPACE_ID::internal::ConstantInitialized);
+
+  pq_codebook(const pq_codebook& from);
+  pq_codebook(pq_codebook&& from) noexcept
+    : pq_codebook() {
+    *this = ::std::move(from);
+  }
+
+  inline pq_codebook& operator=(const pq_codebook& from) {
+    CopyFrom(from);
+    return *this;
+  }
+  inline pq_codebook& operator=(pq_codebook&& from) noexcept {
+    if (this == &from) return *this;
+    if (GetOwningArena() == from.GetOwningArena()
+  #ifdef PROTOBUF_FORCE_COPY_IN_MOVE
+        && GetOwningArena() != nullptr
+  #endif  // !PROTOBUF_FORCE_COPY_IN_MOVE
+    ) {
+      InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+    return *this;
+  }
+
+  inline const ::PROTOBUF_NAMESPACE_ID::UnknownFieldSet& unknown_fields() const {
+    return _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance);
+  }
+  inline ::PROTOBUF_NAMESPACE_ID::UnknownFieldSet* mutable_unknown_fields() {
+    return _internal_metadata_.mutable_unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>();
+  }
+
+  static const ::PROTOBUF_NAMESPACE_ID::Descriptor* descriptor() {
+    return GetDescriptor();
+  }
+  static const ::PROTOBUF_NAMESPACE_ID::Descriptor* GetDescriptor() {
+    return default_instance().GetMetadata().descriptor;
+  }
+  static const ::PROTOBUF_NAMESPACE_ID::Reflection* GetReflection() {
+    return default_instance().GetMetadata().reflection;
+  }
+  static const pq_codebook& default_instance() {
+    return *internal_default_instance();
+  }
+  static inline const pq_codebook* internal_default_instance() {
+    return reinterpret_cast<const pq_codebook*>(
+               &_pq_codebook_default_instance_);
+  }
+  static constexpr int kIndexInFileMessages =
+    3;
+
+  friend void swap(pq_codebook& a, pq_codebook& b) {
+    a.Swap(&b);
+  }
+  inline void Swap(pq_codebook* other) {
+    if (other == this) return;
+  #ifdef PROTOBUF_FORCE_COPY_IN_SWAP
+    if (GetOwningArena() != nullptr &&
+        GetOwningArena() == other->GetOwningArena()) {
+   #else  // PROTOBUF_FORCE_COPY_IN_SWAP
+    if (GetOwningArena() == other->GetOwningArena()) {
+  #endif  // !PROTOBUF_FORCE_COPY_IN_SWAP
+      InternalSwap(other);
+    } else {
+      ::PROTOBUF_NAMESPACE_ID::internal::GenericSwap(this, other);
+    }
+  }
+  void UnsafeArenaSwap(pq_codebook* other) {
+    if (other == this) return;
+    GOOGLE_DCHECK(GetOwningArena() == other->GetOwningArena());
+    InternalSwap(other);
+  }
+
+  // implements Message ----------------------------------------------
+
+  pq_codebook* New(::PROTOBUF_NAMESPACE_ID::Arena* arena = nullptr) const final {
+    return CreateMaybeMessage<pq_codebook>(arena);
+  }
+  using ::PROTOBUF_NAMESPACE_ID::Message::CopyFrom;
+  void CopyFrom(const pq_codebook& from);
+  using ::PROTOBUF_NAMESPACE_ID::Message::MergeFrom;
+  void MergeFrom( const pq_codebook& from) {
+    pq_codebook::MergeImpl(*this, from);
+  }
+  private:
+  static void MergeImpl(::PROTOBUF_NAMESPACE_ID::Message& to_msg, const ::PROTOBUF_NAMESPACE_ID::Message& from_msg);
+  public:
+  PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear() final;
+  bool IsInitialized() const final;
+
+  size_t ByteSizeLong() const final;
+  const char* _InternalParse(const char* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ParseContext* ctx) final;
+  uint8_t* _InternalSerialize(
+      uint8_t* target, ::PROTOBUF_NAMESPACE_ID::io::EpsCopyOutputStream* stream) const final;
+  int GetCachedSize() const final { return _impl_._cached_size_.Get(); }
+
+  private:
+  void SharedCtor(::PROTOBUF_NAMESPACE_ID::Arena* arena, bool is_message_owned);
+  void SharedDtor();
+  void SetCachedSize(int size) const final;
+  void InternalSwap(pq_codebook* other);
+
+  private:
+  friend class ::PROTOBUF_NAMESPACE_ID::internal::AnyMetadata;
+  static ::PROTOBUF_NAMESPACE_ID::StringPiece FullMessageName() {
+    return "pq_codebook";
+  }
+  protected:
+  explicit pq_codebook(::PROTOBUF_NAMESPACE_ID::Arena* arena,
+                       bool is_message_owned = false);
+  public:
+
+  static const ClassData _class_data_;
+  const ::PROTOBUF_NAMESPACE_ID::Message::ClassData*GetClassData() const final;
+
+  ::PROTOBUF_NAMESPACE_ID::Metadata GetMetadata() const final;
+
+  // nested types ----------------------------------------------------
+
+  // accessors -------------------------------------------------------
+
+  enum : int {
+    kCentroidsFieldNumber = 3,
+    kMFieldNumber = 1,
+    kNbitsFieldNumber = 2,
+  };
+  // repeated float centroids = 3 [packed = true];
+  int centroids_size() const;
+  private:
+  int _internal_centroids_size() const;
+  public:
+  void clear_centroids();
+  private:
+  float _internal_centroids(int index) const;
+  const ::PROTOBUF_NAMESPACE_ID::RepeatedField< float >&
+      _internal_centroids() const;
+  void _internal_add_centroids(float value);
+  ::PROTOBUF_NAMESPACE_ID::RepeatedField< float >*
+      _internal_mutable_centroids();
+  public:
+  float centroids(int index) const;
+  void set_centroids(int index, float value);
+  void add_centroids(float value);
+  const ::PROTOBUF_NAMESPACE_ID::RepeatedField< float >&
+      centroids() const;
+  ::PROTOBUF_NAMESPACE_ID::RepeatedField< float >*
+      mutable_centroids();
+
+  // optional uint32 m = 1;
+  bool has_m() const;
+  private:
+  bool _internal_has_m() const;
+  public:
+  void clear_m();
+  uint32_t m() const;
+  void set_m(uint32_t value);
+  private:
+  uint32_t _internal_m() const;
+  void _internal_set_m(uint32_t value);
+  public:
+
+  // optional uint32 nbits = 2;
+  bool has_nbits() const;
+  private:
+  bool _internal_has_nbits() const;
+  public:
+  void clear_nbits();
+  uint32_t nbits() const;
+  void set_nbits(uint32_t value);
+  private:
+  uint32_t _internal_nbits() const;
+  void _internal_set_nbits(uint32_t value);
+  public:
+
+  // @@protoc_insertion_point(class_scope:pq_codebook)
  private:
-  inline void set_has_index();
-  inline void clear_has_index();
-  inline void set_has_leaf();
-  inline void clear_has_leaf();
-  inline void set_has_left();
-  inline void clear_has_left();
-  inline void set_has_right();
-  inline void clear_has_right();
-
-  // helper for ByteSize()
-  int RequiredFieldsByteSizeFallback() const;
-
-  ::google::protobuf::internal::InternalMetadataWithArena _internal_metadata_;
-  ::google::protobuf::uint32 _has_bits_[1];
-  mutable int _cached_size_;
-  ::google::protobuf::uint32 index_;
-  bool leaf_;
-  ::google::protobuf::uint32 left_;
-  ::google::protobuf::uint32 right_;
-  ::google::protobuf::RepeatedField< ::google::protobuf::uint32 > items_;
-  ::google::protobuf::RepeatedField< float > v_;
-  mutable int _v_cached_byte_size_;
-  friend void  protobuf_AddDesc_protobuf_2fannoy_2eproto();
-  friend void protobuf_AssignDesc_protobuf_2fannoy_2eproto();
-  friend void protobuf_ShutdownFile_protobuf_2fannoy_2eproto();
-
-  void InitAsDefaultInstance();
-  static tree_node* default_instance_;
+  class _Internal;
+
+  template <typename T> friend class ::PROTOBUF_NAMESPACE_ID::Arena::InternalHelper;
+  typedef void InternalArenaConstructable_;
+  typedef void DestructorSkippable_;
+  struct Impl_ {
+    ::PROTOBUF_NAMESPACE_ID::internal::HasBits<1> _has_bits_;
+    mutable ::PROTOBUF_NAMESPACE_ID::internal::CachedSize _cached_size_;
+    ::PROTOBUF_NAMESPACE_ID::RepeatedField< float > centroids_;
+    uint32_t m_;
+    uint32_t nbits_;
+  };
+  union { Impl_ _impl_; };
+  friend struct ::TableStruct_protobuf_2fannoy_2eproto;
 };
 // ===================================================================
 
 
 // ===================================================================
 
-#if !PROTOBUF_INLINE_NOT_IN_HEADERS
+#ifdef __GNUC__
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wstrict-aliasing"
+#endif  // __GNUC__
 // data_info
 
 // repeated float data = 1 [packed = true];
+inline int data_info::_internal_data_size() const {
+  return _impl_.data_.size();
+}
 inline int data_info::data_size() const {
-  return data_.size();
+  return _internal_data_size();
 }
 inline void data_info::clear_data() {
-  data_.Clear();
+  _impl_.data_.Clear();
+}
+inline float data_info::_internal_data(int index) const {
+  return _impl_.data_.Get(index);
 }
 inline float data_info::data(int index) const {
   // @@protoc_insertion_point(field_get:data_info.data)
-  return data_.Get(index);
+  return _internal_data(index);
 }
 inline void data_info::set_data(int index, float value) {
-  data_.Set(index, value);
+  _impl_.data_.Set(index, value);
   // @@protoc_insertion_point(field_set:data_info.data)
 }
+inline void data_info::_internal_add_data(float value) {
+  _impl_.data_.Add(value);
+}
 inline void data_info::add_data(float value) {
-  data_.Add(value);
+  _internal_add_data(value);
   // @@protoc_insertion_point(field_add:data_info.data)
 }
-inline const ::google::protobuf::RepeatedField< float >&
+inline const ::PROTOBUF_NAMESPACE_ID::RepeatedField< float >&
+data_info::_internal_data() const {
+  return _impl_.data_;
+}
+inline const ::PROTOBUF_NAMESPACE_ID::RepeatedField< float >&
 data_info::data() const {
   // @@protoc_insertion_point(field_list:data_info.data)
-  return data_;
+  return _internal_data();
+}
+inline ::PROTOBUF_NAMESPACE_ID::RepeatedField< float >*
+data_info::_internal_mutable_data() {
+  return &_impl_.data_;
 }
-inline ::google::protobuf::RepeatedField< float >*
+inline ::PROTOBUF_NAMESPACE_ID::RepeatedField< float >*
 data_info::mutable_data() {
   // @@protoc_insertion_point(field_mutable_list:data_info.data)
-  return &data_;
+  return _internal_mutable_data();
 }
 
 // optional uint32 id = 2;
-inline bool data_info::has_id() const {
-  return (_has_bits_[0] & 0x00000002u) != 0;
-}
-inline void data_info::set_has_id() {
-  _has_bits_[0] |= 0x00000002u;
+inline bool data_info::_internal_has_id() const {
+  bool value = (_impl_._has_bits_[0] & 0x00000002u) != 0;
+  return value;
 }
-inline void data_info::clear_has_id() {
-  _has_bits_[0] &= ~0x00000002u;
+inline bool data_info::has_id() const {
+  return _internal_has_id();
 }
 inline void data_info::clear_id() {
-  id_ = 0u;
-  clear_has_id();
+  _impl_.id_ = 0u;
+  _impl_._has_bits_[0] &= ~0x00000002u;
 }
-inline ::google::protobuf::uint32 data_info::id() const {
+inline uint32_t data_info::_internal_id() const {
+  return _impl_.id_;
+}
+inline uint32_t data_info::id() const {
   // @@protoc_insertion_point(field_get:data_info.id)
-  return id_;
+  return _internal_id();
+}
+inline void data_info::_internal_set_id(uint32_t value) {
+  _impl_._has_bits_[0] |= 0x00000002u;
+  _impl_.id_ = value;
 }
-inline void data_info::set_id(::google::protobuf::uint32 value) {
-  set_has_id();
-  id_ = value;
+inline void data_info::set_id(uint32_t value) {
+  _internal_set_id(value);
   // @@protoc_insertion_point(field_set:data_info.id)
 }
 
+// optional bytes hdata = 3;
+inline bool data_info::_internal_has_hdata() const {
+  bool value = (_impl_._has_bits_[0] & 0x00000001u) != 0;
+  return value;
+}
+inline bool data_info::has_hdata() const {
+  return _internal_has_hdata();
+}
+inline void data_info::clear_hdata() {
+  _impl_.hdata_.ClearToEmpty();
+  _impl_._has_bits_[0] &= ~0x00000001u;
+}
+inline const std::string& data_info::hdata() const {
+  // @@protoc_insertion_point(field_get:data_info.hdata)
+  return _internal_hdata();
+}
+template <typename ArgT0, typename... ArgT>
+inline PROTOBUF_ALWAYS_INLINE
+void data_info::set_hdata(ArgT0&& arg0, ArgT... args) {
+ _impl_._has_bits_[0] |= 0x00000001u;
+ _impl_.hdata_.SetBytes(static_cast<ArgT0 &&>(arg0), args..., GetArenaForAllocation());
+  // @@protoc_insertion_point(field_set:data_info.hdata)
+}
+inline std::string* data_info::mutable_hdata() {
+  std::string* _s = _internal_mutable_hdata();
+  // @@protoc_insertion_point(field_mutable:data_info.hdata)
+  return _s;
+}
+inline const std::string& data_info::_internal_hdata() const {
+  return _impl_.hdata_.Get();
+}
+inline void data_info::_internal_set_hdata(const std::string& value) {
+  _impl_._has_bits_[0] |= 0x00000001u;
+  _impl_.hdata_.Set(value, GetArenaForAllocation());
+}
+inline std::string* data_info::_internal_mutable_hdata() {
+  _impl_._has_bits_[0] |= 0x00000001u;
+  return _impl_.hdata_.Mutable(GetArenaForAllocation());
+}
+inline std::string* data_info::release_hdata() {
+  // @@protoc_insertion_point(field_release:data_info.hdata)
+  if (!_internal_has_hdata()) {
+    return nullptr;
+  }
+  _impl_._has_bits_[0] &= ~0x00000001u;
+  auto* p = _impl_.hdata_.Release();
+#ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  if (_impl_.hdata_.IsDefault()) {
+    _impl_.hdata_.Set("", GetArenaForAllocation());
+  }
+#endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  return p;
+}
+inline void data_info::set_allocated_hdata(std::string* hdata) {
+  if (hdata != nullptr) {
+    _impl_._has_bits_[0] |= 0x00000001u;
+  } else {
+    _impl_._has_bits_[0] &= ~0x00000001u;
+  }
+  _impl_.hdata_.SetAllocated(hdata, GetArenaForAllocation());
+#ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  if (_impl_.hdata_.IsDefault()) {
+    _impl_.hdata_.Set("", GetArenaForAllocation());
+  }
+#endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  // @@protoc_insertion_point(field_set_allocated:data_info.hdata)
+}
+
 // -------------------------------------------------------------------
 
 // tree_node
 
 // required uint32 index = 1;
-inline bool tree_node::has_index() const {
-  return (_has_bits_[0] & 0x00000001u) != 0;
-}
-inline void tree_node::set_has_index() {
-  _has_bits_[0] |= 0x00000001u;
+inline bool tree_node::_internal_has_index() const {
+  bool value = (_impl_._has_bits_[0] & 0x00000004u) != 0;
+  return value;
 }
-inline void tree_node::clear_has_index() {
-  _has_bits_[0] &= ~0x00000001u;
+inline bool tree_node::has_index() const {
+  return _internal_has_index();
 }
 inline void tree_node::clear_index() {
-  index_ = 0u;
-  clear_has_index();
+  _impl_.index_ = 0u;
+  _impl_._has_bits_[0] &= ~0x00000004u;
 }
-inline ::google::protobuf::uint32 tree_node::index() const {
+inline uint32_t tree_node::_internal_index() const {
+  return _impl_.index_;
+}
+inline uint32_t tree_node::index() const {
   // @@protoc_insertion_point(field_get:tree_node.index)
-  return index_;
+  return _internal_index();
+}
+inline void tree_node::_internal_set_index(uint32_t value) {
+  _impl_._has_bits_[0] |= 0x00000004u;
+  _impl_.index_ = value;
 }
-inline void tree_node::set_index(::google::protobuf::uint32 value) {
-  set_has_index();
-  index_ = value;
+inline void tree_node::set_index(uint32_t value) {
+  _internal_set_index(value);
   // @@protoc_insertion_point(field_set:tree_node.index)
 }
 
 // required bool leaf = 2;
-inline bool tree_node::has_leaf() const {
-  return (_has_bits_[0] & 0x00000002u) != 0;
-}
-inline void tree_node::set_has_leaf() {
-  _has_bits_[0] |= 0x00000002u;
+inline bool tree_node::_internal_has_leaf() const {
+  bool value = (_impl_._has_bits_[0] & 0x00000008u) != 0;
+  return value;
 }
-inline void tree_node::clear_has_leaf() {
-  _has_bits_[0] &= ~0x00000002u;
+inline bool tree_node::has_leaf() const {
+  return _internal_has_leaf();
 }
 inline void tree_node::clear_leaf() {
-  leaf_ = false;
-  clear_has_leaf();
+  _impl_.leaf_ = false;
+  _impl_._has_bits_[0] &= ~0x00000008u;
+}
+inline bool tree_node::_internal_leaf() const {
+  return _impl_.leaf_;
 }
 inline bool tree_node::leaf() const {
   // @@protoc_insertion_point(field_get:tree_node.leaf)
-  return leaf_;
+  return _internal_leaf();
+}
+inline void tree_node::_internal_set_leaf(bool value) {
+  _impl_._has_bits_[0] |= 0x00000008u;
+  _impl_.leaf_ = value;
 }
 inline void tree_node::set_leaf(bool value) {
-  set_has_leaf();
-  leaf_ = value;
+  _internal_set_leaf(value);
   // @@protoc_insertion_point(field_set:tree_node.leaf)
 }
 
 // optional uint32 left = 3;
-inline bool tree_node::has_left() const {
-  return (_has_bits_[0] & 0x00000004u) != 0;
-}
-inline void tree_node::set_has_left() {
-  _has_bits_[0] |= 0x00000004u;
+inline bool tree_node::_internal_has_left() const {
+  bool value = (_impl_._has_bits_[0] & 0x00000010u) != 0;
+  return value;
 }
-inline void tree_node::clear_has_left() {
-  _has_bits_[0] &= ~0x00000004u;
+inline bool tree_node::has_left() const {
+  return _internal_has_left();
 }
 inline void tree_node::clear_left() {
-  left_ = 0u;
-  clear_has_left();
+  _impl_.left_ = 0u;
+  _impl_._has_bits_[0] &= ~0x00000010u;
+}
+inline uint32_t tree_node::_internal_left() const {
+  return _impl_.left_;
 }
-inline ::google::protobuf::uint32 tree_node::left() const {
+inline uint32_t tree_node::left() const {
   // @@protoc_insertion_point(field_get:tree_node.left)
-  return left_;
+  return _internal_left();
 }
-inline void tree_node::set_left(::google::protobuf::uint32 value) {
-  set_has_left();
-  left_ = value;
+inline void tree_node::_internal_set_left(uint32_t value) {
+  _impl_._has_bits_[0] |= 0x00000010u;
+  _impl_.left_ = value;
+}
+inline void tree_node::set_left(uint32_t value) {
+  _internal_set_left(value);
   // @@protoc_insertion_point(field_set:tree_node.left)
 }
 
 // optional uint32 right = 4;
-inline bool tree_node::has_right() const {
-  return (_has_bits_[0] & 0x00000008u) != 0;
-}
-inline void tree_node::set_has_right() {
-  _has_bits_[0] |= 0x00000008u;
+inline bool tree_node::_internal_has_right() const {
+  bool value = (_impl_._has_bits_[0] & 0x00000020u) != 0;
+  return value;
 }
-inline void tree_node::clear_has_right() {
-  _has_bits_[0] &= ~0x00000008u;
+inline bool tree_node::has_right() const {
+  return _internal_has_right();
 }
 inline void tree_node::clear_right() {
-  right_ = 0u;
-  clear_has_right();
+  _impl_.right_ = 0u;
+  _impl_._has_bits_[0] &= ~0x00000020u;
+}
+inline uint32_t tree_node::_internal_right() const {
+  return _impl_.right_;
 }
-inline ::google::protobuf::uint32 tree_node::right() const {
+inline uint32_t tree_node::right() const {
   // @@protoc_insertion_point(field_get:tree_node.right)
-  return right_;
+  return _internal_right();
 }
-inline void tree_node::set_right(::google::protobuf::uint32 value) {
-  set_has_right();
-  right_ = value;
+inline void tree_node::_internal_set_right(uint32_t value) {
+  _impl_._has_bits_[0] |= 0x00000020u;
+  _impl_.right_ = value;
+}
+inline void tree_node::set_right(uint32_t value) {
+  _internal_set_right(value);
   // @@protoc_insertion_point(field_set:tree_node.right)
 }
 
 // repeated uint32 items = 5;
+inline int tree_node::_internal_items_size() const {
+  return _impl_.items_.size();
+}
 inline int tree_node::items_size() const {
-  return items_.size();
+  return _internal_items_size();
 }
 inline void tree_node::clear_items() {
-  items_.Clear();
+  _impl_.items_.Clear();
 }
-inline ::google::protobuf::uint32 tree_node::items(int index) const {
+inline uint32_t tree_node::_internal_items(int index) const {
+  return _impl_.items_.Get(index);
+}
+inline uint32_t tree_node::items(int index) const {
   // @@protoc_insertion_point(field_get:tree_node.items)
-  return items_.Get(index);
+  return _internal_items(index);
 }
-inline void tree_node::set_items(int index, ::google::protobuf::uint32 value) {
-  items_.Set(index, value);
+inline void tree_node::set_items(int index, uint32_t value) {
+  _impl_.items_.Set(index, value);
   // @@protoc_insertion_point(field_set:tree_node.items)
 }
-inline void tree_node::add_items(::google::protobuf::uint32 value) {
-  items_.Add(value);
+inline void tree_node::_internal_add_items(uint32_t value) {
+  _impl_.items_.Add(value);
+}
+inline void tree_node::add_items(uint32_t value) {
+  _internal_add_items(value);
   // @@protoc_insertion_point(field_add:tree_node.items)
 }
-inline const ::google::protobuf::RepeatedField< ::google::protobuf::uint32 >&
+inline const ::PROTOBUF_NAMESPACE_ID::RepeatedField< uint32_t >&
+tree_node::_internal_items() const {
+  return _impl_.items_;
+}
+inline const ::PROTOBUF_NAMESPACE_ID::RepeatedField< uint32_t >&
 tree_node::items() const {
   // @@protoc_insertion_point(field_list:tree_node.items)
-  return items_;
+  return _internal_items();
 }
-inline ::google::protobuf::RepeatedField< ::google::protobuf::uint32 >*
+inline ::PROTOBUF_NAMESPACE_ID::RepeatedField< uint32_t >*
+tree_node::_internal_mutable_items() {
+  return &_impl_.items_;
+}
+inline ::PROTOBUF_NAMESPACE_ID::RepeatedField< uint32_t >*
 tree_node::mutable_items() {
   // @@protoc_insertion_point(field_mutable_list:tree_node.items)
-  return &items_;
+  return _internal_mutable_items();
 }
 
 // repeated float v = 6 [packed = true];
+inline int tree_node::_internal_v_size() const {
+  return _impl_.v_.size();
+}
 inline int tree_node::v_size() const {
-  return v_.size();
+  return _internal_v_size();
 }
 inline void tree_node::clear_v() {
-  v_.Clear();
+  _impl_.v_.Clear();
+}
+inline float tree_node::_internal_v(int index) const {
+  return _impl_.v_.Get(index);
 }
 inline float tree_node::v(int index) const {
   // @@protoc_insertion_point(field_get:tree_node.v)
-  return v_.Get(index);
+  return _internal_v(index);
 }
 inline void tree_node::set_v(int index, float value) {
-  v_.Set(index, value);
+  _impl_.v_.Set(index, value);
   // @@protoc_insertion_point(field_set:tree_node.v)
 }
+inline void tree_node::_internal_add_v(float value) {
+  _impl_.v_.Add(value);
+}
 inline void tree_node::add_v(float value) {
-  v_.Add(value);
+  _internal_add_v(value);
   // @@protoc_insertion_point(field_add:tree_node.v)
 }
-inline const ::google::protobuf::RepeatedField< float >&
+inline const ::PROTOBUF_NAMESPACE_ID::RepeatedField< float >&
+tree_node::_internal_v() const {
+  return _impl_.v_;
+}
+inline const ::PROTOBUF_NAMESPACE_ID::RepeatedField< float >&
 tree_node::v() const {
   // @@protoc_insertion_point(field_list:tree_node.v)
-  return v_;
+  return _internal_v();
+}
+inline ::PROTOBUF_NAMESPACE_ID::RepeatedField< float >*
+tree_node::_internal_mutable_v() {
+  return &_impl_.v_;
 }
-inline ::google::protobuf::RepeatedField< float >*
+inline ::PROTOBUF_NAMESPACE_ID::RepeatedField< float >*
 tree_node::mutable_v() {
   // @@protoc_insertion_point(field_mutable_list:tree_node.v)
-  return &v_;
+  return _internal_mutable_v();
+}
+
+// optional bytes hv = 7;
+inline bool tree_node::_internal_has_hv() const {
+  bool value = (_impl_._has_bits_[0] & 0x00000001u) != 0;
+  return value;
+}
+inline bool tree_node::has_hv() const {
+  return _internal_has_hv();
+}
+inline void tree_node::clear_hv() {
+  _impl_.hv_.ClearToEmpty();
+  _impl_._has_bits_[0] &= ~0x00000001u;
+}
+inline const std::string& tree_node::hv() const {
+  // @@protoc_insertion_point(field_get:tree_node.hv)
+  return _internal_hv();
+}
+template <typename ArgT0, typename... ArgT>
+inline PROTOBUF_ALWAYS_INLINE
+void tree_node::set_hv(ArgT0&& arg0, ArgT... args) {
+ _impl_._has_bits_[0] |= 0x00000001u;
+ _impl_.hv_.SetBytes(static_cast<ArgT0 &&>(arg0), args..., GetArenaForAllocation());
+  // @@protoc_insertion_point(field_set:tree_node.hv)
+}
+inline std::string* tree_node::mutable_hv() {
+  std::string* _s = _internal_mutable_hv();
+  // @@protoc_insertion_point(field_mutable:tree_node.hv)
+  return _s;
+}
+inline const std::string& tree_node::_internal_hv() const {
+  return _impl_.hv_.Get();
+}
+inline void tree_node::_internal_set_hv(const std::string& value) {
+  _impl_._has_bits_[0] |= 0x00000001u;
+  _impl_.hv_.Set(value, GetArenaForAllocation());
+}
+inline std::string* tree_node::_internal_mutable_hv() {
+  _impl_._has_bits_[0] |= 0x00000001u;
+  return _impl_.hv_.Mutable(GetArenaForAllocation());
+}
+inline std::string* tree_node::release_hv() {
+  // @@protoc_insertion_point(field_release:tree_node.hv)
+  if (!_internal_has_hv()) {
+    return nullptr;
+  }
+  _impl_._has_bits_[0] &= ~0x00000001u;
+  auto* p = _impl_.hv_.Release();
+#ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  if (_impl_.hv_.IsDefault()) {
+    _impl_.hv_.Set("", GetArenaForAllocation());
+  }
+#endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  return p;
+}
+inline void tree_node::set_allocated_hv(std::string* hv) {
+  if (hv != nullptr) {
+    _impl_._has_bits_[0] |= 0x00000001u;
+  } else {
+    _impl_._has_bits_[0] &= ~0x00000001u;
+  }
+  _impl_.hv_.SetAllocated(hv, GetArenaForAllocation());
+#ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  if (_impl_.hv_.IsDefault()) {
+    _impl_.hv_.Set("", GetArenaForAllocation());
+  }
+#endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  // @@protoc_insertion_point(field_set_allocated:tree_node.hv)
+}
+
+// optional bytes leaf_data = 8;
+inline bool tree_node::_internal_has_leaf_data() const {
+  bool value = (_impl_._has_bits_[0] & 0x00000002u) != 0;
+  return value;
+}
+inline bool tree_node::has_leaf_data() const {
+  return _internal_has_leaf_data();
+}
+inline void tree_node::clear_leaf_data() {
+  _impl_.leaf_data_.ClearToEmpty();
+  _impl_._has_bits_[0] &= ~0x00000002u;
+}
+inline const std::string& tree_node::leaf_data() const {
+  // @@protoc_insertion_point(field_get:tree_node.leaf_data)
+  return _internal_leaf_data();
+}
+template <typename ArgT0, typename... ArgT>
+inline PROTOBUF_ALWAYS_INLINE
+void tree_node::set_leaf_data(ArgT0&& arg0, ArgT... args) {
+ _impl_._has_bits_[0] |= 0x00000002u;
+ _impl_.leaf_data_.SetBytes(static_cast<ArgT0 &&>(arg0), args..., GetArenaForAllocation());
+  // @@protoc_insertion_point(field_set:tree_node.leaf_data)
+}
+inline std::string* tree_node::mutable_leaf_data() {
+  std::string* _s = _internal_mutable_leaf_data();
+  // @@protoc_insertion_point(field_mutable:tree_node.leaf_data)
+  return _s;
+}
+inline const std::string& tree_node::_internal_leaf_data() const {
+  return _impl_.leaf_data_.Get();
+}
+inline void tree_node::_internal_set_leaf_data(const std::string& value) {
+  _impl_._has_bits_[0] |= 0x00000002u;
+  _impl_.leaf_data_.Set(value, GetArenaForAllocation());
+}
+inline std::string* tree_node::_internal_mutable_leaf_data() {
+  _impl_._has_bits_[0] |= 0x00000002u;
+  return _impl_.leaf_data_.Mutable(GetArenaForAllocation());
+}
+inline std::string* tree_node::release_leaf_data() {
+  // @@protoc_insertion_point(field_release:tree_node.leaf_data)
+  if (!_internal_has_leaf_data()) {
+    return nullptr;
+  }
+  _impl_._has_bits_[0] &= ~0x00000002u;
+  auto* p = _impl_.leaf_data_.Release();
+#ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  if (_impl_.leaf_data_.IsDefault()) {
+    _impl_.leaf_data_.Set("", GetArenaForAllocation());
+  }
+#endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  return p;
+}
+inline void tree_node::set_allocated_leaf_data(std::string* leaf_data) {
+  if (leaf_data != nullptr) {
+    _impl_._has_bits_[0] |= 0x00000002u;
+  } else {
+    _impl_._has_bits_[0] &= ~0x00000002u;
+  }
+  _impl_.leaf_data_.SetAllocated(leaf_data, GetArenaForAllocation());
+#ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  if (_impl_.leaf_data_.IsDefault()) {
+    _impl_.leaf_data_.Set("", GetArenaForAllocation());
+  }
+#endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  // @@protoc_insertion_point(field_set_allocated:tree_node.leaf_data)
 }
 
-#endif  // !PROTOBUF_INLINE_NOT_IN_HEADERS
+// -------------------------------------------------------------------
+
+// index_meta
+
+// optional uint32 codec = 1;
+inline bool index_meta::_internal_has_codec() const {
+  bool value = (_impl_._has_bits_[0] & 0x00000001u) != 0;
+  return value;
+}
+inline bool index_meta::has_codec() const {
+  return _internal_has_codec();
+}
+inline void index_meta::clear_codec() {
+  _impl_.codec_ = 0u;
+  _impl_._has_bits_[0] &= ~0x00000001u;
+}
+inline uint32_t index_meta::_internal_codec() const {
+  return _impl_.codec_;
+}
+inline uint32_t index_meta::codec() const {
+  // @@protoc_insertion_point(field_get:index_meta.codec)
+  return _internal_codec();
+}
+inline void index_meta::_internal_set_codec(uint32_t value) {
+  _impl_._has_bits_[0] |= 0x00000001u;
+  _impl_.codec_ = value;
+}
+inline void index_meta::set_codec(uint32_t value) {
+  _internal_set_codec(value);
+  // @@protoc_insertion_point(field_set:index_meta.codec)
+}
+
+// optional uint32 vector_type = 2;
+inline bool index_meta::_internal_has_vector_type() const {
+  bool value = (_impl_._has_bits_[0] & 0x00000002u) != 0;
+  return value;
+}
+inline bool index_meta::has_vector_type() const {
+  return _internal_has_vector_type();
+}
+inline void index_meta::clear_vector_type() {
+  _impl_.vector_type_ = 0u;
+  _impl_._has_bits_[0] &= ~0x00000002u;
+}
+inline uint32_t index_meta::_internal_vector_type() const {
+  return _impl_.vector_type_;
+}
+inline uint32_t index_meta::vector_type() const {
+  // @@protoc_insertion_point(field_get:index_meta.vector_type)
+  return _internal_vector_type();
+}
+inline void index_meta::_internal_set_vector_type(uint32_t value) {
+  _impl_._has_bits_[0] |= 0x00000002u;
+  _impl_.vector_type_ = value;
+}
+inline void index_meta::set_vector_type(uint32_t value) {
+  _internal_set_vector_type(value);
+  // @@protoc_insertion_point(field_set:index_meta.vector_type)
+}
+
+// optional uint32 leaf_embed_trees = 3;
+inline bool index_meta::_internal_has_leaf_embed_trees() const {
+  bool value = (_impl_._has_bits_[0] & 0x00000004u) != 0;
+  return value;
+}
+inline bool index_meta::has_leaf_embed_trees() const {
+  return _internal_has_leaf_embed_trees();
+}
+inline void index_meta::clear_leaf_embed_trees() {
+  _impl_.leaf_embed_trees_ = 0u;
+  _impl_._has_bits_[0] &= ~0x00000004u;
+}
+inline uint32_t index_meta::_internal_leaf_embed_trees() const {
+  return _impl_.leaf_embed_trees_;
+}
+inline uint32_t index_meta::leaf_embed_trees() const {
+  // @@protoc_insertion_point(field_get:index_meta.leaf_embed_trees)
+  return _internal_leaf_embed_trees();
+}
+inline void index_meta::_internal_set_leaf_embed_trees(uint32_t value) {
+  _impl_._has_bits_[0] |= 0x00000004u;
+  _impl_.leaf_embed_trees_ = value;
+}
+inline void index_meta::set_leaf_embed_trees(uint32_t value) {
+  _internal_set_leaf_embed_trees(value);
+  // @@protoc_insertion_point(field_set:index_meta.leaf_embed_trees)
+}
+
+// optional uint32 leaf_page_size = 4;
+inline bool index_meta::_internal_has_leaf_page_size() const {
+  bool value = (_impl_._has_bits_[0] & 0x00000008u) != 0;
+  return value;
+}
+inline bool index_meta::has_leaf_page_size() const {
+  return _internal_has_leaf_page_size();
+}
+inline void index_meta::clear_leaf_page_size() {
+  _impl_.leaf_page_size_ = 0u;
+  _impl_._has_bits_[0] &= ~0x00000008u;
+}
+inline uint32_t index_meta::_internal_leaf_page_size() const {
+  return _impl_.leaf_page_size_;
+}
+inline uint32_t index_meta::leaf_page_size() const {
+  // @@protoc_insertion_point(field_get:index_meta.leaf_page_size)
+  return _internal_leaf_page_size();
+}
+inline void index_meta::_internal_set_leaf_page_size(uint32_t value) {
+  _impl_._has_bits_[0] |= 0x00000008u;
+  _impl_.leaf_page_size_ = value;
+}
+inline void index_meta::set_leaf_page_size(uint32_t value) {
+  _internal_set_leaf_page_size(value);
+  // @@protoc_insertion_point(field_set:index_meta.leaf_page_size)
+}
+
+// optional uint32 leaf_capacity = 5;
+inline bool index_meta::_internal_has_leaf_capacity() const {
+  bool value = (_impl_._has_bits_[0] & 0x00000010u) != 0;
+  return value;
+}
+inline bool index_meta::has_leaf_capacity() const {
+  return _internal_has_leaf_capacity();
+}
+inline void index_meta::clear_leaf_capacity() {
+  _impl_.leaf_capacity_ = 0u;
+  _impl_._has_bits_[0] &= ~0x00000010u;
+}
+inline uint32_t index_meta::_internal_leaf_capacity() const {
+  return _impl_.leaf_capacity_;
+}
+inline uint32_t index_meta::leaf_capacity() const {
+  // @@protoc_insertion_point(field_get:index_meta.leaf_capacity)
+  return _internal_leaf_capacity();
+}
+inline void index_meta::_internal_set_leaf_capacity(uint32_t value) {
+  _impl_._has_bits_[0] |= 0x00000010u;
+  _impl_.leaf_capacity_ = value;
+}
+inline void index_meta::set_leaf_capacity(uint32_t value) {
+  _internal_set_leaf_capacity(value);
+  // @@protoc_insertion_point(field_set:index_meta.leaf_capacity)
+}
+
+// optional bool tree_dbs = 6;
+inline bool index_meta::_internal_has_tree_dbs() const {
+  bool value = (_impl_._has_bits_[0] & 0x00000020u) != 0;
+  return value;
+}
+inline bool index_meta::has_tree_dbs() const {
+  return _internal_has_tree_dbs();
+}
+inline void index_meta::clear_tree_dbs() {
+  _impl_.tree_dbs_ = false;
+  _impl_._has_bits_[0] &= ~0x00000020u;
+}
+inline bool index_meta::_internal_tree_dbs() const {
+  return _impl_.tree_dbs_;
+}
+inline bool index_meta::tree_dbs() const {
+  // @@protoc_insertion_point(field_get:index_meta.tree_dbs)
+  return _internal_tree_dbs();
+}
+inline void index_meta::_internal_set_tree_dbs(bool value) {
+  _impl_._has_bits_[0] |= 0x00000020u;
+  _impl_.tree_dbs_ = value;
+}
+inline void index_meta::set_tree_dbs(bool value) {
+  _internal_set_tree_dbs(value);
+  // @@protoc_insertion_point(field_set:index_meta.tree_dbs)
+}
+
+// optional uint64 seed = 7;
+inline bool index_meta::_internal_has_seed() const {
+  bool value = (_impl_._has_bits_[0] & 0x00000040u) != 0;
+  return value;
+}
+inline bool index_meta::has_seed() const {
+  return _internal_has_seed();
+}
+inline void index_meta::clear_seed() {
+  _impl_.seed_ = uint64_t{0u};
+  _impl_._has_bits_[0] &= ~0x00000040u;
+}
+inline uint64_t index_meta::_internal_seed() const {
+  return _impl_.seed_;
+}
+inline uint64_t index_meta::seed() const {
+  // @@protoc_insertion_point(field_get:index_meta.seed)
+  return _internal_seed();
+}
+inline void index_meta::_internal_set_seed(uint64_t value) {
+  _impl_._has_bits_[0] |= 0x00000040u;
+  _impl_.seed_ = value;
+}
+inline void index_meta::set_seed(uint64_t value) {
+  _internal_set_seed(value);
+  // @@protoc_insertion_point(field_set:index_meta.seed)
+}
+
+// -------------------------------------------------------------------
+
+// pq_codebook
+
+// optional uint32 m = 1;
+inline bool pq_codebook::_internal_has_m() const {
+  bool value = (_impl_._has_bits_[0] & 0x00000001u) != 0;
+  return value;
+}
+inline bool pq_codebook::has_m() const {
+  return _internal_has_m();
+}
+inline void pq_codebook::clear_m() {
+  _impl_.m_ = 0u;
+  _impl_._has_bits_[0] &= ~0x00000001u;
+}
+inline uint32_t pq_codebook::_internal_m() const {
+  return _impl_.m_;
+}
+inline uint32_t pq_codebook::m() const {
+  // @@protoc_insertion_point(field_get:pq_codebook.m)
+  return _internal_m();
+}
+inline void pq_codebook::_internal_set_m(uint32_t value) {
+  _impl_._has_bits_[0] |= 0x00000001u;
+  _impl_.m_ = value;
+}
+inline void pq_codebook::set_m(uint32_t value) {
+  _internal_set_m(value);
+  // @@protoc_insertion_point(field_set:pq_codebook.m)
+}
+
+// optional uint32 nbits = 2;
+inline bool pq_codebook::_internal_has_nbits() const {
+  bool value = (_impl_._has_bits_[0] & 0x00000002u) != 0;
+  return value;
+}
+inline bool pq_codebook::has_nbits() const {
+  return _internal_has_nbits();
+}
+inline void pq_codebook::clear_nbits() {
+  _impl_.nbits_ = 0u;
+  _impl_._has_bits_[0] &= ~0x00000002u;
+}
+inline uint32_t pq_codebook::_internal_nbits() const {
+  return _impl_.nbits_;
+}
+inline uint32_t pq_codebook::nbits() const {
+  // @@protoc_insertion_point(field_get:pq_codebook.nbits)
+  return _internal_nbits();
+}
+inline void pq_codebook::_internal_set_nbits(uint32_t value) {
+  _impl_._has_bits_[0] |= 0x00000002u;
+  _impl_.nbits_ = value;
+}
+inline void pq_codebook::set_nbits(uint32_t value) {
+  _internal_set_nbits(value);
+  // @@protoc_insertion_point(field_set:pq_codebook.nbits)
+}
+
+// repeated float centroids = 3 [packed = true];
+inline int pq_codebook::_internal_centroids_size() const {
+  return _impl_.centroids_.size();
+}
+inline int pq_codebook::centroids_size() const {
+  return _internal_centroids_size();
+}
+inline void pq_codebook::clear_centroids() {
+  _impl_.centroids_.Clear();
+}
+inline float pq_codebook::_internal_centroids(int index) const {
+  return _impl_.centroids_.Get(index);
+}
+inline float pq_codebook::centroids(int index) const {
+  // @@protoc_insertion_point(field_get:pq_codebook.centroids)
+  return _internal_centroids(index);
+}
+inline void pq_codebook::set_centroids(int index, float value) {
+  _impl_.centroids_.Set(index, value);
+  // @@protoc_insertion_point(field_set:pq_codebook.centroids)
+}
+inline void pq_codebook::_internal_add_centroids(float value) {
+  _impl_.centroids_.Add(value);
+}
+inline void pq_codebook::add_centroids(float value) {
+  _internal_add_centroids(value);
+  // @@protoc_insertion_point(field_add:pq_codebook.centroids)
+}
+inline const ::PROTOBUF_NAMESPACE_ID::RepeatedField< float >&
+pq_codebook::_internal_centroids() const {
+  return _impl_.centroids_;
+}
+inline const ::PROTOBUF_NAMESPACE_ID::RepeatedField< float >&
+pq_codebook::centroids() const {
+  // @@protoc_insertion_point(field_list:pq_codebook.centroids)
+  return _internal_centroids();
+}
+inline ::PROTOBUF_NAMESPACE_ID::RepeatedField< float >*
+pq_codebook::_internal_mutable_centroids() {
+  return &_impl_.centroids_;
+}
+inline ::PROTOBUF_NAMESPACE_ID::RepeatedField< float >*
+pq_codebook::mutable_centroids() {
+  // @@protoc_insertion_point(field_mutable_list:pq_codebook.centroids)
+  return _internal_mutable_centroids();
+}
+
+#ifdef __GNUC__
+  #pragma GCC diagnostic pop
+#endif  // __GNUC__
+// -------------------------------------------------------------------
+
+// -------------------------------------------------------------------
+
 // -------------------------------------------------------------------
 
 
 // @@protoc_insertion_point(namespace_scope)
 
+
 // @@protoc_insertion_point(global_scope)
 
-#endif  // PROTOBUF_protobuf_2fannoy_2eproto__INCLUDED
+#include <google/protobuf/port_undef.inc>
+#endif  // GOOGLE_PROTOBUF_INCLUDED_GOOGLE_PROTOBUF_INCLUDED_protobuf_2fannoy_2eproto
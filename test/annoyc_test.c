@@ -0,0 +1,162 @@
+/*
+ Copyright (c) 2013 Spotify AB
+
+ Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ use this file except in compliance with the License. You may obtain a copy of
+ the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ License for the specific language governing permissions and limitations under
+ the License.
+
+ Tests the C interface of annoyc.h, built and run by make check:
+   annoyc_test [dir]
+ dir (default test_annoyc_db) is emptied and holds the indexes, one per test.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "annoyc.h"
+
+#define F 8
+#define N 500
+
+static int failures = 0;
+
+#define EXPECT(test) do { \
+    if (!(test)) { \
+      fprintf(stderr, "%s:%d: expected %s\n", __FILE__, __LINE__, #test); \
+      failures++; \
+    } \
+  } while (0)
+
+#define EXPECT_ERR(expected, call) do { \
+    int err_ = (call); \
+    if (err_ != (expected)) { \
+      fprintf(stderr, "%s:%d: %s returned %d (%s), expected %s\n", __FILE__, __LINE__, #call, \
+              err_, annoy_strerror(err_), #expected); \
+      failures++; \
+    } \
+  } while (0)
+
+static float data[N * F];
+
+static void reset(const char* dir) {
+  char command[1024];
+  snprintf(command, sizeof(command), "rm -rf %s && mkdir -p %s/basic %s/errors", dir, dir, dir);
+  if (system(command) != 0) {
+    fprintf(stderr, "can not reset %s\n", dir);
+    exit(1);
+  }
+}
+
+static void test_open_add_query_close(const char* root) {
+  annoy_index* index = NULL;
+  char dir[512];
+  int32_t items[N - 1];
+  int32_t ids[30];
+  float distances[30];
+  size_t found[3];
+  int32_t n;
+  float v[F];
+  int i;
+
+  snprintf(dir, sizeof(dir), "%s/basic", root);
+  EXPECT_ERR(ANNOY_OK, annoy_open(F, 10, 4, dir, 126, 1 << 28, 0, &index));
+  EXPECT(index != NULL);
+  EXPECT_ERR(ANNOY_OK, annoy_add_item(index, 0, data));
+  for (i = 0; i < N - 1; i++) {
+    items[i] = i + 1;
+  }
+  EXPECT_ERR(ANNOY_OK, annoy_add_items(index, items, data + F, N - 1));
+  EXPECT_ERR(ANNOY_OK, annoy_get_n_items(index, &n));
+  EXPECT(n == N);
+
+  EXPECT_ERR(ANNOY_OK, annoy_get_nns_by_vector(index, data + 7 * F, 10, -1, ids, distances, found));
+  EXPECT(found[0] == 10);
+  EXPECT(ids[0] == 7);
+  EXPECT(distances[0] < 1e-3);
+  for (i = 1; i < 10; i++) {
+    EXPECT(distances[i - 1] <= distances[i]);
+  }
+
+  EXPECT_ERR(ANNOY_OK, annoy_get_nns_by_vectors(index, data + 5 * F, 3, 10, -1, ids, NULL, found));
+  for (i = 0; i < 3; i++) {
+    EXPECT(found[i] == 10);
+    EXPECT(ids[i * 10] == 5 + i);
+  }
+
+  EXPECT_ERR(ANNOY_OK, annoy_get_item(index, 3, v));
+  EXPECT(memcmp(v, data + 3 * F, sizeof(v)) == 0);
+  annoy_close(index);
+
+  // the items are there for a read only handle too
+  EXPECT_ERR(ANNOY_OK, annoy_open(F, 10, 4, dir, 126, 0, 1, &index));
+  EXPECT_ERR(ANNOY_OK, annoy_get_nns_by_vector(index, data + 9 * F, 1, -1, ids, NULL, found));
+  EXPECT(found[0] == 1 && ids[0] == 9);
+  annoy_close(index);
+}
+
+static void test_errors(const char* root) {
+  annoy_index* index = NULL;
+  char dir[512];
+  int32_t item = 1;
+  int32_t ids[10];
+  size_t found[2];
+  float v[F];
+
+  snprintf(dir, sizeof(dir), "%s/errors", root);
+  EXPECT_ERR(ANNOY_EINVAL, annoy_open(0, 10, 4, dir, 126, 1 << 28, 0, &index));
+  EXPECT_ERR(ANNOY_EINVAL, annoy_open(F, 10, 4, NULL, 126, 1 << 28, 0, &index));
+  EXPECT(index == NULL);
+
+  EXPECT_ERR(ANNOY_OK, annoy_open(F, 10, 4, dir, 126, 1 << 28, 0, &index));
+  EXPECT_ERR(ANNOY_EINVAL, annoy_add_item(index, -1, data));
+  EXPECT_ERR(ANNOY_EINVAL, annoy_add_item(index, 0, NULL));
+  EXPECT_ERR(ANNOY_EINVAL, annoy_add_items(index, &item, NULL, 1));
+  EXPECT_ERR(ANNOY_EINVAL, annoy_get_nns_by_vector(index, NULL, 1, -1, ids, NULL, found));
+  EXPECT_ERR(ANNOY_EINVAL, annoy_get_item(NULL, 0, v));
+
+  // with no item stored yet the queries fail in the storage; none is answered
+  EXPECT(annoy_get_nns_by_vectors(index, data, 2, 1, -1, ids, NULL, found) != ANNOY_OK);
+  EXPECT(found[0] == ANNOY_UNANSWERED && found[1] == ANNOY_UNANSWERED);
+  // and the index refuses everything but annoy_close from then on
+  EXPECT_ERR(ANNOY_EFAILED, annoy_add_item(index, 0, data));
+  annoy_close(index);
+
+  EXPECT_ERR(ANNOY_OK, annoy_open(F, 10, 4, dir, 126, 1 << 28, 0, &index));
+  EXPECT_ERR(ANNOY_OK, annoy_add_item(index, 0, data));
+  EXPECT_ERR(ANNOY_ENOTFOUND, annoy_get_item(index, 5, v));
+  annoy_close(index);
+
+  EXPECT_ERR(ANNOY_OK, annoy_open(F, 10, 4, dir, 126, 0, 1, &index));
+  EXPECT_ERR(ANNOY_EREADONLY, annoy_add_item(index, 1, data));
+  EXPECT_ERR(ANNOY_EREADONLY, annoy_add_items(index, &item, data, 1));
+  annoy_close(index);
+
+  annoy_close(NULL);
+  EXPECT(strcmp(annoy_strerror(ANNOY_EREADONLY), "index is read only") == 0);
+}
+
+int main(int argc, char** argv) {
+  const char* dir = argc > 1 ? argv[1] : "test_annoyc_db";
+  int i;
+  srand(1);
+  for (i = 0; i < N * F; i++) {
+    data[i] = (float) rand() / RAND_MAX - 0.5f;
+  }
+  reset(dir);
+  test_open_add_query_close(dir);
+  test_errors(dir);
+  if (failures > 0) {
+    fprintf(stderr, "%d failures\n", failures);
+    return 1;
+  }
+  printf("annoyc_test: ok\n");
+  return 0;
+}
@@ -18,10 +18,11 @@
 import unittest
 import random
 import numpy
-from annoy import AnnoyIndex
+from annoy import AnnoyIndex, ScatterGather
 import os
 import math
 import time
+import threading
 try:
     xrange
 except NameError:
@@ -122,6 +123,397 @@ class AngularIndexTest(TestCase):
         self.assertEqual(i.get_nns_by_item(1, 3), [1, 0, 2])
         self.assertTrue(i.get_nns_by_item(2, 3) in [[2, 0, 1], [2, 1, 0]]) # could be either
 
+    def test_get_nns_int8_codec(self):
+        print "test_get_nns_int8_codec "
+        os.system("rm -rf test_db")
+        os.system("mkdir test_db")
+        f = 3
+        i = AnnoyIndex(f, 3, "test_db", 10, 1000, 3048576000, 0)
+        i.add_item(0, [0, 0, 1])
+        i.add_item(1, [0, 1, 0])
+        i.set_codec(1)
+        i.add_item(2, [1, 0, 0])
+
+        self.assertEqual(i.get_nns_by_vector([3, 2, 1], 3), [2, 1, 0])
+        i.set_rerank(2)
+        self.assertEqual(i.get_nns_by_vector([1, 2, 3], 3), [0, 1, 2])
+
+        j = AnnoyIndex(f, 3, "test_db", 10, 1000, 3048576000, 1)
+        self.assertEqual(j.get_nns_by_vector([2, 0, 1], 3), [2, 0, 1])
+
+    def test_get_nns_float16(self):
+        print "test_get_nns_float16 "
+        os.system("rm -rf test_db")
+        os.system("mkdir test_db")
+        f = 3
+        i = AnnoyIndex(f, 2, "test_db", 10, 1000, 3048576000, 0)
+        i.set_vector_type(1)
+        i.add_item(0, [0, 0, 1])
+        i.add_item(1, [0, 1, 0])
+        i.add_item(2, [1, 0, 0])
+
+        self.assertEqual(i.get_nns_by_vector([3, 2, 1], 3), [2, 1, 0])
+        numpy.testing.assert_array_almost_equal(i.get_item(1), [0, 1, 0])
+        i.set_vector_type(2)
+        self.assertEqual(i.get_nns_by_vector([1, 2, 3], 3), [0, 1, 2])
+
+    def test_get_nns_pq_codec(self):
+        print "test_get_nns_pq_codec "
+        os.system("rm -rf test_db")
+        os.system("mkdir test_db")
+        f = 4
+        i = AnnoyIndex(f, 10, "test_db", 10, 1000, 3048576000, 0)
+        for j in xrange(100):
+            i.add_item(j, [random.gauss(0, 1) for z in xrange(f)])
+        self.assertFalse(i.train_pq(3, 4))
+        self.assertTrue(i.train_pq(2, 4))
+        i.set_rerank(10)
+        self.assertEqual(i.get_nns_by_item(0, 1, 100), [0])
+
+    def test_get_nns_leaf_embedding(self):
+        print "test_get_nns_leaf_embedding "
+        os.system("rm -rf test_db")
+        os.system("mkdir test_db")
+        f = 3
+        i = AnnoyIndex(f, 2, "test_db", 10, 1000, 3048576000, 0)
+        i.set_leaf_embedding(5)
+        i.add_item(0, [0, 0, 1])
+        i.add_item(1, [0, 1, 0])
+        i.add_item(2, [1, 0, 0])
+
+        self.assertEqual(i.get_nns_by_vector([3, 2, 1], 3), [2, 1, 0])
+        i.set_codec(1)
+        self.assertEqual(i.get_nns_by_vector([1, 2, 3], 3), [0, 1, 2])
+        i.set_leaf_embedding(0)
+        self.assertEqual(i.get_nns_by_vector([2, 0, 1], 3), [2, 0, 1])
+
+    def test_tree_stats(self):
+        print "test_tree_stats "
+        os.system("rm -rf test_db")
+        os.system("mkdir test_db")
+        f = 10
+        i = AnnoyIndex(f, 10, "test_db", 2, 1000, 3048576000, 0)
+        for j in xrange(1000):
+            i.add_item(j, [random.gauss(0, 1) for z in xrange(f)])
+
+        stats = i.get_tree_stats(0)
+        self.assertEqual(stats['items'], 1000)
+        self.assertEqual(stats['nodes'], 2 * stats['leaves'] - 1)
+        self.assertTrue(stats['max_depth'] < 20)
+        self.assertTrue(stats['mean_depth'] <= stats['max_depth'])
+        self.assertEqual(i.get_tree_stats(2), None)
+
+    def test_rebalance(self):
+        print "test_rebalance "
+        os.system("rm -rf test_db")
+        os.system("mkdir test_db")
+        f = 10
+        i = AnnoyIndex(f, 10, "test_db", 2, 1000, 3048576000, 0)
+        # a drifting stream makes lopsided trees
+        for j in xrange(1000):
+            a = 3.0 * j / 1000
+            i.add_item(j, [3 * math.cos(a), 3 * math.sin(a)] + [random.gauss(0, 1) for z in xrange(f - 2)])
+        before = i.get_tree_stats(0)
+
+        self.assertTrue(i.rebalance(1.0) > 0)
+        after = i.get_tree_stats(0)
+        self.assertEqual(after['items'], 1000)
+        self.assertTrue(after['max_depth'] <= before['max_depth'])
+        self.assertEqual(i.get_nns_by_item(0, 1), [0])
+
+        self.assertTrue(i.start_maintenance(10))
+        time.sleep(0.1)
+        i.stop_maintenance()
+        self.assertEqual(i.get_tree_stats(1)['items'], 1000)
+
+    def test_rebuild_tree(self):
+        print "test_rebuild_tree "
+        os.system("rm -rf test_db")
+        os.system("mkdir test_db")
+        f = 10
+        i = AnnoyIndex(f, 10, "test_db", 3, 1000, 3048576000, 0)
+        for j in xrange(1000):
+            i.add_item(j, [random.gauss(0, 1) for z in xrange(f)])
+        other = i.get_tree_stats(1)
+
+        # only the rebuilt tree changes
+        self.assertTrue(i.rebuild_tree(0))
+        self.assertFalse(i.rebuild_tree(3))
+        self.assertEqual(i.get_tree_stats(0)['items'], 1000)
+        self.assertEqual(i.get_tree_stats(1), other)
+        self.assertEqual(i.get_nns_by_item(0, 1), [0])
+
+    def test_compact_trees(self):
+        print "test_compact_trees "
+        os.system("rm -rf test_db")
+        os.system("mkdir test_db")
+        f = 10
+        i = AnnoyIndex(f, 10, "test_db", 3, 1000, 3048576000, 0)
+        for j in xrange(1000):
+            i.add_item(j, [random.gauss(0, 1) for z in xrange(f)])
+        stats = i.get_tree_stats(0)
+        nns = i.get_nns_by_item(0, 10, 200)
+
+        # renumbering keeps the trees as they are
+        for layout in [0, 1]:
+            self.assertTrue(i.compact_trees(layout))
+            self.assertEqual(i.get_tree_stats(0), stats)
+            self.assertEqual(i.get_nns_by_item(0, 10, 200), nns)
+
+    def test_save_load(self):
+        print "test_save_load "
+        os.system("rm -rf test_db")
+        os.system("mkdir test_db")
+        f = 10
+        i = AnnoyIndex(f, 10, "test_db", 10, 1000, 3048576000, 0)
+        for j in xrange(1000):
+            i.add_item(j, [random.gauss(0, 1) for z in xrange(f)])
+        self.assertTrue(i.save("test_db/flat.ann"))
+
+        j = AnnoyIndex(f, 10, "test_db", 10, 1000, 3048576000, 1)
+        self.assertTrue(j.load("test_db/flat.ann"))
+        self.assertEqual(j.get_n_items(), 1000)
+        numpy.testing.assert_array_almost_equal(j.get_item(5), i.get_item(5))
+        self.assertEqual(j.get_nns_by_item(5, 1), [5])
+        nns = i.get_nns_by_item(5, 10, 1000)
+        self.assertTrue(len(set(j.get_nns_by_item(5, 10, 1000)) & set(nns)) >= 8)
+        j.unload()
+
+        # items still in the write buffer or a pending group are saved too
+        i.set_write_buffer(100, 0)
+        i.add_item(1000, [1] * f)
+        self.assertTrue(i.save("test_db/flat2.ann"))
+        i.set_write_buffer(0, 0)
+        i.set_group_commit(100, 10000)
+        i.add_item(1001, [-1] * f)
+        self.assertTrue(i.save("test_db/flat3.ann"))
+        self.assertTrue(j.load("test_db/flat2.ann"))
+        self.assertEqual(j.get_n_items(), 1001)
+        self.assertEqual(j.get_nns_by_vector([1] * f, 1), [1000])
+        j.unload()
+        self.assertTrue(j.load("test_db/flat3.ann"))
+        self.assertEqual(j.get_n_items(), 1002)
+        self.assertEqual(j.get_nns_by_vector([-1] * f, 1), [1001])
+        j.unload()
+
+    def test_warm_up(self):
+        print "test_warm_up "
+        os.system("rm -rf test_db")
+        os.system("mkdir test_db")
+        f = 10
+        i = AnnoyIndex(f, 10, "test_db", 10, 1000, 3048576000, 0)
+        for j in xrange(1000):
+            i.add_item(j, [random.gauss(0, 1) for z in xrange(f)])
+
+        j = AnnoyIndex(f, 10, "test_db", 10, 1000, 3048576000, 1)
+        self.assertTrue(j.warm_up(4, 1, 0, 1000) > 0)
+        self.assertEqual(j.get_nns_by_item(5, 1), [5])
+
+    def test_compact(self):
+        print "test_compact "
+        os.system("rm -rf test_db test_db2")
+        os.system("mkdir test_db test_db2")
+        f = 10
+        i = AnnoyIndex(f, 10, "test_db", 4, 1000, 3048576000, 0)
+        for j in xrange(2000):
+            i.add_item(j, [random.gauss(0, 1) for z in xrange(f)])
+        i.rebuild_tree(0) # leaves free pages behind
+        report = i.compact("test_db2", 0)
+        self.assertTrue(report['before']['free_pages'] > 0)
+        self.assertTrue(report['after']['free_pages'] <= report['before']['free_pages'])
+        self.assertTrue(report['after']['live_pages'] <= report['before']['live_pages'])
+
+        j = AnnoyIndex(f, 10, "test_db2", 4, 1000, 3048576000, 1)
+        self.assertEqual(j.get_n_items(), 2000)
+        self.assertEqual(j.get_nns_by_item(5, 1), [5])
+
+    def test_shards(self):
+        print "test_shards "
+        os.system("rm -rf test_db")
+        os.system("mkdir test_db")
+        f = 10
+        i = AnnoyIndex(f, 10, "test_db", 4, 1000, 3048576000, 0, shards=4)
+        i.add_item_batch(range(1000), [[random.gauss(0, 1) for z in xrange(f)] for j in xrange(1000)])
+        self.assertEqual(sorted(os.listdir("test_db")), ["shard.%d" % s for s in xrange(4)])
+        self.assertEqual(i.get_tree_stats(0)['items'], 1000)
+
+        j = AnnoyIndex(f, 10, "test_db", 4, 1000, 3048576000, 1, shards=4)
+        self.assertEqual(j.get_n_items(), 1000)
+        for k in xrange(10):
+            self.assertEqual(j.get_nns_by_item(k, 1), [k])
+        ids, dists = j.get_nns_by_item(0, 20, -1, True)
+        self.assertEqual(dists, sorted(dists))
+        del j
+
+        # the largest id + 1 over all shards, not the number of items
+        i.add_item(5000, [random.gauss(0, 1) for z in xrange(f)])
+        self.assertEqual(i.get_n_items(), 5001)
+
+    def test_swap(self):
+        print "test_swap "
+        os.system("rm -rf test_db test_db2")
+        os.system("mkdir test_db test_db2")
+        f = 10
+        for d, n in [("test_db", 500), ("test_db2", 1000)]:
+            i = AnnoyIndex(f, 10, d, 4, 1000, 3048576000, 0)
+            for j in xrange(n):
+                i.add_item(j, [random.gauss(0, 1) for z in xrange(f)])
+            del i
+
+        j = AnnoyIndex(f, 10, "test_db", 4, 1000, 3048576000, 1)
+        self.assertEqual(j.get_n_items(), 500)
+        failures = []
+        stop = []
+        def query():
+            while not stop:
+                if len(j.get_nns_by_vector([1] + [0] * (f - 1), 10)) != 10:
+                    failures.append(1)
+        readers = [threading.Thread(target=query) for r in xrange(4)]
+        for r in readers:
+            r.start()
+        self.assertFalse(j.swap("test_db"))
+        self.assertTrue(j.swap("test_db2", 4))
+        self.assertEqual(j.get_n_items(), 1000)
+        j.swap("test_db", 4, 0, 0, 1)
+        self.assertTrue(j.wait_swap())
+        stop.append(1)
+        for r in readers:
+            r.join()
+        self.assertEqual(failures, [])
+        self.assertEqual(j.get_n_items(), 500)
+        self.assertEqual(j.get_version(), 2)
+
+    def test_scatter_gather(self):
+        print "test_scatter_gather "
+        os.system("rm -rf test_db test_db2")
+        os.system("mkdir test_db test_db2")
+        f = 10
+        data = [[random.gauss(0, 1) for z in xrange(f)] for j in xrange(1000)]
+        for d, s in [("test_db", 0), ("test_db2", 1)]:
+            i = AnnoyIndex(f, 10, d, 4, 1000, 3048576000, 0)
+            for j in xrange(s, 1000, 2):
+                i.add_item(j, data[j])
+            del i
+
+        shards = [AnnoyIndex(f, 10, d, 4, 1000, 3048576000, 1) for d in ["test_db", "test_db2"]]
+        shards[0].serve("/tmp/annoy_test_0.sock")
+        shards[1].serve("/tmp/annoy_test_1.sock")
+        # the first replica of shard 0 is down
+        sg = ScatterGather(f, [["/tmp/annoy_test_none.sock", "/tmp/annoy_test_0.sock"],
+                               ["/tmp/annoy_test_1.sock"]], 20, 1000)
+        for j in xrange(10):
+            ids, dists = sg.get_nns_by_vector(data[j], 10, -1, 1)
+            self.assertEqual(ids[0], j)
+            self.assertEqual(dists, sorted(dists))
+            self.assertTrue(any(k % 2 == 0 for k in ids) and any(k % 2 == 1 for k in ids))
+        # tuples work as well as lists, anything else is refused
+        sg = ScatterGather(f, (("/tmp/annoy_test_0.sock",), ("/tmp/annoy_test_1.sock",)), 20, 1000)
+        self.assertEqual(sg.get_nns_by_vector(data[3], 1), [3])
+        self.assertRaises(TypeError, ScatterGather, f, [["/tmp/annoy_test_0.sock", 1]], 20, 1000)
+        self.assertRaises(TypeError, ScatterGather, f, ["/tmp/annoy_test_0.sock", 1], 20, 1000)
+        self.assertRaises(TypeError, ScatterGather, f, 1, 20, 1000)
+        shards[0].stop_serving()
+        shards[1].stop_serving()
+
+    def test_leaf_page_size(self):
+        print "test_leaf_page_size "
+        os.system("rm -rf test_db")
+        os.system("mkdir test_db")
+        f = 10
+        i = AnnoyIndex(f, 10, "test_db", 2, 1000, 3048576000, 0)
+        self.assertEqual(i.get_leaf_capacity(), 10)
+        self.assertEqual(i.set_leaf_page_size(4096), (4096 - 64) / (10 * 4 + 4))
+        for j in xrange(1000):
+            i.add_item(j, [random.gauss(0, 1) for z in xrange(f)])
+        self.assertTrue(i.get_tree_stats(0)['leaves'] < 100)
+        # int8 records are smaller, so more of them fit
+        i.set_codec(1)
+        self.assertEqual(i.get_leaf_capacity(), (4096 - 64) / (10 + 16 + 4))
+
+        j = AnnoyIndex(f, 10, "test_db", 2, 1000, 3048576000, 1)
+        self.assertEqual(j.get_leaf_capacity(), i.get_leaf_capacity())
+        self.assertEqual(j.get_nns_by_item(0, 1), [0])
+
+    def test_seed(self):
+        print "test_seed "
+        f = 10
+        data = [[random.gauss(0, 1) for z in xrange(f)] for j in xrange(500)]
+        stats = []
+        for r in xrange(2):
+            os.system("rm -rf test_db")
+            os.system("mkdir test_db")
+            i = AnnoyIndex(f, 10, "test_db", 4, 1000, 3048576000, 0)
+            i.set_seed(42)
+            if r == 1:
+                # the seed is kept in the index and restored on open
+                del i
+                i = AnnoyIndex(f, 10, "test_db", 4, 1000, 3048576000, 0)
+            for j in xrange(len(data)):
+                i.add_item(j, data[j])
+            stats.append([i.get_tree_stats(t) for t in xrange(4)])
+            stats.append(i.get_nns_by_vector(data[0], 10, 40))
+        self.assertEqual(stats[0], stats[2])
+        self.assertEqual(stats[1], stats[3])
+
+    def test_write_buffer(self):
+        print "test_write_buffer "
+        os.system("rm -rf test_db")
+        os.system("mkdir test_db")
+        f = 3
+        i = AnnoyIndex(f, 3, "test_db", 10, 1000, 3048576000, 0)
+        self.assertTrue(i.set_write_buffer(2, 0))
+        i.add_item(0, [0, 0, 1])
+        # buffered items are searched and read before they are flushed
+        self.assertEqual(i.get_n_items(), 1)
+        self.assertEqual(i.get_nns_by_vector([1, 2, 3], 1), [0])
+        numpy.testing.assert_array_almost_equal(i.get_item(0), [0, 0, 1])
+        i.add_item(1, [0, 1, 0])
+        i.add_item(2, [1, 0, 0])
+
+        self.assertEqual(i.get_nns_by_vector([3, 2, 1], 3), [2, 1, 0])
+        i.flush()
+        j = AnnoyIndex(f, 3, "test_db", 10, 1000, 3048576000, 1)
+        self.assertEqual(j.get_nns_by_vector([3, 2, 1], 3), [2, 1, 0])
+
+        # re-adding a stored item: only the buffered vector is found
+        i.add_item(2, [0, 0, 1])
+        ids, dists = i.get_nns_by_vector([0, 0, 1], 10, -1, True)
+        self.assertEqual(sorted(ids), [0, 1, 2])
+        self.assertEqual(sorted(ids[:2]), [0, 2])
+        self.assertAlmostEqual(dists[1], 0)
+
+    def test_group_commit(self):
+        print "test_group_commit "
+        os.system("rm -rf test_db")
+        os.system("mkdir test_db")
+        f = 3
+        i = AnnoyIndex(f, 3, "test_db", 10, 1000, 3048576000, 0)
+        i.set_durability(2)
+        i.set_group_commit(100, 1000)
+        i.add_item(0, [0, 0, 1])
+        i.add_item(1, [0, 1, 0])
+        i.add_item(2, [1, 0, 0])
+        # the group commits on flush, before it is full or due
+        i.flush()
+        j = AnnoyIndex(f, 3, "test_db", 10, 1000, 3048576000, 1)
+        self.assertEqual(j.get_n_items(), 3)
+        self.assertEqual(j.get_nns_by_vector([3, 2, 1], 3), [2, 1, 0])
+
+    def test_map_growth(self):
+        print "test_map_growth "
+        os.system("rm -rf test_db")
+        os.system("mkdir test_db")
+        f = 40
+        # a map far too small for the index grows as items are added
+        i = AnnoyIndex(f, 10, "test_db", 10, 1000, 1 << 20, 0)
+        for j in xrange(5000):
+            i.add_item(j, [random.gauss(0, 1) for z in xrange(f)])
+
+        usage = i.get_map_usage()
+        self.assertTrue(usage['map_size'] > 1 << 20)
+        self.assertTrue(usage['used_size'] <= usage['map_size'])
+        self.assertEqual(i.get_n_items(), 5000)
+
     def test_large_index(self):
         print "test_large_index"
         start_time = int(round(time.time() * 1000))
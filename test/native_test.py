@@ -0,0 +1,142 @@
+# Copyright (c) 2013 Spotify AB
+#
+# Licensed under the Apache License, Version 2.0 (the "License"); you may not
+# use this file except in compliance with the License. You may obtain a copy of
+# the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+# WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+# License for the specific language governing permissions and limitations under
+# the License.
+
+# Runs the native tools that make builds into build/native (see Makefile);
+# the tests of a tool not built are skipped.
+
+import unittest
+import json
+import random
+import os
+import signal
+import socket
+import struct
+import subprocess
+import time
+from annoy import AnnoyIndex
+try:
+    xrange
+except NameError:
+    # Python 3 compat
+    xrange = range
+
+native = os.environ.get('ANNOY_NATIVE',
+                        os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'build', 'native'))
+
+
+def tool(name):
+    return os.path.join(native, name)
+
+
+def build_index(path, f, n, trees):
+    os.system("rm -rf %s" % path)
+    os.system("mkdir %s" % path)
+    i = AnnoyIndex(f, 10, path, trees, 1000, 3048576000, 0)
+    data = [[random.gauss(0, 1) for z in xrange(f)] for j in xrange(n)]
+    for j in xrange(n):
+        i.add_item(j, data[j])
+    del i
+    return data
+
+
+def recv_all(s, size):
+    buf = b''
+    while len(buf) < size:
+        chunk = s.recv(size - len(buf))
+        if not chunk:
+            raise IOError('connection closed')
+        buf += chunk
+    return buf
+
+
+@unittest.skipUnless(os.path.exists(tool('annoy_server')), 'annoy_server is not built')
+class ServerTest(unittest.TestCase):
+    def test_start_query_stop(self):
+        print "test_start_query_stop "
+        f = 3
+        data = build_index('test_native_db', f, 100, 4)
+        path = os.path.abspath('test_native.sock')
+        server = subprocess.Popen([tool('annoy_server'), '-d', 'test_native_db', '-f', str(f), '-t', '4',
+                                   '-u', path, '-w', '2'], stdout=subprocess.PIPE)
+        try:
+            self.assertTrue(server.stdout.readline().startswith(b'serving'))
+            s = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+            s.connect(path)
+            # a query_header then count vectors, see annoyrpc.h
+            body = struct.pack('%df' % f, *data[7])
+            s.sendall(struct.pack('=IIIIIIi', 24 + len(body), 1, 42, f, 1, 3, -1) + body)
+            size, status, rid, count = struct.unpack('=IIII', recv_all(s, 16))
+            self.assertEqual((status, rid, count), (0, 42, 1))
+            reply = recv_all(s, size - 12)
+            m, = struct.unpack('=I', reply[:4])
+            self.assertEqual(m, 3)
+            ids = struct.unpack('=%di' % m, reply[4:4 + 4 * m])
+            self.assertEqual(ids[0], 7)
+            s.close()
+        finally:
+            server.send_signal(signal.SIGTERM)
+            self.assertEqual(server.wait(), 0)
+        self.assertFalse(os.path.exists(path))
+
+
+def write_fvecs(path, data):
+    with open(path, 'wb') as out:
+        for v in data:
+            out.write(struct.pack('=i%df' % len(v), len(v), *v))
+
+
+@unittest.skipUnless(os.path.exists(tool('annoy')), 'annoy is not built')
+class CliTest(unittest.TestCase):
+    def test_ingest_query(self):
+        print "test_ingest_query "
+        f, n = 5, 200
+        os.system("rm -rf test_native_db")
+        os.system("mkdir test_native_db")
+        data = [[random.gauss(0, 1) for z in xrange(f)] for j in xrange(n)]
+        write_fvecs('test_native.fvecs', data)
+        try:
+            subprocess.check_call([tool('annoy'), 'ingest', '-d', 'test_native_db', '-t', '4', '-s', '1000',
+                                   '-b', '64', 'test_native.fvecs'])
+            out = subprocess.check_output([tool('annoy'), 'query', '-d', 'test_native_db', '-t', '4',
+                                           '-n', '3', 'test_native.fvecs'])
+        finally:
+            os.remove('test_native.fvecs')
+        lines = out.decode().splitlines()
+        self.assertEqual(len(lines), n)
+        for j, line in enumerate(lines):
+            ids = [int(x) for x in line.split()]
+            self.assertEqual(len(ids), 3)
+            # row j was ingested as 1000 + j and is its own nearest neighbor
+            self.assertEqual(ids[0], 1000 + j)
+
+
+@unittest.skipUnless(os.path.exists(tool('annoy_bench')), 'annoy_bench is not built')
+class BenchTest(unittest.TestCase):
+    def test_json_output(self):
+        print "test_json_output "
+        os.system("rm -rf test_native_db")
+        out = subprocess.check_output([tool('annoy_bench'), '-d', 'test_native_db', '-f', '8', '-n', '300',
+                                       '-t', '2', '-K', '16', '-T', '0.01'])
+        doc = json.loads(out.decode())
+        self.assertEqual(doc['context']['dim'], 8)
+        self.assertEqual(doc['context']['items'], 300)
+        self.assertTrue(doc['benchmarks'])
+        for b in doc['benchmarks']:
+            self.assertTrue(b['name'])
+            self.assertTrue(b['iterations'] > 0)
+            self.assertTrue(b['ns_per_op'] >= 0)
+
+
+if __name__ == '__main__':
+    unittest.main()